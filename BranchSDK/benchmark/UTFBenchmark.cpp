@@ -0,0 +1,98 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+// Compares UTF::fromUTF8/toUTF8 with the std::wstring_convert conversion
+// StringUtils used before. Build with -DBRANCHIO_BUILD_BENCHMARKS=ON and run
+// utf_benchmark.
+
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <functional>
+#include <locale>
+#include <string>
+#include <vector>
+
+#include "BranchIO/Util/UTF.h"
+
+using namespace std;
+using namespace BranchIO;
+
+namespace {
+
+const int Iterations = 200000;
+
+/**
+ * @return the time per iteration in nanoseconds
+ */
+double
+measure(const function<size_t()>& body) {
+    size_t total = 0;
+    auto start = chrono::steady_clock::now();
+    for (int j = 0; j < Iterations; ++j) {
+        total += body();
+    }
+    auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    // Keep the result alive
+    if (total == 0) puts("");
+    return elapsed / Iterations;
+}
+
+void
+run(const char* name, const string& utf8) {
+    wstring wide;
+    UTF::fromUTF8(utf8, wide);
+
+    double codecvtFrom = measure([&]() {
+        wstring_convert<codecvt_utf8<wchar_t>> converter;
+        return converter.from_bytes(utf8).size();
+    });
+    double codecvtTo = measure([&]() {
+        wstring_convert<codecvt_utf8<wchar_t>> converter;
+        return converter.to_bytes(wide).size();
+    });
+
+    double stringFrom = measure([&]() {
+        wstring out;
+        UTF::fromUTF8(utf8, out);
+        return out.size();
+    });
+    double stringTo = measure([&]() {
+        string out;
+        UTF::toUTF8(wide, out);
+        return out.size();
+    });
+
+    vector<wchar_t> wideBuffer(utf8.size());
+    vector<char> narrowBuffer(UTF::maxUTF8Length<wchar_t>(wide.size()));
+    double bufferFrom = measure([&]() {
+        return UTF::fromUTF8(utf8.data(), utf8.size(), wideBuffer.data(), wideBuffer.size());
+    });
+    double bufferTo = measure([&]() {
+        return UTF::toUTF8(wide.data(), wide.size(), narrowBuffer.data(), narrowBuffer.size());
+    });
+
+    printf("%s (%zu bytes)\n", name, utf8.size());
+    printf("  %-22s %10s %10s\n", "", "from UTF-8", "to UTF-8");
+    printf("  %-22s %8.0f ns %8.0f ns\n", "wstring_convert", codecvtFrom, codecvtTo);
+    printf("  %-22s %8.0f ns %8.0f ns\n", "UTF, new string", stringFrom, stringTo);
+    printf("  %-22s %8.0f ns %8.0f ns\n", "UTF, reused buffer", bufferFrom, bufferTo);
+}
+
+}  // namespace
+
+int
+main() {
+    string json =
+        "{\"branch_key\":\"key_live_abcdefghijklmnopqrstuvwxyz\",\"identity_id\":\"742117473286461447\","
+        "\"event\":\"PURCHASE\",\"user_data\":{\"os\":\"Windows\",\"os_version\":\"10.0.19041\","
+        "\"model\":\"Surface Pro\",\"brand\":\"Microsoft\",\"sdk\":\"windows-cpp\",\"sdk_version\":\"1.2.0\"},"
+        "\"custom_data\":{\"product\":\"shoes\",\"color\":\"blue\",\"size\":\"42\"}}";
+    run("ASCII JSON", json);
+
+    string mixed;
+    for (int j = 0; j < 20; ++j) mixed += "Caf\xC3\xA9 \xE2\x82\xAC""12 ";
+    run("Mixed text", mixed);
+
+    run("Short log line", "Branch session started");
+    return 0;
+}
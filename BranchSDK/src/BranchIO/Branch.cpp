@@ -10,6 +10,8 @@ using namespace std;
 #include "BranchIO/Event/Event.h"
 #include "BranchIO/Event/SessionEvent.h"
 #include "BranchIO/IRequestCallback.h"
+#include "BranchIO/Util/ClientSessionFactory.h"
+#include "BranchIO/Util/LinkCache.h"
 #include "BranchIO/Util/Log.h"
 #include "BranchIO/SessionInfo.h"
 #include "BranchIO/Util/Storage.h"
@@ -109,7 +111,7 @@ class SessionCallback : public IRequestCallback {
 
 JSONObject Branch::requestMetaDataJsonObj = JSONObject();
 
-Branch *Branch::create(const String& branchKey, AppInfo* pInfo) {
+Branch *Branch::create(const String& branchKey, AppInfo* pInfo, const Configuration& configuration) {
     /*
      * For now, we should use user-level storage (~/.branchio on Unix,
      * HKEY_CURRENT_USER on Windows) to avoid permission issues. Some
@@ -167,7 +169,12 @@ Branch *Branch::create(const String& branchKey, AppInfo* pInfo) {
         instance->_packagingInfo.setRequestMetaData(requestMetaDataJsonObj);
     }
     
-    instance->_requestManager = new RequestManager(instance->_packagingInfo);
+    ClientSessionFactory::setDefaultConfiguration(configuration);
+    LinkCache::instance().setLimits(
+        configuration.getLinkCacheMaxEntries(),
+        chrono::milliseconds(configuration.getLinkCacheTTLMillis()));
+
+    instance->_requestManager = new RequestManager(instance->_packagingInfo, nullptr, configuration);
     instance->_requestManager->start();
 
     return instance;
@@ -188,7 +195,7 @@ Branch::openSession(const String& linkUrl, IRequestCallback* callback) {
         event.setLinkUrl(sLinkUrl);
     }
 
-    sendEvent(event, sessionCallback);
+    sendEvent(std::move(event), sessionCallback);
 }
 
 void
@@ -203,6 +210,21 @@ Branch::closeSession(IRequestCallback *callback) {
 
 void
 Branch::sendEvent(const BaseEvent &event, IRequestCallback *callback) {
+    sendEvent(BaseEvent(event), callback);
+}
+
+void
+Branch::sendEvent(std::unique_ptr<BaseEvent> event, IRequestCallback *callback) {
+    if (!event) {
+        BRANCH_LOG_W("Branch::sendEvent called with a NULL event.");
+        return;
+    }
+
+    sendEvent(std::move(*event), callback);
+}
+
+void
+Branch::sendEvent(BaseEvent &&event, IRequestCallback *callback) {
     // Only open events are enqueued with tracking disabled. All tracking info is stripped out
     // before transmission.
     if (getAdvertiserInfo().isTrackingDisabled() && event.getAPIEndpoint() != Defines::REGISTER_OPEN) {
@@ -213,7 +235,7 @@ Branch::sendEvent(const BaseEvent &event, IRequestCallback *callback) {
         return;
     }
 
-    getRequestManager()->enqueue(event, callback);
+    getRequestManager()->enqueue(std::move(event), callback);
 }
 
 void
@@ -3,12 +3,14 @@
 #ifndef BRANCHIO_BRANCH_H__
 #define BRANCHIO_BRANCH_H__
 
+#include <memory>
 #include <mutex>
 #include <string>
 
 #include "BranchIO/dll.h"
 #include "BranchIO/AdvertiserInfo.h"
 #include "BranchIO/AppInfo.h"
+#include "BranchIO/Configuration.h"
 #include "BranchIO/DeviceInfo.h"
 #include "BranchIO/Event/BaseEvent.h"
 #include "BranchIO/PackagingInfo.h"
@@ -39,9 +41,10 @@ class BRANCHIO_DLL_EXPORT Branch {
      * Caller is responsible for deletion.
      * @param branchKey Branch Application Key.
      * @param pInfo Application Information.
+     * @param configuration (optional) SDK configuration, e.g. request concurrency.
      * @return a new instance of Branch
      */
-    static Branch *create(const String& branchKey, AppInfo* pInfo);
+    static Branch *create(const String& branchKey, AppInfo* pInfo, const Configuration& configuration = Configuration());
 
     /**
      * Destructor.
@@ -69,6 +72,22 @@ class BRANCHIO_DLL_EXPORT Branch {
      */
     void sendEvent(const BaseEvent &event, IRequestCallback *callback);
 
+    /**
+     * Send an event to Branch. The event's properties are moved into the
+     * request instead of copied.
+     * @param event BaseEvent to send. Left empty.
+     * @param callback Callback to fire with success or failure notification.
+     */
+    void sendEvent(BaseEvent &&event, IRequestCallback *callback);
+
+    /**
+     * Send an event to Branch, taking ownership of it. The event's
+     * properties are moved into the request instead of copied.
+     * @param event BaseEvent to send. Ignored if NULL.
+     * @param callback Callback to fire with success or failure notification.
+     */
+    void sendEvent(std::unique_ptr<BaseEvent> event, IRequestCallback *callback);
+
     /*
      * @todo(jdee): Get rid of runtime getters for compile-time constants
      */
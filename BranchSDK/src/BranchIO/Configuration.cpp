@@ -0,0 +1,187 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "BranchIO/Configuration.h"
+
+#include <algorithm>
+
+namespace BranchIO {
+
+const unsigned int Configuration::DefaultRequestConcurrency = 1;
+const unsigned int Configuration::MaxRequestConcurrency = 16;
+const unsigned int Configuration::DefaultBatchMaxEvents = 1;
+const size_t Configuration::DefaultBatchMaxBytes = 64 * 1024;
+const unsigned int Configuration::DefaultBatchMaxAgeMillis = 5000;
+const unsigned int Configuration::DefaultEventQueueSyncCount = 32;
+const size_t Configuration::DefaultLinkCacheMaxEntries = 0;
+const unsigned int Configuration::DefaultLinkCacheTTLMillis = 60 * 60 * 1000;
+const unsigned int Configuration::DefaultEventTTLMillis = 0;
+const size_t Configuration::DefaultCompressionThreshold = 0;
+#if defined(BRANCHIO_USE_CURL) && !defined(_WIN32)
+const Configuration::HttpBackend Configuration::DefaultHttpBackend = Configuration::HttpBackendCurl;
+#else
+const Configuration::HttpBackend Configuration::DefaultHttpBackend = Configuration::HttpBackendWinRT;
+#endif  // BRANCHIO_USE_CURL && !_WIN32
+
+Configuration::Configuration() :
+    _requestConcurrency(DefaultRequestConcurrency),
+    _batchMaxEvents(DefaultBatchMaxEvents),
+    _batchMaxBytes(DefaultBatchMaxBytes),
+    _batchMaxAgeMillis(DefaultBatchMaxAgeMillis),
+    _eventQueueSyncCount(DefaultEventQueueSyncCount),
+    _linkCacheMaxEntries(DefaultLinkCacheMaxEntries),
+    _linkCacheTTLMillis(DefaultLinkCacheTTLMillis),
+    _eventTTLMillis(DefaultEventTTLMillis),
+    _httpBackend(DefaultHttpBackend),
+    _http2Enabled(false),
+    _compressionThreshold(DefaultCompressionThreshold) {
+}
+
+Configuration&
+Configuration::setRequestConcurrency(unsigned int concurrency) {
+    _requestConcurrency = std::clamp(concurrency, 1u, MaxRequestConcurrency);
+    return *this;
+}
+
+unsigned int
+Configuration::getRequestConcurrency() const {
+    return _requestConcurrency;
+}
+
+Configuration&
+Configuration::setBatchMaxEvents(unsigned int maxEvents) {
+    _batchMaxEvents = std::max(maxEvents, 1u);
+    return *this;
+}
+
+unsigned int
+Configuration::getBatchMaxEvents() const {
+    return _batchMaxEvents;
+}
+
+Configuration&
+Configuration::setBatchMaxBytes(size_t maxBytes) {
+    _batchMaxBytes = maxBytes;
+    return *this;
+}
+
+size_t
+Configuration::getBatchMaxBytes() const {
+    return _batchMaxBytes;
+}
+
+Configuration&
+Configuration::setBatchMaxAgeMillis(unsigned int maxAgeMillis) {
+    _batchMaxAgeMillis = maxAgeMillis;
+    return *this;
+}
+
+unsigned int
+Configuration::getBatchMaxAgeMillis() const {
+    return _batchMaxAgeMillis;
+}
+
+bool
+Configuration::isBatchingEnabled() const {
+    return _batchMaxEvents > 1;
+}
+
+Configuration&
+Configuration::setEventQueuePath(const std::wstring& path) {
+    _eventQueuePath = path;
+    return *this;
+}
+
+const std::wstring&
+Configuration::getEventQueuePath() const {
+    return _eventQueuePath;
+}
+
+Configuration&
+Configuration::setEventQueueSyncCount(unsigned int syncCount) {
+    _eventQueueSyncCount = std::max(syncCount, 1u);
+    return *this;
+}
+
+unsigned int
+Configuration::getEventQueueSyncCount() const {
+    return _eventQueueSyncCount;
+}
+
+Configuration&
+Configuration::setLinkCacheMaxEntries(size_t maxEntries) {
+    _linkCacheMaxEntries = maxEntries;
+    return *this;
+}
+
+size_t
+Configuration::getLinkCacheMaxEntries() const {
+    return _linkCacheMaxEntries;
+}
+
+Configuration&
+Configuration::setLinkCacheTTLMillis(unsigned int ttlMillis) {
+    _linkCacheTTLMillis = ttlMillis;
+    return *this;
+}
+
+unsigned int
+Configuration::getLinkCacheTTLMillis() const {
+    return _linkCacheTTLMillis;
+}
+
+Configuration&
+Configuration::setEventTTLMillis(unsigned int ttlMillis) {
+    _eventTTLMillis = ttlMillis;
+    return *this;
+}
+
+unsigned int
+Configuration::getEventTTLMillis() const {
+    return _eventTTLMillis;
+}
+
+Configuration&
+Configuration::setHttpBackend(HttpBackend backend) {
+    _httpBackend = backend;
+    return *this;
+}
+
+Configuration::HttpBackend
+Configuration::getHttpBackend() const {
+    return _httpBackend;
+}
+
+Configuration&
+Configuration::setApiUrlBase(const std::string& urlBase) {
+    _apiUrlBase = urlBase;
+    return *this;
+}
+
+const std::string&
+Configuration::getApiUrlBase() const {
+    return _apiUrlBase;
+}
+
+Configuration&
+Configuration::setHttp2Enabled(bool enabled) {
+    _http2Enabled = enabled;
+    return *this;
+}
+
+bool
+Configuration::isHttp2Enabled() const {
+    return _http2Enabled;
+}
+
+Configuration&
+Configuration::setCompressionThreshold(size_t minBytes) {
+    _compressionThreshold = minBytes;
+    return *this;
+}
+
+size_t
+Configuration::getCompressionThreshold() const {
+    return _compressionThreshold;
+}
+
+}  // namespace BranchIO
@@ -0,0 +1,284 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_CONFIGURATION_H__
+#define BRANCHIO_CONFIGURATION_H__
+
+#include <cstddef>
+#include <string>
+
+#include "BranchIO/dll.h"
+
+namespace BranchIO {
+
+/**
+ * Optional SDK configuration passed to Branch::create. All settings have
+ * defaults that match the behavior of Branch::create without a
+ * Configuration.
+ */
+class BRANCHIO_DLL_EXPORT Configuration {
+ public:
+    /**
+     * HTTP stack used to send requests to the Branch API.
+     */
+    enum HttpBackend {
+        /// Windows.Web.Http.HttpClient
+        HttpBackendWinRT,
+        /// libcurl. Only available when the SDK is built with BRANCHIO_USE_CURL.
+        HttpBackendCurl
+    };
+
+    /// Default number of request worker threads
+    static const unsigned int DefaultRequestConcurrency;
+
+    /// Maximum number of request worker threads
+    static const unsigned int MaxRequestConcurrency;
+
+    /// Default maximum number of events per batch (1 disables batching)
+    static const unsigned int DefaultBatchMaxEvents;
+
+    /// Default maximum approximate size of a batch in bytes
+    static const size_t DefaultBatchMaxBytes;
+
+    /// Default maximum time an event waits in a batch, in ms
+    static const unsigned int DefaultBatchMaxAgeMillis;
+
+    /// Default number of event queue records written between disk flushes
+    static const unsigned int DefaultEventQueueSyncCount;
+
+    /// Default maximum number of short links cached (0 disables the cache)
+    static const size_t DefaultLinkCacheMaxEntries;
+
+    /// Default time a cached short link is reused, in ms
+    static const unsigned int DefaultLinkCacheTTLMillis;
+
+    /// Default time an event may wait to be sent, in ms (0: no limit)
+    static const unsigned int DefaultEventTTLMillis;
+
+    /// Default minimum size of a request body to compress, in bytes (0: never)
+    static const size_t DefaultCompressionThreshold;
+
+    /// Default HTTP backend: curl when built with BRANCHIO_USE_CURL on other platforms than Windows, otherwise WinRT
+    static const HttpBackend DefaultHttpBackend;
+
+    /**
+     * Constructor.
+     */
+    Configuration();
+
+    /**
+     * Set the number of background threads used to send requests. Session
+     * requests such as opens are never sent in parallel with other
+     * requests, and requests queued after them are not sent before them.
+     * Events are otherwise sent in parallel when the concurrency is
+     * greater than 1. Values are clamped to the range
+     * [1, MaxRequestConcurrency].
+     * @param concurrency number of request worker threads
+     * @return This object for chaining builder methods
+     */
+    Configuration& setRequestConcurrency(unsigned int concurrency);
+
+    /**
+     * @return the number of request worker threads
+     */
+    unsigned int getRequestConcurrency() const;
+
+    /**
+     * Set the maximum number of events sent in a single batch request.
+     * Standard and custom events are then coalesced into one POST to the
+     * v2/event/batch endpoint, sharing one user_data block. The batch is
+     * sent when it reaches this many events, getBatchMaxBytes() or
+     * getBatchMaxAgeMillis(), whichever comes first. Requires server support
+     * for the batch endpoint. Defaults to 1, which disables batching.
+     * @param maxEvents maximum number of events per batch
+     * @return This object for chaining builder methods
+     */
+    Configuration& setBatchMaxEvents(unsigned int maxEvents);
+
+    /**
+     * @return the maximum number of events per batch
+     */
+    unsigned int getBatchMaxEvents() const;
+
+    /**
+     * Set the approximate maximum size of the event data in one batch.
+     * @param maxBytes maximum size in bytes
+     * @return This object for chaining builder methods
+     */
+    Configuration& setBatchMaxBytes(size_t maxBytes);
+
+    /**
+     * @return the approximate maximum size of a batch in bytes
+     */
+    size_t getBatchMaxBytes() const;
+
+    /**
+     * Set the maximum time the first event in a batch waits before the
+     * batch is sent.
+     * @param maxAgeMillis maximum age in ms
+     * @return This object for chaining builder methods
+     */
+    Configuration& setBatchMaxAgeMillis(unsigned int maxAgeMillis);
+
+    /**
+     * @return the maximum age of a batch in ms
+     */
+    unsigned int getBatchMaxAgeMillis() const;
+
+    /**
+     * @return true if event batching is enabled
+     */
+    bool isBatchingEnabled() const;
+
+    /**
+     * Set the path of a file used to keep events that have not been sent yet.
+     * Events are written to this file when they are queued and removed once
+     * they have been sent, so events pending when the app exits or crashes
+     * are sent the next time Branch::create is called. Session requests are
+     * not stored. Defaults to an empty path, which disables the queue file.
+     * @param path full path of the queue file
+     * @return This object for chaining builder methods
+     */
+    Configuration& setEventQueuePath(const std::wstring& path);
+
+    /**
+     * @return the path of the event queue file, or an empty string
+     */
+    const std::wstring& getEventQueuePath() const;
+
+    /**
+     * Set the number of records written to the event queue file between
+     * flushes to disk. Records are always written through to the operating
+     * system immediately, so this only affects durability on power loss.
+     * @param syncCount number of records between flushes
+     * @return This object for chaining builder methods
+     */
+    Configuration& setEventQueueSyncCount(unsigned int syncCount);
+
+    /**
+     * @return the number of records written between flushes to disk
+     */
+    unsigned int getEventQueueSyncCount() const;
+
+    /**
+     * Set the maximum number of short links kept in memory. A link created
+     * with the same parameters as a cached one is returned from the cache
+     * without a request. The least recently used link is dropped when the
+     * cache is full. Identical requests in progress at the same time are
+     * only sent once, even with the cache disabled. One-time links
+     * (LinkInfo::LINK_TYPE_ONE_TIME_USE) are never cached or shared.
+     * Defaults to 0, which disables the cache.
+     * @param maxEntries maximum number of cached links
+     * @return This object for chaining builder methods
+     */
+    Configuration& setLinkCacheMaxEntries(size_t maxEntries);
+
+    /**
+     * @return the maximum number of cached short links
+     */
+    size_t getLinkCacheMaxEntries() const;
+
+    /**
+     * Set how long a cached short link is reused.
+     * @param ttlMillis time to live in ms
+     * @return This object for chaining builder methods
+     */
+    Configuration& setLinkCacheTTLMillis(unsigned int ttlMillis);
+
+    /**
+     * @return the time to live of a cached short link in ms
+     */
+    unsigned int getLinkCacheTTLMillis() const;
+
+    /**
+     * Set how long an event may wait to be sent, for events queued without
+     * a deadline of their own (see BaseEvent::setTimeToLive). An event that
+     * is still queued or waiting to be retried after this time is dropped,
+     * and its callback's onError is called. 0 means no limit.
+     * @param ttlMillis time to live in ms
+     * @return This object for chaining builder methods
+     */
+    Configuration& setEventTTLMillis(unsigned int ttlMillis);
+
+    /**
+     * @return the default time to live of a queued event in ms, or 0 for no limit
+     */
+    unsigned int getEventTTLMillis() const;
+
+    /**
+     * Set the HTTP stack used to send requests. HttpBackendCurl falls back
+     * to HttpBackendWinRT with a warning if the SDK was built without
+     * BRANCHIO_USE_CURL.
+     * @param backend the HTTP backend
+     * @return This object for chaining builder methods
+     */
+    Configuration& setHttpBackend(HttpBackend backend);
+
+    /**
+     * @return the HTTP backend
+     */
+    HttpBackend getHttpBackend() const;
+
+    /**
+     * Set the base URL of the Branch API, e.g. to send requests to a local
+     * stand-in server for testing. Defaults to an empty string, which means
+     * the Branch API.
+     * @param urlBase base URL, e.g. "http://localhost:8080/"
+     * @return This object for chaining builder methods
+     */
+    Configuration& setApiUrlBase(const std::string& urlBase);
+
+    /**
+     * @return the base URL of the Branch API, or an empty string for the default
+     */
+    const std::string& getApiUrlBase() const;
+
+    /**
+     * Enable or disable HTTP/2. When enabled, requests are sent over HTTP/2
+     * if the server supports it, and concurrent requests share one
+     * connection as separate streams instead of each using a connection of
+     * its own. HTTP/1.1 is used otherwise. Disabled by default.
+     * @param enabled true to allow HTTP/2
+     * @return This object for chaining builder methods
+     */
+    Configuration& setHttp2Enabled(bool enabled);
+
+    /**
+     * @return true if HTTP/2 is allowed
+     */
+    bool isHttp2Enabled() const;
+
+    /**
+     * Set the size above which request bodies are sent gzip-compressed with
+     * Content-Encoding: gzip. Batched events compress several-fold, since
+     * every event repeats the same keys. A body is sent uncompressed if
+     * compression doesn't make it smaller. Requires server support for
+     * compressed requests. Defaults to 0, which disables compression.
+     * @param minBytes minimum body size in bytes, or 0 for never
+     * @return This object for chaining builder methods
+     */
+    Configuration& setCompressionThreshold(size_t minBytes);
+
+    /**
+     * @return the minimum size of a compressed request body in bytes, or 0 if compression is disabled
+     */
+    size_t getCompressionThreshold() const;
+
+ private:
+    unsigned int _requestConcurrency;
+    unsigned int _batchMaxEvents;
+    size_t _batchMaxBytes;
+    unsigned int _batchMaxAgeMillis;
+    std::wstring _eventQueuePath;
+    unsigned int _eventQueueSyncCount;
+    size_t _linkCacheMaxEntries;
+    unsigned int _linkCacheTTLMillis;
+    unsigned int _eventTTLMillis;
+    HttpBackend _httpBackend;
+    std::string _apiUrlBase;
+    bool _http2Enabled;
+    size_t _compressionThreshold;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_CONFIGURATION_H__
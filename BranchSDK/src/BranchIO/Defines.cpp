@@ -78,6 +78,7 @@ const char *PATH_APPLY_REFERRAL_CODE = "v1/applycode";
 const char *PATH_CONTENT_EVENT = "v1/content-events";
 const char *PATH_TRACK_STANDARD_EVENT = "v2/event/standard";
 const char *PATH_TRACK_CUSTOM_EVENT = "v2/event/custom";
+const char *PATH_TRACK_EVENT_BATCH = "v2/event/batch";
 
 const std::string
 Defines::stringify(APIEndpoint apiEndpoint) {
@@ -128,6 +129,9 @@ Defines::stringify(APIEndpoint apiEndpoint) {
         case TRACK_STANDARD_EVENT:
             ss << PATH_TRACK_STANDARD_EVENT;
             break;
+        case TRACK_EVENT_BATCH:
+            ss << PATH_TRACK_EVENT_BATCH;
+            break;
         case VALIDATE_REFERRAL_CODE:
             ss << PATH_VALIDATE_REFERRAL_CODE;
             break;
@@ -162,6 +166,7 @@ Defines::endpointType(APIEndpoint apiEndpoint) {
         case REDEEM_REWARDS:
         case TRACK_CUSTOM_EVENT:
         case TRACK_STANDARD_EVENT:
+        case TRACK_EVENT_BATCH:
         case VALIDATE_REFERRAL_CODE:
             apiType = V2;
             break;
@@ -100,6 +100,7 @@ class BRANCHIO_DLL_EXPORT Defines {
         CONTENT_EVENT,
         TRACK_STANDARD_EVENT,
         TRACK_CUSTOM_EVENT,
+        TRACK_EVENT_BATCH,
     } APIEndpoint;
 
     /**
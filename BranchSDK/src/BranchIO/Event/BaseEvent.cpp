@@ -8,13 +8,9 @@
 #include "BranchIO/JSONObject.h"
 #include "BranchIO/SessionInfo.h"
 #include "BranchIO/AdvertiserInfo.h"
-#include <winrt/Windows.Data.Json.h>
-#include <winrt/Windows.Foundation.Collections.h>
-#include "BranchIO/Util/Storage.h"
+#include "BranchIO/Util/EnvelopeCache.h"
 
 using namespace std;
-using namespace winrt::Windows::Data::Json;
-using namespace winrt::Windows::Foundation::Collections;
 
 namespace BranchIO {
 
@@ -26,21 +22,17 @@ static const char *JSONKEY_USER_DATA = "user_data";
 static const char *JSONKEY_BRANCH_KEY = "branch_key";
 static const char *JSONKEY_ADVERTISING_IDS = "advertising_ids";
 static const char* JSONKEY_REQUEST_METADATA = "metadata";
+static const char *JSONKEY_EVENTS = "events";
 
 BaseEvent::BaseEvent(Defines::APIEndpoint apiEndpoint, const String& eventName, JSONObject::Ptr jsonPtr) :
     mAPIEndpoint(apiEndpoint),
     mEventName(eventName.str()),
-    mResultHandler([](const JSONObject&) {}) {
+    mResultHandler([](const JSONObject&) {}),
+    mDeadline(Clock::time_point::max()) {
 
     if (jsonPtr.get()) {
         // Copy the key/values
-        IIterator<IKeyValuePair<winrt::hstring, IJsonValue>> it;
-        JsonObject sourceJObject = jsonPtr->getWinRTJsonObj();
-       
-        for (it = sourceJObject.First(); it.HasCurrent(); it.MoveNext()) {
-            IKeyValuePair< winrt::hstring, IJsonValue>  kvp = it.Current();
-            jObject.SetNamedValue(kvp.Key(), kvp.Value());
-        }
+        JSONObject::set(*jsonPtr);
     }
 }
 
@@ -49,7 +41,20 @@ BaseEvent::BaseEvent(const BaseEvent &other) :
     mAPIEndpoint(other.mAPIEndpoint),
     mEventName(other.mEventName),
     mCustomData(other.mCustomData),
-    mResultHandler(other.mResultHandler) {
+    mResultHandler(other.mResultHandler),
+    mDeadline(other.mDeadline) {
+}
+
+BaseEvent::BaseEvent(BaseEvent &&other) :
+    PropertyManager(std::move(other)),
+    mAPIEndpoint(other.mAPIEndpoint),
+    mEventName(std::move(other.mEventName)),
+    mCustomData(std::move(other.mCustomData)),
+    mResultHandler(std::move(other.mResultHandler)),
+    mDeadline(other.mDeadline) {
+    // Leave the other instance usable.
+    other.mCustomData = JSONObject();
+    other.mResultHandler = [](const JSONObject&) {};
 }
 
 BaseEvent::~BaseEvent() = default;
@@ -73,6 +78,41 @@ BaseEvent::addCustomDataProperty(const String &propertyName, const String &prope
     return *this;
 }
 
+BaseEvent&
+BaseEvent::setCustomData(const JSONObject& customData) {
+    scoped_lock _l(mMutex);
+    mCustomData = JSONObject::parse(customData.stringify());
+    return *this;
+}
+
+BaseEvent&
+BaseEvent::setDeadline(Clock::time_point deadline) {
+    scoped_lock _l(mMutex);
+    mDeadline = deadline;
+    return *this;
+}
+
+BaseEvent&
+BaseEvent::setTimeToLive(std::chrono::milliseconds ttl) {
+    return setDeadline(Clock::now() + ttl);
+}
+
+BaseEvent::Clock::time_point
+BaseEvent::getDeadline() const {
+    scoped_lock _l(mMutex);
+    return mDeadline;
+}
+
+bool
+BaseEvent::hasDeadline() const {
+    return getDeadline() != Clock::time_point::max();
+}
+
+bool
+BaseEvent::isExpired(Clock::time_point now) const {
+    return now >= getDeadline();
+}
+
 JSONObject
 BaseEvent::getCustomData() const {
     scoped_lock _l(mMutex);
@@ -117,7 +157,7 @@ BaseEvent::packageV1Event(IPackagingInfo &packagingInfo, JSONObject &jsonObject)
 }
 
 void
-BaseEvent::packageV2Event(IPackagingInfo &packagingInfo, JSONObject &jsonObject) const {
+BaseEvent::packageEventData(JSONObject &jsonObject) const {
     // Set the event name
     jsonObject.set(JSONKEY_NAME, name());
 
@@ -125,33 +165,33 @@ BaseEvent::packageV2Event(IPackagingInfo &packagingInfo, JSONObject &jsonObject)
     jsonObject.set(JSONKEY_EVENT_DATA, *this);
 
     // Set Custom Data (if any)
-    if (!getCustomData().isEmpty()) {
-        jsonObject.set(JSONKEY_CUSTOM_DATA, getCustomData());
+    JSONObject customData = getCustomData();
+    if (!customData.isEmpty()) {
+        jsonObject.set(JSONKEY_CUSTOM_DATA, customData);
     }
+}
 
-    // Set the user data
-    JSONObject userData;
-    JSONObject sessionInfo = packagingInfo.getSessionInfo().toJSON();
-    JSONObject deviceInfo = packagingInfo.getDeviceInfo().toJSON();
-    JSONObject appInfo = packagingInfo.getAppInfo().toJSON();
-    JSONObject adInfo = packagingInfo.getAdvertiserInfo().toJSON();
-
-    userData += sessionInfo;
-    userData += deviceInfo;
-    userData += appInfo;
-
-    // Advertising Ids
-    bool isAdTrackingLimited = packagingInfo.getAdvertiserInfo().isTrackingLimited();
-    if (!isAdTrackingLimited && adInfo.size() > 0) {
-        userData.set(JSONKEY_ADVERTISING_IDS, adInfo);
-    }
-    userData.set(Defines::JSONKEY_APP_LAT_V2, (isAdTrackingLimited ? 1 : 0));
+void
+BaseEvent::packageUserData(IPackagingInfo &packagingInfo, JSONObject &jsonPackage) {
+    // The user data is the same for every event until something changes, so
+    // splice in the cached serialized block.
+    static EnvelopeCache userDataCache;
+    jsonPackage.setRaw(JSONKEY_USER_DATA, userDataCache.getUserData(packagingInfo));
+}
 
-    std::string identity = Storage::instance().getString("session.identity");
-    if (!identity.empty())
-        userData.set(Defines::JSONKEY_APP_DEVELOPER_IDENTITY, identity);
+void
+BaseEvent::packageRequestMetaData(IPackagingInfo &packagingInfo, JSONObject &jsonPackage) {
+    JSONObject reqMetaData = packagingInfo.getRequestMetaData();
+    if (!reqMetaData.isEmpty())
+        jsonPackage.set(JSONKEY_REQUEST_METADATA, reqMetaData);
+}
+
+void
+BaseEvent::packageV2Event(IPackagingInfo &packagingInfo, JSONObject &jsonObject) const {
+    packageEventData(jsonObject);
 
-    jsonObject.set(JSONKEY_USER_DATA, userData);
+    // Set the user data
+    packageUserData(packagingInfo, jsonObject);
 }
 
 void
@@ -176,9 +216,31 @@ BaseEvent::package(IPackagingInfo &packagingInfo, JSONObject &jsonPackage) const
     }
 
     // Set Request MetaData
-    JSONObject reqMetaData = packagingInfo.getRequestMetaData();
-    if (!reqMetaData.isEmpty())
-        jsonPackage.set(JSONKEY_REQUEST_METADATA, reqMetaData);
+    packageRequestMetaData(packagingInfo, jsonPackage);
+}
+
+void
+BaseEvent::packageBatch(
+    IPackagingInfo &packagingInfo,
+    const std::vector<BaseEvent>& events,
+    JSONObject &jsonPackage) {
+    // Set the Branch Key
+    jsonPackage.set(JSONKEY_BRANCH_KEY, packagingInfo.getBranchKey());
+
+    // One user data block for the whole batch
+    packageUserData(packagingInfo, jsonPackage);
+
+    std::vector<JSONObject> eventList;
+    eventList.reserve(events.size());
+    for (const BaseEvent& event : events) {
+        JSONObject eventData;
+        event.packageEventData(eventData);
+        eventList.push_back(eventData);
+    }
+    jsonPackage.set(JSONKEY_EVENTS, eventList);
+
+    // Set Request MetaData
+    packageRequestMetaData(packagingInfo, jsonPackage);
 }
 
 
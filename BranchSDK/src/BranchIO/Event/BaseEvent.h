@@ -3,9 +3,11 @@
 #ifndef BRANCHIO_EVENT_BASEEVENT_H_
 #define BRANCHIO_EVENT_BASEEVENT_H_
 
+#include <chrono>
 #include <functional>
 #include <string>
 #include <mutex>
+#include <vector>
 #include "BranchIO/Defines.h"
 #include "BranchIO/fwd.h"
 #include "BranchIO/PropertyManager.h"
@@ -21,12 +23,23 @@ class BRANCHIO_DLL_EXPORT BaseEvent : public PropertyManager {
  public:
     using PropertyManager::toString;
 
+    /// Clock for event deadlines. A wall clock, so that deadlines of
+    /// persisted events still apply after a restart.
+    typedef std::chrono::system_clock Clock;
+
     /**
      * Copy constructor
      * @param other another instance to copy
      */
     BaseEvent(const BaseEvent& other);
 
+    /**
+     * Move constructor. Takes the properties, custom data and result
+     * handler of another instance without copying them.
+     * @param other another instance to move from
+     */
+    BaseEvent(BaseEvent&& other);
+
     virtual ~BaseEvent();
 
     /**
@@ -63,6 +76,19 @@ class BRANCHIO_DLL_EXPORT BaseEvent : public PropertyManager {
      */
     virtual void package(IPackagingInfo &packagingInfo, JSONObject &jsonPackage) const;
 
+    /**
+     * (Internal) Prepare a single package for a batch of V2 events. The package
+     * contains one user_data block shared by all events and an events array
+     * with the name, event_data and custom_data of each event.
+     * @param packagingInfo Context for packaging events
+     * @param events Events to package, in order
+     * @param jsonPackage result of the packaging process
+     */
+    static void packageBatch(
+        IPackagingInfo &packagingInfo,
+        const std::vector<BaseEvent>& events,
+        JSONObject &jsonPackage);
+
     /**
      * Set an optional function to be invoked on successful completion of the event. Defaults
      * to a no-op.
@@ -75,6 +101,39 @@ class BRANCHIO_DLL_EXPORT BaseEvent : public PropertyManager {
         return *this;
     }
 
+    /**
+     * Set the time after which this event is no longer worth sending. If
+     * it has not been sent by then, it is dropped and the callback's
+     * onError is called. By default an event has no deadline.
+     * @param deadline time after which the event expires
+     * @return *this
+     */
+    BaseEvent& setDeadline(Clock::time_point deadline);
+
+    /**
+     * Set the deadline relative to now. See setDeadline().
+     * @param ttl how long the event may wait to be sent
+     * @return *this
+     */
+    BaseEvent& setTimeToLive(std::chrono::milliseconds ttl);
+
+    /**
+     * @return the deadline for sending this event, or Clock::time_point::max() if none
+     */
+    Clock::time_point getDeadline() const;
+
+    /**
+     * @return true if a deadline has been set
+     */
+    bool hasDeadline() const;
+
+    /**
+     * Determine if this event's deadline has passed.
+     * @param now the current time
+     * @return true if the event has expired
+     */
+    bool isExpired(Clock::time_point now = Clock::now()) const;
+
     /**
      * Invoke the result handler for this event
      * @param result the result to pass to the handler
@@ -109,12 +168,23 @@ class BRANCHIO_DLL_EXPORT BaseEvent : public PropertyManager {
      */
     BaseEvent& addEventProperty(const char *propertyName, double propertyValue);
 
+    /**
+     * Replace the custom data properties associated with this Branch Event.
+     * @param customData Custom data properties
+     * @return this object for chaining builder methods
+     */
+    BaseEvent& setCustomData(const JSONObject& customData);
+
  private:
     BaseEvent();
 
     void packageRawEvent(JSONObject &jsonObject) const;
     void packageV1Event(IPackagingInfo &branch, JSONObject &jsonObject) const;
     void packageV2Event(IPackagingInfo &branch, JSONObject &jsonObject) const;
+    void packageEventData(JSONObject &jsonObject) const;
+
+    static void packageUserData(IPackagingInfo &packagingInfo, JSONObject &jsonPackage);
+    static void packageRequestMetaData(IPackagingInfo &packagingInfo, JSONObject &jsonPackage);
 
  private:
     std::mutex mutable mMutex;
@@ -130,6 +200,9 @@ class BRANCHIO_DLL_EXPORT BaseEvent : public PropertyManager {
 
     // Result callback
     std::function<void(const JSONObject&)> mResultHandler;
+
+    // Deadline for sending this event
+    Clock::time_point mDeadline;
 };
 
 }  // namespace BranchIO
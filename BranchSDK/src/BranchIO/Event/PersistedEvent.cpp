@@ -0,0 +1,114 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "BranchIO/Event/PersistedEvent.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include "BranchIO/JSONObject.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+namespace {
+
+// Version 2 adds the deadline. Version 1 records are still read.
+const uint8_t FormatVersion = 2;
+
+void appendField(string& buffer, const string& field) {
+    uint32_t length = static_cast<uint32_t>(field.size());
+    buffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    buffer.append(field);
+}
+
+bool readField(const string& buffer, size_t& offset, string& field) {
+    uint32_t length;
+    if (buffer.size() - offset < sizeof(length)) return false;
+    memcpy(&length, buffer.data() + offset, sizeof(length));
+    offset += sizeof(length);
+
+    if (buffer.size() - offset < length) return false;
+    field = buffer.substr(offset, length);
+    offset += length;
+    return true;
+}
+
+}  // namespace
+
+PersistedEvent::PersistedEvent(
+    Defines::APIEndpoint apiEndpoint,
+    const String& eventName,
+    JSONObject::Ptr eventData,
+    const JSONObject& customData) :
+    BaseEvent(apiEndpoint, eventName, eventData) {
+    if (!customData.isEmpty()) {
+        setCustomData(customData);
+    }
+}
+
+std::string
+PersistedEvent::serialize(const BaseEvent& event) {
+    string payload;
+    payload.push_back(static_cast<char>(FormatVersion));
+
+    uint32_t endpoint = static_cast<uint32_t>(event.getAPIEndpoint());
+    payload.append(reinterpret_cast<const char*>(&endpoint), sizeof(endpoint));
+
+    appendField(payload, event.name());
+    appendField(payload, event.toString());
+    appendField(payload, event.getCustomData().stringify());
+
+    // ms since the epoch, or 0 for no deadline
+    int64_t deadline = 0;
+    if (event.hasDeadline()) {
+        deadline = chrono::duration_cast<chrono::milliseconds>(event.getDeadline().time_since_epoch()).count();
+    }
+    payload.append(reinterpret_cast<const char*>(&deadline), sizeof(deadline));
+
+    return payload;
+}
+
+std::unique_ptr<PersistedEvent>
+PersistedEvent::deserialize(const std::string& payload) {
+    uint32_t endpoint;
+    uint8_t version = payload.empty() ? 0 : static_cast<uint8_t>(payload[0]);
+    if (payload.size() < 1 + sizeof(endpoint) || version < 1 || version > FormatVersion) {
+        return nullptr;
+    }
+    memcpy(&endpoint, payload.data() + 1, sizeof(endpoint));
+    if (endpoint > Defines::TRACK_EVENT_BATCH) return nullptr;
+
+    size_t offset = 1 + sizeof(endpoint);
+    string name, eventData, customData;
+    if (!readField(payload, offset, name) ||
+        !readField(payload, offset, eventData) ||
+        !readField(payload, offset, customData)) {
+        return nullptr;
+    }
+
+    int64_t deadline = 0;
+    if (version >= 2) {
+        if (payload.size() - offset < sizeof(deadline)) return nullptr;
+        memcpy(&deadline, payload.data() + offset, sizeof(deadline));
+    }
+
+    try {
+        JSONObject::Ptr eventDataPtr(new JSONObject(JSONObject::parse(eventData)));
+        unique_ptr<PersistedEvent> event(new PersistedEvent(
+            static_cast<Defines::APIEndpoint>(endpoint),
+            name,
+            eventDataPtr,
+            JSONObject::parse(customData)));
+        if (deadline) {
+            event->setDeadline(Clock::time_point(chrono::milliseconds(deadline)));
+        }
+        return event;
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+}  // namespace BranchIO
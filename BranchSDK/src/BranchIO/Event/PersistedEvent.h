@@ -0,0 +1,45 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_EVENT_PERSISTEDEVENT_H__
+#define BRANCHIO_EVENT_PERSISTEDEVENT_H__
+
+#include <memory>
+#include <string>
+
+#include "BranchIO/Event/BaseEvent.h"
+
+namespace BranchIO {
+
+/**
+ * (Internal) An event restored from the durable event queue.
+ *
+ * Events are stored with their endpoint, name, event data, custom data and
+ * deadline, and packaged again when they are sent.
+ */
+class PersistedEvent : public BaseEvent {
+ public:
+    /**
+     * Serialize an event for storage.
+     * @param event Event to serialize
+     * @return the serialized event
+     */
+    static std::string serialize(const BaseEvent& event);
+
+    /**
+     * Restore an event from the result of serialize().
+     * @param payload serialized event
+     * @return the event, or NULL if the payload is not valid
+     */
+    static std::unique_ptr<PersistedEvent> deserialize(const std::string& payload);
+
+ private:
+    PersistedEvent(
+        Defines::APIEndpoint apiEndpoint,
+        const String& eventName,
+        JSONObject::Ptr eventData,
+        const JSONObject& customData);
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_EVENT_PERSISTEDEVENT_H__
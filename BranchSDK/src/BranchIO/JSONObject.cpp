@@ -1,38 +1,42 @@
 // Copyright (c) 2019-21 Branch Metrics, Inc.
 
 #include "BranchIO/JSONObject.h"
-#include "Util/StringUtils.h"
+#include "Util/JSONValue.h"
 
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include "Util/StringUtils.h"
+#endif  // _WIN32
 
 using namespace std;
-using namespace winrt;
-using namespace winrt::Windows::Data::Json;
-using namespace winrt::Windows::Foundation::Collections;
 
 namespace BranchIO {
 
-JSONObject::JSONObject() {
-    jObject = JsonObject();
+JSONObject::JSONObject() : _object(make_shared<JSONObjectData>()) {
 }
 
-JSONObject::JSONObject(const JsonObject& object){
-        jObject = object;
+#ifdef _WIN32
+JSONObject::JSONObject(const winrt::Windows::Data::Json::JsonObject& object) :
+    _object(JSONValue::parseObject(StringUtils::wstring_to_utf8(object.Stringify().c_str()))) {
 }
+#endif  // _WIN32
 
 bool
 JSONObject::isEmpty() const {
-    return jObject.Size() == 0;
+    return _object->members.empty();
 }
 
 JSONObject
 JSONObject::parse(const std::string& jsonString) {
-    if (jsonString.empty())
-        return NULL;
-    // Can throw Exception
-     JsonObject obj = JsonObject::Parse(to_hstring(jsonString));
-     return JSONObject(obj);
+    JSONObject object;
+    if (!jsonString.empty()) {
+        // Can throw std::invalid_argument
+        object._object = JSONValue::parseObject(jsonString);
+    }
+    return object;
 }
 
 JSONObject
@@ -50,80 +54,109 @@ JSONObject::load(const std::string& path) {
 
 std::string
 JSONObject::stringify() const {
-    winrt::hstring s = jObject.Stringify();
-    return StringUtils::wstring_to_utf8(s.c_str());
+    string s;
+    _object->write(s);
+    return s;
+}
+
+void
+JSONObject::stringify(std::string& out) const {
+    out.clear();
+    _object->write(out);
 }
 
 JSONObject &
 JSONObject::operator += (const JSONObject &rhs) {
-
-    IIterator<IKeyValuePair<winrt::hstring, IJsonValue>> it;
-     for (it = rhs.jObject.First(); it.HasCurrent(); it.MoveNext()) {
-        IKeyValuePair< winrt::hstring, IJsonValue>  kvp = it.Current();
-        jObject.SetNamedValue(kvp.Key(), kvp.Value());
-    }
+    set(rhs);
     return *this;
 }
 
 void JSONObject::set(const std::string& key, const std::string& value){
-    JsonValue objValue = JsonValue::CreateStringValue(to_hstring(value));
-    jObject.SetNamedValue(to_hstring(key), objValue);
+    _object->set(key, JSONValue(value));
 }
 
 void JSONObject::set(const std::string& key, const int& value){
-    JsonValue objValue = JsonValue::CreateNumberValue(value);
-    jObject.SetNamedValue(to_hstring(key), objValue);
+    _object->set(key, JSONValue(static_cast<double>(value)));
 }
 
 void JSONObject::set(const std::string& key, const double& value) {
-    JsonValue objValue = JsonValue::CreateNumberValue(value);
-    jObject.SetNamedValue(to_hstring(key), objValue);
+    _object->set(key, JSONValue(value));
 }
 
 void JSONObject::set(const std::string& key, const JSONObject value) const{
-    const JsonObject obj = value.getWinRTJsonObj();
-    jObject.SetNamedValue(to_hstring(key), obj);
+    // Copied, so that later changes to value don't show up here, and an
+    // object can't end up containing itself.
+    _object->set(key, JSONValue(value._object->clone()));
 }
 
 void JSONObject::set(const std::string& key, const std::vector<std::string> value) const {
-    winrt::Windows::Data::Json::JsonArray arr;
-    for each (std::string str in value) {
-        arr.Append(JsonValue::CreateStringValue(to_hstring(str)));
+    auto arr = make_shared<JSONArrayData>();
+    arr->reserve(value.size());
+    for (const std::string& str : value) {
+        arr->emplace_back(str);
+    }
+    _object->set(key, JSONValue(arr));
+}
+
+void JSONObject::set(const std::string& key, const std::vector<JSONObject>& value) const {
+    auto arr = make_shared<JSONArrayData>();
+    arr->reserve(value.size());
+    for (const JSONObject& obj : value) {
+        arr->emplace_back(obj._object->clone());
     }
-    jObject.SetNamedValue(to_hstring(key), arr);
+    _object->set(key, JSONValue(arr));
 }
 
 void JSONObject::set(const JSONObject& jsonObject) const {
-    IIterator<IKeyValuePair<winrt::hstring, IJsonValue>> it;
-    for (it = jsonObject.jObject.First(); it.HasCurrent(); it.MoveNext()) {
-        IKeyValuePair< winrt::hstring, IJsonValue>  kvp = it.Current();
-        jObject.SetNamedValue(kvp.Key(), kvp.Value());
+    if (jsonObject._object == _object) return;
+
+    // Copy first, in case the object is nested in this one.
+    auto members = jsonObject._object->clone()->members;
+    for (auto& member : members) {
+        _object->set(member.first, std::move(member.second));
     }
 }
 
+void JSONObject::setRaw(const std::string& key, std::shared_ptr<const std::string> json) const {
+    _object->set(key, JSONValue(std::move(json)));
+}
+
 std::string JSONObject::getNamedString(std::string const& name) const{
-    winrt::hstring hStrValue = jObject.GetNamedString(to_hstring(name));
-    return StringUtils::wstring_to_utf8(hStrValue.c_str());
+    const JSONValue* value = _object->find(name);
+    if (!value || value->getType() != JSONValue::StringValue) {
+        throw invalid_argument("No string value for " + name);
+    }
+    return value->getString();
+}
+
+double JSONObject::getNamedNumber(std::string const& name) const{
+    const JSONValue* value = _object->find(name);
+    if (!value || value->getType() != JSONValue::NumberValue) {
+        throw invalid_argument("No number value for " + name);
+    }
+    return value->getNumber();
 }
 
 void JSONObject::clear() const{
-    jObject.Clear();
+    _object->members.clear();
 }
 
 bool JSONObject::has(const std::string& key) const {
-    return jObject.HasKey(to_hstring(key));
+    return _object->find(key) != nullptr;
 }
 
 void JSONObject::remove(const std::string& key){
-    jObject.Remove(to_hstring(key));
+    _object->remove(key);
 }
 
-const JsonObject JSONObject::getWinRTJsonObj() const{
-    return jObject;
+#ifdef _WIN32
+const winrt::Windows::Data::Json::JsonObject JSONObject::getWinRTJsonObj() const{
+    return winrt::Windows::Data::Json::JsonObject::Parse(winrt::to_hstring(stringify()));
 }
+#endif  // _WIN32
 
 const uint32_t JSONObject::size() const {
-    return jObject.Size() ;
+    return static_cast<uint32_t>(_object->members.size());
 }
 
 }  // namespace BranchIO
@@ -5,30 +5,42 @@
 
 #define _WINSOCKAPI_  
 
+#include <cstdint>
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <vector>
 #include "BranchIO/dll.h"
+
+#ifdef _WIN32
 #include <winrt/Windows.Data.Json.h>
 #include <winrt/Windows.Foundation.Collections.h>
-
-
+#endif  // _WIN32
 
 namespace BranchIO {
 
 class PropertyManager;
+struct JSONObjectData;
+
 /**
  * A representation of a JSON Object.
+ *
+ * Values are held in a native UTF-8 representation. As with
+ * the WinRT JsonObject, copies of a JSONObject refer to the same
+ * underlying object.
  */
 class BRANCHIO_DLL_EXPORT JSONObject  {
  public:
 
      JSONObject();
 
+#ifdef _WIN32
      /**
-     * Initializes a JSONObject with the WinRT JsonObject.
+     * Initializes a JSONObject with the contents of a WinRT JsonObject.
      * @param object a JSON object to copy
      */
      JSONObject(const winrt::Windows::Data::Json::JsonObject& object);
+#endif  // _WIN32
 
     /**
      * Pointer to JSONObject*
@@ -38,8 +50,8 @@ class BRANCHIO_DLL_EXPORT JSONObject  {
     /**
      * Parse a JSON formatted string.
      * @param jsonString JSON formatted string
-     * @return a new JSONObject.
-     * @throw winrt::hresult_error in case of parse failure.
+     * @return a new JSONObject. Empty if jsonString is empty.
+     * @throw std::invalid_argument in case of parse failure.
      */
     static JSONObject parse(const std::string& jsonString);
 
@@ -47,7 +59,7 @@ class BRANCHIO_DLL_EXPORT JSONObject  {
      * Parse a JSON formatted stream.
      * @param s JSON formatted stream
      * @return a new JSONObject Ptr.
-     * @throw winrt::hresult_error in case of parse failure.
+     * @throw std::invalid_argument in case of parse failure.
      */
     static JSONObject parse(std::istream& s);
 
@@ -56,7 +68,7 @@ class BRANCHIO_DLL_EXPORT JSONObject  {
      * @param path file path to load
      * @return a JSONObject containing the contents of the file
      * @throw std::runtime_error in case of failure to read the file
-     * @throw winrt::hresult_error in case of parse failure.
+     * @throw std::invalid_argument in case of parse failure.
      */
     static JSONObject load(const std::string& path);
 
@@ -72,6 +84,14 @@ class BRANCHIO_DLL_EXPORT JSONObject  {
      */
     std::string stringify() const;
 
+    /**
+     * Write the string representation into a buffer, replacing its
+     * contents. The buffer's capacity is kept, so a buffer reused for each
+     * request stops allocating once it has grown to the largest payload.
+     * @param out the buffer
+     */
+    void stringify(std::string& out) const;
+
     /**
      * Operator +=
      * @param rhs Other to combine with this object.
@@ -82,6 +102,7 @@ class BRANCHIO_DLL_EXPORT JSONObject  {
 
     /**
      *  set(Overloaded versions) - sets values for the specified key in the JSON Object.
+     *  Objects are copied, so later changes to value are not seen here.
      * @param key Key
      * @param value Value 
      */
@@ -90,15 +111,33 @@ class BRANCHIO_DLL_EXPORT JSONObject  {
     void set(const std::string& key, const double& value);
     void set(const std::string& key, const JSONObject value) const;
     void set(const std::string& key, const std::vector<std::string> value) const;
+    void set(const std::string& key, const std::vector<JSONObject>& value) const;
     void set(const JSONObject& jsonObject) const;
 
+    /**
+     * (Internal) Set a value from pre-serialized JSON text, which is written
+     * verbatim by stringify(). The text is shared rather than copied.
+     * @param key Key
+     * @param json valid JSON text for a single value
+     */
+    void setRaw(const std::string& key, std::shared_ptr<const std::string> json) const;
+
     /**
     * getNamedString - Gets the String value with the specified name(key) in the JSON Object.
     * @param name - The name/key
     * @return string value for the key
+    * @throw std::invalid_argument if there is no string value for the key
     */
     std::string getNamedString(std::string const& name) const;
 
+    /**
+    * getNamedNumber - Gets the number value with the specified name(key) in the JSON Object.
+    * @param name - The name/key
+    * @return number value for the key
+    * @throw std::invalid_argument if there is no number value for the key
+    */
+    double getNamedNumber(std::string const& name) const;
+
     /**
     * has - Indicates whether the JsonObject has an entry with the requested key.
     * @param key - The key
@@ -112,12 +151,15 @@ class BRANCHIO_DLL_EXPORT JSONObject  {
     */
     void remove(const std::string& key);
     
+#ifdef _WIN32
     /**
-    * getWinRTJsonObj - Returns the encapsulated WinRT JsonObject.
-    * @return encapsulated WinRT JsonObject
+    * getWinRTJsonObj - Returns a WinRT JsonObject with the contents of this object.
+    * Changes to the returned object are not reflected in this one.
+    * @return WinRT JsonObject
     */
     const winrt::Windows::Data::Json::JsonObject getWinRTJsonObj() const;
-    
+#endif  // _WIN32
+
     /**
     * size - Gets the number of items in the JSON Object.
     * @return number of items
@@ -130,7 +172,7 @@ class BRANCHIO_DLL_EXPORT JSONObject  {
     void clear() const;
 
 protected:
-    winrt::Windows::Data::Json::JsonObject jObject;
+    std::shared_ptr<JSONObjectData> _object;
 };
 
 }  // namespace BranchIO
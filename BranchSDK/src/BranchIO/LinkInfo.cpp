@@ -1,11 +1,17 @@
 // Copyright (c) 2019-21 Branch Metrics, Inc.
 
 #include "BranchIO/LinkInfo.h"
-#include "BranchIO/Util/APIClientSession.h"
 #include "BranchIO/Branch.h"
 #include "BranchIO/Defines.h"
+#include "BranchIO/Util/ClientSessionFactory.h"
+#include "BranchIO/Util/Executor.h"
+#include "BranchIO/Util/LinkCache.h"
 #include "BranchIO/Util/Log.h"
 #include "BranchIO/Util/StringUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <stdexcept>
 #include <winrt/Windows.Foundation.h>
 
 using namespace std;
@@ -26,10 +32,368 @@ const char* const JSONKEY_CAMPAIGN = "campaign";
 const char* const JSONKEY_DATA = "data";
 const char* const JSONKEY_URL = "url";
 
+// Connections kept open to the API for link requests
+const unsigned LINK_SESSION_MAX_CONNECTIONS = 4;
+
+/**
+ * The client session shared by all link requests, so connections are
+ * reused. Never destroyed, since WinRT objects can't safely be released
+ * during static destruction.
+ */
+static IClientSession&
+getLinkSession() {
+    static IClientSession* session = ClientSessionFactory::create(LINK_SESSION_MAX_CONNECTIONS).release();
+    return *session;
+}
+
+namespace {
+
+/**
+ * Passes the result of a link request to a std::promise.
+ */
+class PromiseCallback : public virtual IRequestCallback {
+ public:
+    std::future<std::string> getFuture() {
+        return _promise.get_future();
+    }
+
+    void onSuccess(int id, JSONObject jsonResponse) {
+        try {
+            _promise.set_value(jsonResponse.getNamedString(JSONKEY_URL));
+        }
+        catch (std::invalid_argument&) {
+            _promise.set_exception(make_exception_ptr(runtime_error("No URL in response")));
+        }
+    }
+
+    void onError(int id, int error, std::string description) {
+        _promise.set_exception(make_exception_ptr(runtime_error(description)));
+    }
+
+    void onStatus(int id, int error, std::string description) {
+        onError(id, error, description);
+    }
+
+ private:
+    std::promise<std::string> _promise;
+};
+
+}  // namespace
+
+struct LinkInfo::UrlRequest : public virtual IRequestCallback, public std::enable_shared_from_this<UrlRequest> {
+    UrlRequest(
+        IRequestCallback* callback,
+        std::unique_ptr<IRequestCallback> ownedCallback,
+        const std::string& longUrl,
+        const JSONObject& payload,
+        IClientSession* clientSession,
+        const std::string& cacheKey) :
+        _complete(false),
+        _canceled(false),
+        _callback(callback),
+        _ownedCallback(std::move(ownedCallback)),
+        _longUrl(longUrl),
+        _payload(payload),
+        _clientSession(clientSession),
+        _cacheKey(cacheKey) {
+    }
+
+    bool isComplete() const {
+        scoped_lock _l(_mutex);
+        return _complete;
+    }
+
+    bool isCanceled() const {
+        scoped_lock _l(_mutex);
+        return _canceled;
+    }
+
+    void waitTillComplete() const {
+        unique_lock<mutex> _l(_mutex);
+        while (!_complete && !_canceled) {
+            _completeCondition.wait(_l);
+        }
+    }
+
+    void cancel() {
+        scoped_lock _l(_mutex);
+        _canceled = true;
+        _callback = nullptr;
+        _completeCondition.notify_all();
+
+        // Only a session set for this LinkInfo can be stopped. The shared
+        // session keeps running; its result is just ignored.
+        if (_clientSession) _clientSession->stop();
+    }
+
+    void run() {
+        bool isLeader = false;
+        if (!_cacheKey.empty() && !isCanceled()) {
+            string url;
+            auto self(shared_from_this());
+            auto waiter = [self](LinkCache::Status status, const std::string* url) { self->onCacheResult(status, url); };
+            switch (LinkCache::instance().acquire(_cacheKey, url, waiter)) {
+                case LinkCache::Hit:
+                    BRANCH_LOG_D("Short link found in cache");
+                    finish(&url);
+                    return;
+                case LinkCache::Joined:
+                    // onCacheResult() is called when the identical request completes.
+                    BRANCH_LOG_D("Waiting for identical /v1/url POST");
+                    return;
+                case LinkCache::Leader:
+                    isLeader = true;
+                    break;
+            }
+        }
+
+        lead(isLeader);
+    }
+
+    /**
+     * Send the request and pass the result to the link cache.
+     * @param isLeader true if this request is the leader for its cache key
+     */
+    void lead(bool isLeader) {
+        post();
+
+        if (isLeader) {
+            if (isCanceled()) {
+                // Requests that joined this one don't fail with it.
+                LinkCache::instance().abandon(_cacheKey);
+            } else {
+                string shortUrl(getShortUrl());
+                LinkCache::instance().complete(_cacheKey, shortUrl.empty() ? nullptr : &shortUrl);
+            }
+        }
+
+        markComplete();
+    }
+
+    void post() {
+        try {
+            BRANCH_LOG_D("Starting /v1/url POST");
+
+            if (!isCanceled()) {
+                IClientSession& clientSession = (_clientSession ? *_clientSession : getLinkSession());
+                JSONObject result;
+                clientSession.post("/v1/url", _payload, *this, result);
+            }
+        }
+        catch (winrt::hresult_error const& ex) {
+            // WinRT Exceptions
+            BRANCH_LOG_E("Exception in LinkInfo request [" << ex.code() << "]: " << ex.message().c_str());
+        }
+        catch (std::exception& e) {
+            // Other STL exceptions
+            BRANCH_LOG_E("Exception in LinkInfo request: " << e.what());
+        }
+        catch (...) {
+            // Anything else
+            BRANCH_LOG_E("Unexpected exception in LinkInfo request.");
+        }
+
+        // Does nothing if the session already called back.
+        onError(0, 0, "Request failed");
+
+        BRANCH_LOG_D("Finished /v1/url POST");
+    }
+
+    /**
+     * Called by the link cache when the identical request this one joined
+     * is finished.
+     * @param status Hit with the result, or Leader if the identical request
+     *        was canceled and this one must be sent instead
+     * @param url the short URL, or NULL
+     */
+    void onCacheResult(LinkCache::Status status, const std::string* url) {
+        if (status == LinkCache::Leader) {
+            BRANCH_LOG_D("Identical /v1/url POST canceled. Sending this one.");
+            auto self(shared_from_this());
+            Executor::submit([self] { self->lead(true); });
+        } else {
+            finish(url);
+        }
+    }
+
+    /**
+     * Complete with a result from the link cache.
+     * @param url the short URL, or NULL to fall back to the long URL
+     */
+    void finish(const std::string* url) {
+        if (url) {
+            JSONObject response;
+            response.set(JSONKEY_URL, *url);
+            onSuccess(0, response);
+        } else {
+            onError(0, 0, "Request failed");
+        }
+
+        markComplete();
+    }
+
+    void onSuccess(int id, JSONObject jsonResponse) {
+        if (jsonResponse.has(JSONKEY_URL)) {
+            scoped_lock _l(_mutex);
+            try {
+                _shortUrl = jsonResponse.getNamedString(JSONKEY_URL);
+            }
+            catch (std::invalid_argument&) {
+            }
+        }
+
+        auto callback = takeCallback();
+        if (!callback) return;
+
+        callback->onSuccess(id, jsonResponse);
+    }
+
+    void onError(int id, int error, std::string description) {
+        auto callback = takeCallback();
+        if (!callback) return;
+
+        // Attempt to create a Long Link
+        BRANCH_LOG_D("Fallback and create a long link");
+
+        if (_longUrl.empty()) {
+            // This is an actual failure.
+            callback->onError(id, error, description);
+        } else {
+            JSONObject jsonObject;
+            jsonObject.set(JSONKEY_URL, _longUrl);
+
+            callback->onSuccess(id, jsonObject);
+        }
+    }
+
+    void onStatus(int id, int error, std::string description) {
+        /*
+         * onStatus is called for transient errors. Give up and create
+         * a long link on the first error.
+         */
+        onError(id, error, description);
+    }
+
+    IRequestCallback* getCallback() const {
+        scoped_lock _l(_mutex);
+        return _callback;
+    }
+
+ private:
+    void markComplete() {
+        scoped_lock _l(_mutex);
+        _complete = true;
+        _completeCondition.notify_all();
+    }
+
+    /**
+     * @return the URL returned by the API, or an empty string if the
+     * request failed
+     */
+    std::string getShortUrl() const {
+        scoped_lock _l(_mutex);
+        return _shortUrl;
+    }
+
+    /**
+     * @return the callback, the first time this is called. Each request
+     * calls back exactly once.
+     */
+    IRequestCallback* takeCallback() {
+        scoped_lock _l(_mutex);
+        IRequestCallback* callback = _callback;
+        _callback = nullptr;
+        return callback;
+    }
+
+    std::mutex mutable _mutex;
+    std::condition_variable mutable _completeCondition;
+    bool _complete;
+    bool _canceled;
+    IRequestCallback* _callback;
+    std::unique_ptr<IRequestCallback> _ownedCallback;
+    const std::string _longUrl;
+    const JSONObject _payload;
+    IClientSession* const _clientSession;
+    // Empty if the link cache isn't used
+    const std::string _cacheKey;
+    std::string _shortUrl;
+};
+
+struct LinkInfo::UrlBatch {
+    /**
+     * Stores the URL for one link in the batch.
+     */
+    class ItemCallback : public virtual IRequestCallback {
+     public:
+        ItemCallback(const std::shared_ptr<UrlBatch>& batch, size_t index) :
+            _batch(batch),
+            _index(index) {
+        }
+
+        void onSuccess(int id, JSONObject jsonResponse) {
+            string url;
+            try {
+                url = jsonResponse.getNamedString(JSONKEY_URL);
+            }
+            catch (std::invalid_argument&) {
+            }
+            _batch->setUrl(_index, url);
+        }
+
+        void onError(int id, int error, std::string description) {
+            // Only without a long URL, which needs just the Branch key.
+            _batch->setUrl(_index, string());
+        }
+
+        void onStatus(int id, int error, std::string description) {
+            onError(id, error, description);
+        }
+
+     private:
+        const std::shared_ptr<UrlBatch> _batch;
+        const size_t _index;
+    };
+
+    explicit UrlBatch(size_t size) :
+        _next(0),
+        _remaining(size),
+        _urls(size),
+        _requests(size) {
+    }
+
+    /**
+     * Run requests until there are none left to start. A request that joins
+     * an identical one in progress completes later, on another thread.
+     */
+    void run() {
+        for (size_t index = _next++; index < _requests.size(); index = _next++) {
+            // The request refers to this batch through its callback, so
+            // don't keep a reference back to it.
+            std::shared_ptr<UrlRequest> request;
+            request.swap(_requests[index]);
+            if (request) request->run();
+        }
+    }
+
+    void setUrl(size_t index, const std::string& url) {
+        scoped_lock _l(_mutex);
+        _urls[index] = url;
+        if (-- _remaining == 0) {
+            _promise.set_value(std::move(_urls));
+        }
+    }
+
+    std::atomic<size_t> _next;
+    std::promise<std::vector<std::string>> _promise;
+    std::mutex _mutex;
+    size_t _remaining;
+    std::vector<std::string> _urls;
+    std::vector<std::shared_ptr<UrlRequest>> _requests;
+};
+
 LinkInfo::LinkInfo()
     : BaseEvent(Defines::APIEndpoint::URL, "LinkInfo"),
-    _complete(true),
-    _canceled(false),
     _callback(nullptr),
     _branch(nullptr),
     _clientSession(nullptr) {
@@ -39,41 +403,34 @@ LinkInfo::~LinkInfo() {
     waitTillComplete();
 }
 
+std::shared_ptr<LinkInfo::UrlRequest>
+LinkInfo::getRequest() const {
+    scoped_lock _l(_mutex);
+    return _request;
+}
+
 bool
 LinkInfo::isComplete() const {
-    scoped_lock _l(_mutex);
-    return _complete;
+    auto request = getRequest();
+    return !request || request->isComplete();
 }
 
 bool
 LinkInfo::isCanceled() const {
-    scoped_lock _l(_mutex);
-    return _canceled;
+    auto request = getRequest();
+    return request && request->isCanceled();
 }
 
 void
 LinkInfo::waitTillComplete() const {
-
-    unique_lock<mutex> _l(_mutex);
-    while (!_complete) {
-        _completeCondition.wait(_l);
-    }
-}
-
-void
-LinkInfo::complete() {
-    scoped_lock _l(_mutex);
-    _complete = true;
-    _completeCondition.notify_all();
+    auto request = getRequest();
+    if (request) request->waitTillComplete();
 }
 
 void
 LinkInfo::cancel() {
-    scoped_lock _l(_mutex);
-    _canceled = true;
-
-    if (!_clientSession) return;
-    _clientSession->stop();
+    auto request = getRequest();
+    if (request) request->cancel();
 }
 
 void
@@ -90,8 +447,8 @@ LinkInfo::getClientSession() const {
 
 IRequestCallback*
 LinkInfo::getCallback() const {
-    scoped_lock _l(_mutex);
-    return _callback;
+    auto request = getRequest();
+    return request ? request->getCallback() : nullptr;
 }
 
 Branch*
@@ -204,18 +561,103 @@ LinkInfo::createUrl(Branch *branchInstance, IRequestCallback *callback) {
         return;
     }
 
+    startRequest(branchInstance, callback, nullptr);
+}
+
+std::future<std::string>
+LinkInfo::createUrl(Branch *branchInstance) {
+    auto callback = make_unique<PromiseCallback>();
+    auto future = callback->getFuture();
+
+    if (branchInstance == NULL || branchInstance->getBranchKey().empty()) {
+        callback->onError(0, 0, "Invalid Branch Instance");
+        return future;
+    }
+
+    IRequestCallback* callbackPtr = callback.get();
+    startRequest(branchInstance, callbackPtr, std::move(callback));
+    return future;
+}
+
+std::future<std::vector<std::string>>
+LinkInfo::createUrls(Branch *branchInstance, const std::vector<LinkInfo*>& links) {
+    auto batch = make_shared<UrlBatch>(links.size());
+    auto future = batch->_promise.get_future();
+
+    if (branchInstance == NULL || branchInstance->getBranchKey().empty()) {
+        batch->_promise.set_exception(make_exception_ptr(runtime_error("Invalid Branch Instance")));
+        return future;
+    }
+
+    if (links.empty()) {
+        batch->_promise.set_value(std::vector<std::string>());
+        return future;
+    }
+
+    for (size_t index = 0; index < links.size(); ++index) {
+        auto callback = make_unique<UrlBatch::ItemCallback>(batch, index);
+        if (!links[index]) {
+            callback->onError(0, 0, "No link");
+            continue;
+        }
+
+        IRequestCallback* callbackPtr = callback.get();
+        batch->_requests[index] = links[index]->makeRequest(branchInstance, callbackPtr, std::move(callback));
+    }
+
+    // Bounded like the connections of the shared session
+    size_t workers = min<size_t>(links.size(), LINK_SESSION_MAX_CONNECTIONS);
+    for (size_t j = 0; j < workers; ++j) {
+        Executor::submit([batch] { batch->run(); });
+    }
+
+    return future;
+}
+
+void
+LinkInfo::startRequest(
+    Branch* branchInstance,
+    IRequestCallback* callback,
+    std::unique_ptr<IRequestCallback> ownedCallback) {
+    // One request at a time per LinkInfo
+    waitTillComplete();
+
+    auto request = makeRequest(branchInstance, callback, std::move(ownedCallback));
     {
         scoped_lock _l(_mutex);
-        _complete = false;
+        _request = request;
         _branch = branchInstance;
         _callback = callback;
     }
 
-    /*
-     * Start a thread to make the request. Executes LinkInfo::run().
-     */
-    _thread = thread([this] { this->run(); });
-    _thread.join();
+    Executor::submit([request] { request->run(); });
+}
+
+std::shared_ptr<LinkInfo::UrlRequest>
+LinkInfo::makeRequest(
+    Branch* branchInstance,
+    IRequestCallback* callback,
+    std::unique_ptr<IRequestCallback> ownedCallback) const {
+    // Build the JSON payload and the fallback long URL now, so the request
+    // doesn't refer back to this object.
+    JSONObject payload(JSONObject::parse(PropertyManager::toString()));
+    payload.set("branch_key", branchInstance->getBranchKey());
+    string longUrl(createLongUrl(branchInstance));
+
+    // Links are only cached for the shared session. A session set with
+    // setClientSession() always sees the request. A one-time link must not
+    // be handed to more than one caller.
+    IClientSession* clientSession = getClientSession();
+    bool oneTimeUse = false;
+    try {
+        oneTimeUse = payload.has(JSONKEY_TYPE) && payload.getNamedNumber(JSONKEY_TYPE) == LINK_TYPE_ONE_TIME_USE;
+    }
+    catch (std::invalid_argument&) {
+    }
+    string cacheKey(clientSession || oneTimeUse ? string() : LinkCache::makeKey(payload));
+
+    return make_shared<UrlRequest>(
+        callback, std::move(ownedCallback), longUrl, payload, clientSession, cacheKey);
 }
 
 std::string
@@ -292,102 +734,26 @@ LinkInfo::doAddProperty(const char *name, int value) {
 
 void
 LinkInfo::onSuccess(int id, JSONObject response) {
-    auto callback = getCallback();
-    if (!callback) return;
-
-    callback->onSuccess(id, response);
+    auto request = getRequest();
+    if (request) request->onSuccess(id, response);
 }
 
 void
 LinkInfo::onStatus(int id, int error, std::string description) {
-    /*
-     * onStatus is called for transient errors. Give up and create
-     * a long link on the first error.
-     */
-    onError(id, error, description);
+    auto request = getRequest();
+    if (request) request->onStatus(id, error, description);
 }
 
 void
 LinkInfo::onError(int id, int error, std::string description) {
-    auto callback = getCallback();
-    if (!callback) return;
-
-    // Attempt to create a Long Link
-    BRANCH_LOG_D("Fallback and create a long link");
-
-    auto longUrl = createLongUrl(_branch);
-
-    if (longUrl.empty()) {
-        // This is an actual failure.
-        callback->onError(id, error, description);
-    } else {
-        JSONObject jsonObject;
-        jsonObject.set(JSONKEY_URL, longUrl);
-
-        callback->onSuccess(id, jsonObject);
-    }
+    auto request = getRequest();
+    if (request) request->onError(id, error, description);
 }
 
 void
 LinkInfo::run() {
-    /*
-     * Ensure that complete() is called no matter how we exit this frame.
-     */
-    struct Completer {
-        Completer(LinkInfo& object, void (LinkInfo::* method)()) : _object(object), _method(method) {}
-        ~Completer() {
-            // Thread exiting, unblock destructor.
-            BRANCH_LOG_D("Terminating thread for /v1/url POST");
-            (_object.*_method)();
-        }
-        LinkInfo& _object;
-        void (LinkInfo::* _method)();
-    } completer(*this, &LinkInfo::complete);
-
-    try {
-        BRANCH_LOG_D("Starting thread for /v1/url POST");
-        /**
-         * Make /v1/url request synchronously with APIClientSession
-         */
-
-        // @todo(jdee): Untangle constant handling in this SDK.
-
-        // 1. Build JSON payload using key & identity from Branch instance.
-        JSONObject payload(*this);
-        auto branch = getBranchInstance();
-        payload.set("branch_key", branch->getBranchKey());
-
-        auto clientSession = getClientSession();
-        // 2. POST & call back
-        JSONObject result;
-        if (clientSession) {
-            // Use in unit tests.
-            clientSession->post("/v1/url", payload, *this, result);
-        } else {
-            APIClientSession apiClientSession(BRANCH_IO_URL_BASE);
-
-            // Check before a blocking socket operation
-            if (isCanceled()) return;
-
-            // synchronous call but calls callback. blocks till callback invoked.
-            setClientSession(&apiClientSession);
-            // blocking socket write & read
-            apiClientSession.post("/v1/url", payload, *this, result);
-            setClientSession(nullptr);
-        }
-    }
-    catch (winrt::hresult_error const& ex) {
-        // WinRT Exceptions
-        BRANCH_LOG_E("Exception in LinkInfo thread [" << ex.code() << "]: " << ex.message().c_str());
-    }
-    catch (std::exception& e) {
-        // Other STL exceptions
-        BRANCH_LOG_E("Exception in LinkInfo thread: " << e.what());
-    }
-    catch (...) {
-        // Anything else
-        BRANCH_LOG_E("Unexpected exception in LinkInfo thread.");
-    }
+    auto request = getRequest();
+    if (request) request->run();
 }
 
 }  // namespace BranchIO
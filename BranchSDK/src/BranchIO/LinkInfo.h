@@ -3,7 +3,10 @@
 #ifndef BRANCHIO_LINKINFO_H__
 #define BRANCHIO_LINKINFO_H__
 
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
 #include "BranchIO/Event/BaseEvent.h"
 #include "BranchIO/IRequestCallback.h"
 #include "BranchIO/fwd.h"
@@ -39,6 +42,7 @@ class BRANCHIO_DLL_EXPORT LinkInfo :
 
     /**
      * Destructor. Blocks until request is complete or canceled.
+     * After cancel(), returns immediately.
      */
     ~LinkInfo();
 
@@ -145,13 +149,43 @@ class BRANCHIO_DLL_EXPORT LinkInfo :
 
     /**
      * Create a Branch Url with the given deep link parameters and link properties.
+     * Returns immediately. The request runs on a shared thread pool and the
+     * callback is called from a pool thread when it completes.
      * Note that this will "fall back" to generating a Long URL on error.
      * Note that if the callback is null, no request will be made.
+     * If a previous request from this object is still in progress, this
+     * waits for it to complete first.
      * @param branchInstance Branch Instance
      * @param callback Callback to fire with success or failure notification.
      */
     void createUrl(Branch *branchInstance, IRequestCallback *callback);
 
+    /**
+     * Create a Branch Url with the given deep link parameters and link properties.
+     * Returns immediately. The request runs on a shared thread pool.
+     * Note that this will "fall back" to generating a Long URL on error.
+     * @param branchInstance Branch Instance
+     * @return a future for the URL. Holds a std::runtime_error if no URL
+     *         could be created, or std::future_error if the request is canceled.
+     */
+    std::future<std::string> createUrl(Branch *branchInstance);
+
+    /**
+     * Create Branch Urls for a list of links. Returns immediately. The
+     * requests run on a shared thread pool, a few at a time.
+     * Each link "falls back" to a Long URL on error, so there is a URL
+     * for every link.
+     * The links are read before this returns and may then be changed or
+     * destroyed.
+     * @param branchInstance Branch Instance
+     * @param links the links to create
+     * @return a future for the URLs, in the same order as links. Holds a
+     *         std::runtime_error if the Branch Instance is invalid.
+     */
+    static std::future<std::vector<std::string>> createUrls(
+        Branch *branchInstance,
+        const std::vector<LinkInfo*>& links);
+
     /**
      * Create a long Url with the given deep link parameters and link properties.
      * Note that this does not require an active network connection.
@@ -209,7 +243,7 @@ class BRANCHIO_DLL_EXPORT LinkInfo :
     void onStatus(int id, int error, std::string description);
 
     /**
-     * Execute the URL request. 
+     * Execute the current URL request on the calling thread.
      */
     void run();
 
@@ -258,21 +292,37 @@ class BRANCHIO_DLL_EXPORT LinkInfo :
      void appendQueryParameters(std::string& query, const char* tag, std::string value) const;
 
  private:
+    /**
+     * State of one createUrl() call, shared with the thread pool task so that
+     * the task can finish safely after a canceled LinkInfo is destroyed.
+     */
+    struct UrlRequest;
+
+    /**
+     * State of one createUrls() call.
+     */
+    struct UrlBatch;
+
     std::string getAlias() const;
     std::string getCampaign() const;
     std::string getChannel() const;
     std::string getFeature() const;
     std::string getStage() const;
-    void complete();
+    std::shared_ptr<UrlRequest> getRequest() const;
+    std::shared_ptr<UrlRequest> makeRequest(
+        Branch* branchInstance,
+        IRequestCallback* callback,
+        std::unique_ptr<IRequestCallback> ownedCallback) const;
+    void startRequest(
+        Branch* branchInstance,
+        IRequestCallback* callback,
+        std::unique_ptr<IRequestCallback> ownedCallback);
 
  private:
     std::mutex mutable _mutex;
-    std::condition_variable mutable _completeCondition;
-    std::thread _thread;
-    bool volatile _complete;
-    bool volatile _canceled;
     PropertyManager _controlParams;
     std::vector<std::string> _tagParams;
+    std::shared_ptr<UrlRequest> _request;
 
     // Store values passed to createUrl() for fallback handling.
     IRequestCallback* volatile _callback;
@@ -4,30 +4,82 @@
 #include "BranchIO/JSONObject.h"
 #include "BranchIO/Util/Storage.h"
 #include "BranchIO/String.h"
+#include "BranchIO/Util/JSONValue.h"
+
+#include <atomic>
 
 using namespace std;
 
 namespace BranchIO {
 
-PropertyManager::PropertyManager() {
+static uint64_t
+nextVersion() {
+    static atomic<uint64_t> versionCounter(0);
+    return ++ versionCounter;
+}
+
+PropertyManager::PropertyManager() : _version(nextVersion()) {
 }
 
 PropertyManager::PropertyManager(const JSONObject &jsonObject)
-    : JSONObject(jsonObject) {
+    : JSONObject(jsonObject), _version(nextVersion()) {
 }
 
+// Copies share the properties and their version stamp until one of them
+// is modified. See touch().
 PropertyManager::PropertyManager(const PropertyManager &other)
-    : JSONObject(other) {
+    : PropertyManager(other.snapshot()) {
+}
+
+PropertyManager::PropertyManager(Snapshot&& snapshot)
+    : JSONObject(std::move(snapshot.properties)), _version(snapshot.version) {
+}
+
+// The properties keep their version stamp. The other instance is empty
+// now, so it gets a new one.
+PropertyManager::PropertyManager(PropertyManager &&other)
+    : JSONObject(std::move(other)), _version(other._version) {
+    static_cast<JSONObject&>(other) = JSONObject();
+    other._version = nextVersion();
 }
 
 PropertyManager&
 PropertyManager::operator=(const PropertyManager& other) {
-    return static_cast<PropertyManager&>(JSONObject::operator=(other));
+    if (&other == this) return *this;
+
+    Snapshot copy(other.snapshot());
+    scoped_lock _l(_mutex);
+
+    JSONObject::operator=(copy.properties);
+    _version = copy.version;
+    return *this;
+}
+
+PropertyManager::Snapshot
+PropertyManager::snapshot() const {
+    scoped_lock _l(_mutex);
+    return Snapshot{ *this, _version };
+}
+
+void
+PropertyManager::touch() {
+    // Copies made before this keep the old properties.
+    if (_object.use_count() > 1) {
+        _object = make_shared<JSONObjectData>(*_object);
+    }
+    _version = nextVersion();
+}
+
+uint64_t
+PropertyManager::getVersion() const {
+    scoped_lock _l(_mutex);
+    return _version;
 }
 
 PropertyManager&
 PropertyManager::addProperty(const String& name, const String& value) {
     scoped_lock _l(_mutex);
+    touch();
 
     string utf8Name(name.str());
     string utf8Val(value.str());
@@ -42,6 +94,7 @@ PropertyManager::addProperty(const String& name, const String& value) {
 PropertyManager&
 PropertyManager::addProperty(const String& name, int value) {
     scoped_lock _l(_mutex);
+    touch();
 
     set(name.str(), value);
     return *this;
@@ -50,6 +103,7 @@ PropertyManager::addProperty(const String& name, int value) {
 PropertyManager&
 PropertyManager::addProperty(const String& name, double value) {
     scoped_lock _l(_mutex);
+    touch();
 
     set(name.str(), value);
     return *this;
@@ -58,6 +112,7 @@ PropertyManager::addProperty(const String& name, double value) {
 PropertyManager&
 PropertyManager::addProperty(const String& name, const PropertyManager &value) {
     scoped_lock _l(_mutex);
+    touch();
 
     set(name.str(), value);
     return *this;
@@ -66,6 +121,7 @@ PropertyManager::addProperty(const String& name, const PropertyManager &value) {
 PropertyManager&
 PropertyManager::addProperty(const String& name, const vector<string> &value) {
     scoped_lock _l(_mutex);
+    touch();
 
     set(name.str(), value);
     return *this;
@@ -74,6 +130,7 @@ PropertyManager::addProperty(const String& name, const vector<string> &value) {
 PropertyManager&
 PropertyManager::addProperties(const JSONObject &jsonObject) {
     scoped_lock _l(_mutex);
+    touch();
     set(jsonObject);
     return *this;
 }
@@ -81,6 +138,7 @@ PropertyManager::addProperties(const JSONObject &jsonObject) {
 PropertyManager&
 PropertyManager::clear() {
     scoped_lock _l(_mutex);
+    touch();
 
     JSONObject::clear();
     return *this;
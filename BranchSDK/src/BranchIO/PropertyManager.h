@@ -6,6 +6,7 @@
 #include "BranchIO/Util/IStringConvertible.h"
 #include "BranchIO/JSONObject.h"
 #include "BranchIO/String.h"
+#include <cstdint>
 #include <string>
 #include <mutex>
 
@@ -28,11 +29,20 @@ class BRANCHIO_DLL_EXPORT PropertyManager : protected JSONObject, public virtual
     PropertyManager(const JSONObject &jsonObject); // NOLINT We want this conversion operator
 
     /**
-     * Copy constructor
+     * Copy constructor. The copy shares the properties, and their version
+     * stamp, with the other instance until either one is modified. Copying
+     * does not copy the properties.
      * @param other another PropertyManager instance to copy
      */
     PropertyManager(const PropertyManager& other);
 
+    /**
+     * Move constructor. Takes the properties of another PropertyManager
+     * without copying them. The other instance is left empty.
+     * @param other another PropertyManager instance to move from
+     */
+    PropertyManager(PropertyManager&& other);
+
     /**
      * Assignment operator
      * @param other another PropertyManager
@@ -129,6 +139,14 @@ class BRANCHIO_DLL_EXPORT PropertyManager : protected JSONObject, public virtual
      */
     virtual bool isEmpty() const;
 
+    /**
+     * A stamp that changes whenever the properties are modified through this
+     * class. Stamps are unique across all instances, so an unchanged stamp
+     * means the same properties, even if the instance has been replaced.
+     * @return the current version stamp
+     */
+    uint64_t getVersion() const;
+
  protected:
     /**
      * Generate a path suitable for use as a complex key.
@@ -140,7 +158,34 @@ class BRANCHIO_DLL_EXPORT PropertyManager : protected JSONObject, public virtual
     static std::string getPath(const std::string& base, const std::string &key);
 
  private:
+    /**
+     * The properties and version stamp of an instance, read together.
+     */
+    struct Snapshot {
+        JSONObject properties;
+        uint64_t version;
+    };
+
+    /**
+     * Constructor.
+     * @param snapshot properties and version stamp to share
+     */
+    explicit PropertyManager(Snapshot&& snapshot);
+
+    /**
+     * @return the properties and version stamp of this instance
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * Mark the properties as about to be modified. Takes a private copy of
+     * them first if they are shared with a copy of this instance. Call with
+     * _mutex held, before modifying them.
+     */
+    void touch();
+
     mutable std::mutex _mutex;
+    uint64_t _version;
 };
 
 }  // namespace BranchIO
@@ -16,57 +16,132 @@ namespace BranchIO {
 
 int const Request::MaxAttemptCount = 5;
 int32_t const Request::MaxBackoffMillis = 120000;
+int32_t const Request::MaxRetryAfterMillis = 3600000;
+
+Request::Request() :
+    _attemptCount(0),
+    _canceled(false),
+    _retryPending(false),
+    _lastBackoffMillis(0),
+    _backoffPolicy(&BackoffPolicy::getDefault()),
+    _deadline(std::chrono::system_clock::time_point::max()),
+    _circuitBreaker(CircuitBreaker::instance()),
+    _retryBudget(RetryBudget::instance()) {
+}
 
-Request::Request() : _attemptCount(0), _canceled(false) { }
+Request::Request(CircuitBreaker& circuitBreaker, RetryBudget& retryBudget) :
+    _attemptCount(0),
+    _canceled(false),
+    _retryPending(false),
+    _lastBackoffMillis(0),
+    _backoffPolicy(&BackoffPolicy::getDefault()),
+    _deadline(std::chrono::system_clock::time_point::max()),
+    _circuitBreaker(circuitBreaker),
+    _retryBudget(retryBudget) {
+}
 
 JSONObject Request::send(
     Defines::APIEndpoint api,
     const JSONObject& jsonPayload,
     IRequestCallback &callback,
     IClientSession *clientSession) {
+    JSONObject result;
+    for (int32_t wait = attempt(api, jsonPayload, callback, clientSession, result);
+        wait > 0;
+        wait = attempt(api, jsonPayload, callback, clientSession, result)) {
+        _sleeper.sleep(wait);
+    }
+    return result;
+}
 
-    string uri(Defines::stringify(api));
+int32_t
+Request::attempt(
+    Defines::APIEndpoint api,
+    const JSONObject& jsonPayload,
+    IRequestCallback &callback,
+    IClientSession *clientSession,
+    JSONObject& result) {
     std::string path(Defines::stringify(api));
     if (path.empty()) {
         path = "/";
     }
 
-    JSONObject result;
-    while (!isCanceled() && getAttemptCount() < MaxAttemptCount) {
-        // POST the request
-        if (clientSession->post(path, jsonPayload, callback, result)) {
-            break;
+    if (!isCanceled() && isExpired()) {
+        BRANCH_LOG_W("Request expired.");
+        callback.onError(0, 0, "Request expired.");
+        return 0;
+    }
+
+    if (!isCanceled() && getAttemptCount() < MaxAttemptCount) {
+        // Retries by all requests share one budget.
+        if (_retryPending) {
+            int32_t wait = _retryBudget.acquire();
+            if (wait > 0) {
+                BRANCH_LOG_V("Retry budget exhausted. Waiting " << wait << " ms");
+                return wait;
+            }
+            _retryPending = false;
         }
 
-        // POST failed
-        incrementAttemptCount();
+        // While the API is failing, wait without using up an attempt.
+        int32_t wait = _circuitBreaker.acquire();
+        if (wait > 0) {
+            BRANCH_LOG_V("Circuit breaker open. Waiting " << wait << " ms");
+            return wait;
+        }
 
-        if (getAttemptCount() >= MaxAttemptCount) {
-            break;
+        // POST the request
+        RetryInfo retryInfo;
+        bool sent;
+        try {
+            sent = clientSession->post(path, jsonPayload, callback, result, retryInfo);
+        }
+        catch (...) {
+            // Otherwise a half-open probe would stay in flight for good.
+            _circuitBreaker.recordFailure();
+            throw;
         }
 
-        int32_t backoff = getBackoffMillis();
-        BRANCH_LOG_D("POST failed. Retrying in " << backoff << " ms");
+        if (sent) {
+            _circuitBreaker.recordSuccess();
+            BRANCH_LOG_V("POST Success");
+            return 0;
+        }
 
-        _sleeper.sleep(backoff);
+        if (isCanceled()) {
+            // Shutting down. Says nothing about the API.
+            _circuitBreaker.release();
+        } else {
+            // POST failed
+            _circuitBreaker.recordFailure();
+            incrementAttemptCount();
+
+            if (getAttemptCount() < MaxAttemptCount) {
+                int32_t backoff = getBackoffMillis(retryInfo.retryAfterMillis);
+                if (isExpired(std::chrono::system_clock::now() + std::chrono::milliseconds(backoff))) {
+                    BRANCH_LOG_W("POST failed. Request expires before it can be retried.");
+                    callback.onError(0, 0, "Request expired.");
+                    return 0;
+                }
+
+                BRANCH_LOG_D("POST failed. Retrying in " << backoff << " ms");
+                _retryPending = true;
+                return backoff;
+            }
+        }
     }
 
     if (getAttemptCount() >= MaxAttemptCount) {
         BRANCH_LOG_E("Maximum number of retries reached.");
         callback.onError(0, 0, "Maximum number of retries reached.");
-        return result;
-    }
-
-    if (isCanceled()) {
-        BRANCH_LOG_W("Request canceled");
-        // Don't call the user's error callback after cancellation.
-        // @todo(jdee): Review this.
-        callback.onStatus(0, 0, "Request canceled");
-        return result;
+        return 0;
     }
 
-    BRANCH_LOG_V("POST Success");
-    return result;
+    BRANCH_LOG_W("Request canceled");
+    // Don't call the user's error callback after cancellation.
+    // @todo(jdee): Review this.
+    callback.onStatus(0, 0, "Request canceled");
+    return 0;
 }
 
 void
@@ -83,13 +158,28 @@ Request::isCanceled() const {
 }
 
 int32_t
-Request::getBackoffMillis() const {
-    int32_t backoff(8000);
-    int attemptCount(getAttemptCount());
+Request::getBackoffMillis(int32_t retryAfterMillis) {
+    _lastBackoffMillis = _backoffPolicy->getBackoffMillis(getAttemptCount(), _lastBackoffMillis);
+
+    // Never sooner than the server asked
+    return max(_lastBackoffMillis, min(retryAfterMillis, MaxRetryAfterMillis));
+}
 
-    while (--attemptCount > 0 && backoff < MaxBackoffMillis) backoff *= 2;
+void
+Request::setBackoffPolicy(const BackoffPolicy& backoffPolicy) {
+    _backoffPolicy = &backoffPolicy;
+}
+
+void
+Request::setDeadline(std::chrono::system_clock::time_point deadline) {
+    scoped_lock _l(_mutex);
+    _deadline = deadline;
+}
 
-    return min(MaxBackoffMillis, backoff);
+bool
+Request::isExpired(std::chrono::system_clock::time_point now) const {
+    scoped_lock _l(_mutex);
+    return now >= _deadline;
 }
 
 int
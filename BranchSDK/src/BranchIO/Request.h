@@ -3,18 +3,30 @@
 #ifndef BRANCHIO_REQUEST_H__
 #define BRANCHIO_REQUEST_H__
 
+#include <chrono>
 #include <mutex>
 #include <cstdint>
 
 #include "BranchIO/fwd.h"
 #include "BranchIO/Defines.h"
+#include "BranchIO/Util/BackoffPolicy.h"
+#include "BranchIO/Util/CircuitBreaker.h"
 #include "BranchIO/Util/IClientSession.h"
+#include "BranchIO/Util/RetryBudget.h"
 #include "BranchIO/Util/Sleeper.h"
 
 namespace BranchIO {
 
 /**
  * (Internal) Class for making Server Requests.
+ *
+ * Failed requests are retried with backoff. All requests share a
+ * CircuitBreaker, so while the API is failing they wait instead of using
+ * up their attempts, and a RetryBudget that limits the overall retry rate.
+ *
+ * A request with a deadline is not attempted after it, and is not retried
+ * if the backoff would take it past the deadline. The callback's onError
+ * is called instead.
  */
 class Request {
  public:
@@ -24,13 +36,25 @@ class Request {
     /// Maximum retry delay in ms
     static int32_t const MaxBackoffMillis;
 
+    /// Maximum Retry-After delay honored, in ms
+    static int32_t const MaxRetryAfterMillis;
+
     /**
-     * Default constructor
+     * Default constructor. Uses the process-wide CircuitBreaker and
+     * RetryBudget.
      */
     Request();
 
     /**
-     * Send this request to the Branch server (synchronous).
+     * Constructor.
+     * @param circuitBreaker circuit breaker to send through. Must outlive this object.
+     * @param retryBudget budget for retries. Must outlive this object.
+     */
+    Request(CircuitBreaker& circuitBreaker, RetryBudget& retryBudget);
+
+    /**
+     * Send this request to the Branch server (synchronous). Sleeps
+     * between attempts.
      * @param api API Endpoint
      * @param jsonPayload JSON Payload to send
      * @param callback Interface for success and failure response.
@@ -43,6 +67,46 @@ class Request {
         IRequestCallback &callback,
         IClientSession *clientSession);
 
+    /**
+     * Make one attempt to send this request. Instead of sleeping between
+     * attempts like send(), returns the time to wait before calling again.
+     * The callback is called as for send().
+     * @param api API Endpoint
+     * @param jsonPayload JSON Payload to send
+     * @param callback Interface for success and failure response.
+     * @param clientSession IClientSession to use for the request
+     * @param result receives the response body
+     * @return 0 if the request is finished, otherwise the time in ms to
+     *         wait before calling attempt() again
+     */
+    int32_t attempt(
+        Defines::APIEndpoint api,
+        const JSONObject& jsonPayload,
+        IRequestCallback &callback,
+        IClientSession *clientSession,
+        JSONObject& result);
+
+    /**
+     * Set the policy for delays between attempts. The default is
+     * BackoffPolicy::getDefault().
+     * @param backoffPolicy the policy. Must outlive this object.
+     */
+    void setBackoffPolicy(const BackoffPolicy& backoffPolicy);
+
+    /**
+     * Set the time after which the request is dropped instead of sent. The
+     * default is no deadline.
+     * @param deadline the deadline, e.g. BaseEvent::getDeadline()
+     */
+    void setDeadline(std::chrono::system_clock::time_point deadline);
+
+    /**
+     * Determine if this request's deadline has passed.
+     * @param now the current time
+     * @return true if the request has expired
+     */
+    bool isExpired(std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+
     /**
      * Get attempt count
      * @return the number of attempts so far (including any in progress)
@@ -62,14 +126,14 @@ class Request {
 
  protected:
     /**
-     * Get the number of milliseconds to wait until the next request,
-     * based on the attempt count. Returns 8000, 16000, 32000, 64000, then
-     * 120000 for all successive attempts.
+     * Get the number of milliseconds to wait until the next request, from
+     * the backoff policy and the attempt count. If the server sent a
+     * Retry-After delay, waits at least that long.
      *
+     * @param retryAfterMillis Retry-After delay in ms, or -1
      * @return a delay in ms
-     * @todo(jdee): Determine a proper backoff scheme and maximum number of attempts.
      */
-    int32_t getBackoffMillis() const;
+    int32_t getBackoffMillis(int32_t retryAfterMillis = -1);
 
     /**
      * Increment the attempt count returned by getAttemptCount().
@@ -87,7 +151,14 @@ class Request {
     mutable std::mutex _mutex;
     int volatile _attemptCount;
     bool volatile _canceled;
+    // A retry must take a token from the retry budget before it is sent.
+    bool _retryPending;
+    int32_t _lastBackoffMillis;
+    const BackoffPolicy* _backoffPolicy;
+    std::chrono::system_clock::time_point _deadline;
     Sleeper _sleeper;
+    CircuitBreaker& _circuitBreaker;
+    RetryBudget& _retryBudget;
 };
 
 }  // namespace BranchIO
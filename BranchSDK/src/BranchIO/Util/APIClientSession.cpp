@@ -1,15 +1,21 @@
 // Copyright (c) 2019-21 Branch Metrics, Inc.
 
 #include "APIClientSession.h"
-#include "StringUtils.h"
+#include "Gzip.h"
 #include "BranchIO/Defines.h"
 #include "BranchIO/IRequestCallback.h"
 #include "BranchIO/Util/Log.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <string>
 #include <winrt/Windows.Web.Http.Headers.h>
 #include <winrt/Windows.Foundation.Collections.h>
 #include <winrt/Windows.Security.Cryptography.h>
+#include <winrt/Windows.Storage.Streams.h>
+#include <winrt/Windows.Web.Http.Filters.h>
+#include <robuffer.h>
 
 using namespace std;
 
@@ -17,12 +23,45 @@ using namespace winrt;
 using namespace winrt::Windows::Foundation;
 using namespace winrt::Windows::Foundation::Collections;
 using namespace winrt::Windows::Web::Http;
+using namespace winrt::Windows::Web::Http::Filters;
 using namespace winrt::Windows::Web::Http::Headers;
 using namespace winrt::Windows::Security::Credentials;
 using namespace winrt::Windows::Storage::Streams;
 
 namespace BranchIO {
 
+namespace {
+
+/**
+ * IBuffer that owns a string, so that a serialized request body is sent by
+ * HttpBufferContent without being copied.
+ */
+struct StringBuffer : implements<StringBuffer, IBuffer, ::Windows::Storage::Streams::IBufferByteAccess> {
+    explicit StringBuffer(std::string&& bytes) : _bytes(std::move(bytes)) {}
+
+    uint32_t Capacity() const {
+        return static_cast<uint32_t>(_bytes.size());
+    }
+
+    uint32_t Length() const {
+        return static_cast<uint32_t>(_bytes.size());
+    }
+
+    void Length(uint32_t value) {
+        if (value != _bytes.size()) throw hresult_invalid_argument();
+    }
+
+    HRESULT __stdcall Buffer(uint8_t** value) noexcept final {
+        *value = reinterpret_cast<uint8_t*>(_bytes.data());
+        return S_OK;
+    }
+
+ private:
+    std::string _bytes;
+};
+
+}  // namespace
+
 APIClientSession&
 APIClientSession::instance() {
     // constructed the first time through
@@ -30,52 +69,138 @@ APIClientSession::instance() {
     return _session;
 }
 
-APIClientSession::APIClientSession(const std::string& urlBase) :_urlBase(urlBase),
-    _shuttingDown(false) {
+APIClientSession::APIClientSession(const std::string& urlBase, unsigned int maxConnections, bool http2, size_t compressionThreshold) :_urlBase(urlBase),
+    _compressionThreshold(compressionThreshold),
+    _shuttingDown(false),
+    _httpClient(nullptr) {
     init_apartment();
-    _httpClient = HttpClient();
+
+    HttpBaseProtocolFilter filter;
+    filter.MaxConnectionsPerServer(maxConnections > 0 ? maxConnections : 1);
+    filter.MaxVersion(http2 ? HttpVersion::Http20 : HttpVersion::Http11);
+
+    _httpClient = HttpClient(filter);
+    // HTTP/2 forbids connection-specific headers (RFC 7540 8.1.2.2).
+    if (!http2) {
+        _httpClient.DefaultRequestHeaders().TryAppendWithoutValidation(L"Connection", L"Keep-Alive");
+    }
 }
 
 void
 APIClientSession::stop() {
+    PostOperationList pendingOperations;
     {
         std::scoped_lock _l(_mutex);
         // Ignore subsequent calls
         if (_shuttingDown) return;
 
         _shuttingDown = true;
+        pendingOperations.swap(_pendingOperations);
+    }
+
+    // Unblock any threads waiting in post()
+    for (auto& operation : pendingOperations) {
+        try {
+            operation.Cancel();
+        }
+        catch (winrt::hresult_error const&) {
+            // Already completed
+        }
     }
 }
 
+bool
+APIClientSession::addPendingOperation(const PostOperation& operation, PostOperationList::iterator& it) {
+    std::scoped_lock _l(_mutex);
+    if (_shuttingDown) return false;
+
+    it = _pendingOperations.insert(_pendingOperations.end(), operation);
+    return true;
+}
+
+void
+APIClientSession::removePendingOperation(PostOperationList::iterator it) {
+    std::scoped_lock _l(_mutex);
+    // stop() takes ownership of the whole list when shutting down.
+    if (_shuttingDown) return;
+
+    _pendingOperations.erase(it);
+}
+
 bool
 APIClientSession::post(
     const std::string& path,
     const JSONObject& jsonPayload,
     IRequestCallback& callback,
     JSONObject& result) {
+    RetryInfo retryInfo;
+    return post(path, jsonPayload, callback, result, retryInfo);
+}
+
+bool
+APIClientSession::post(
+    const std::string& path,
+    const JSONObject& jsonPayload,
+    IRequestCallback& callback,
+    JSONObject& result,
+    RetryInfo& retryInfo) {
     if (isShuttingDown()) return false;
 
         /* ----- Set up the HTTP request ----- */
-    Uri uri{to_hstring(BRANCH_IO_URL_BASE), to_hstring(path) };
+    Uri uri{ to_hstring(resolveUrl(getUrlBase(), path)) };
 
-        // Construct the JSON to post.
-        wstring requestBody = StringUtils::utf8_to_wstring(jsonPayload.stringify());
-        HttpStringContent jsonContent( requestBody, UnicodeEncoding::Utf8, L"application/json");
+        // Construct the JSON to post. It is serialized once, and the UTF-8
+        // bytes are handed to the HttpClient as they are.
+        string body(jsonPayload.stringify());
         BRANCH_LOG_D("URI: " << path);
-        BRANCH_LOG_D("Request body: " << jsonPayload.stringify());
+        BRANCH_LOG_D("Request body: " << body);
+
+        bool compressed = false;
+        if (_compressionThreshold > 0 && body.size() >= _compressionThreshold) {
+            string gzipped(Gzip::compress(body));
+            if (gzipped.size() < body.size()) {
+                BRANCH_LOG_D("Compressed body: " << body.size() << " -> " << gzipped.size() << " bytes");
+                body.swap(gzipped);
+                compressed = true;
+            }
+        }
+
+        HttpBufferContent jsonContent(make<StringBuffer>(std::move(body)));
+        HttpMediaTypeHeaderValue contentType(L"application/json");
+        contentType.CharSet(L"utf-8");
+        jsonContent.Headers().ContentType(contentType);
+        if (compressed) {
+            jsonContent.Headers().ContentEncoding().Append(HttpContentCodingHeaderValue(L"gzip"));
+        }
+
         /* ----- Send the request and body ----- */
 
         // bail out immediately before and after any I/O, which can take
         // time - Post the JSON, and wait for a response.
     try
     {
-        HttpResponseMessage  httpResponseMessage = _httpClient.PostAsync(uri, jsonContent).get();
+        PostOperation operation = _httpClient.PostAsync(uri, jsonContent);
+        PostOperationList::iterator it;
+        if (!addPendingOperation(operation, it)) {
+            operation.Cancel();
+            return false;
+        }
+
+        HttpResponseMessage httpResponseMessage(nullptr);
+        try {
+            httpResponseMessage = operation.get();
+        }
+        catch (...) {
+            removePendingOperation(it);
+            throw;
+        }
+        removePendingOperation(it);
         if (isShuttingDown()) return false;
 
         BRANCH_LOG_D("Request sent. Waiting for response.");
  
         // Make sure the post succeeded, and write out the response.
-        bool responseCode = processResponse(callback, result, httpResponseMessage);
+        bool responseCode = processResponse(callback, result, httpResponseMessage, retryInfo);
 
         httpResponseMessage.Close();
 
@@ -97,8 +222,33 @@ APIClientSession::post(
     return false;
 }
 
+/**
+ * @param httpResponseMessage the response
+ * @return the delay from the Retry-After header in ms, or -1 if there is none
+ */
+static int32_t
+getRetryAfterMillis(HttpResponseMessage& httpResponseMessage) {
+    HttpDateOrDeltaHeaderValue retryAfter = httpResponseMessage.Headers().RetryAfter();
+    if (!retryAfter) return -1;
+
+    // Either a number of seconds or a date
+    chrono::milliseconds delay(-1);
+    if (retryAfter.Delta()) {
+        delay = chrono::duration_cast<chrono::milliseconds>(retryAfter.Delta().Value());
+    } else if (retryAfter.Date()) {
+        delay = chrono::duration_cast<chrono::milliseconds>(retryAfter.Date().Value() - winrt::clock::now());
+        if (delay.count() < 0) delay = chrono::milliseconds(0);
+    }
+
+    return static_cast<int32_t>(min<long long>(delay.count(), INT32_MAX));
+}
+
 bool
-APIClientSession::processResponse(IRequestCallback& callback, JSONObject& result, HttpResponseMessage& httpResponseMessage) {
+APIClientSession::processResponse(
+    IRequestCallback& callback,
+    JSONObject& result,
+    HttpResponseMessage& httpResponseMessage,
+    RetryInfo& retryInfo) {
 
     if (isShuttingDown()) return false;
 
@@ -120,8 +270,9 @@ APIClientSession::processResponse(IRequestCallback& callback, JSONObject& result
     if (status == HttpStatusCode::Ok) {
         try {
 
-            std::wstring  httpResponseBody = httpResponseMessage.Content().ReadAsStringAsync().get().c_str();
-            result = JSONObject::parse(to_string(httpResponseBody));
+            // The API responds with UTF-8 JSON, parsed without converting to UTF-16.
+            IBuffer httpResponseBody = httpResponseMessage.Content().ReadAsBufferAsync().get();
+            result = JSONObject::parse(string(reinterpret_cast<const char*>(httpResponseBody.data()), httpResponseBody.Length()));
             if(!result.isEmpty())
                 BRANCH_LOG_D("Response : " << result.stringify());
             callback.onSuccess(0, result);
@@ -142,11 +293,17 @@ APIClientSession::processResponse(IRequestCallback& callback, JSONObject& result
         callback.onStatus(0, (int)status, to_string(httpResponseMessage.ReasonPhrase()));
         if (isShuttingDown()) return false;
 
-        if (status < HttpStatusCode::InternalServerError) {
+        if (status < HttpStatusCode::InternalServerError && status != HttpStatusCode::TooManyRequests) {
             // We don't want to retry this.  Call the error handler and return "true" to indicate that this was handled.
             callback.onError(0, (int)status, to_string(httpResponseMessage.ReasonPhrase()));
             return true;
         }
+
+        // Typically sent with 429 and 503
+        retryInfo.retryAfterMillis = getRetryAfterMillis(httpResponseMessage);
+        if (retryInfo.retryAfterMillis >= 0) {
+            BRANCH_LOG_D("Retry-After: " << retryInfo.retryAfterMillis << " ms");
+        }
     }
 
     return false;
@@ -3,6 +3,7 @@
 #ifndef BRANCHIO_UTIL_APICLIENTSESSION_H__
 #define BRANCHIO_UTIL_APICLIENTSESSION_H__
 
+#include <list>
 #include <string>
 #include <winrt/Windows.Web.Http.Headers.h>
 
@@ -26,10 +27,16 @@ class APIClientSession
     static APIClientSession& instance();
 
     /**
-     * Constructor.
+     * Constructor. The session keeps a single HttpClient for its lifetime, so
+     * connections to the API are kept alive and reused between requests.
+     * post() may be called concurrently from several threads.
      * @param urlBase Base endpoint for the session conversation.
+     * @param maxConnections Maximum number of simultaneous connections to the server.
+     * @param http2 true to use HTTP/2 when the server supports it. Concurrent
+     *        requests are then multiplexed over one connection.
+     * @param compressionThreshold Minimum size of a request body sent gzip-compressed, or 0 for never.
      */
-    explicit APIClientSession(const std::string& urlBase);
+    explicit APIClientSession(const std::string& urlBase, unsigned int maxConnections = 1, bool http2 = false, size_t compressionThreshold = 0);
 
     /**
      * @return the urlBase.
@@ -46,7 +53,18 @@ class APIClientSession
         JSONObject& result);
 
     /**
-     * @todo(jdee): Document
+     * @copydoc IClientSession::post(const std::string&, const JSONObject&, IRequestCallback&, JSONObject&, RetryInfo&)
+     */
+    bool post(
+        const std::string& path,
+        const JSONObject& jsonPayload,
+        IRequestCallback& callback,
+        JSONObject& result,
+        RetryInfo& retryInfo);
+
+    /**
+     * Stop the session. Any requests in flight are cancelled, and subsequent
+     * calls to post() return false immediately.
      */
     void stop();
 
@@ -61,16 +79,32 @@ class APIClientSession
 
     /**
      * Wait for and handle the response after sending a request.
+     * 5xx responses and 429 Too Many Requests may be retried.
      * @param callback callback for the response/error
+     * @param retryInfo receives the Retry-After delay of a response that may be retried
      * @return true on success, false otherwise
      */
-    bool processResponse(IRequestCallback& callback, JSONObject& result, winrt::Windows::Web::Http::HttpResponseMessage& httpResponseMessage);
+    bool processResponse(
+        IRequestCallback& callback,
+        JSONObject& result,
+        winrt::Windows::Web::Http::HttpResponseMessage& httpResponseMessage,
+        RetryInfo& retryInfo);
 
  private:
+    typedef winrt::Windows::Foundation::IAsyncOperationWithProgress<
+        winrt::Windows::Web::Http::HttpResponseMessage,
+        winrt::Windows::Web::Http::HttpProgress> PostOperation;
+    typedef std::list<PostOperation> PostOperationList;
+
+    bool addPendingOperation(const PostOperation& operation, PostOperationList::iterator& it);
+    void removePendingOperation(PostOperationList::iterator it);
+
     mutable std::mutex _mutex;
     std::string _urlBase;
+    size_t const _compressionThreshold;
     bool volatile _shuttingDown;
     winrt::Windows::Web::Http::HttpClient _httpClient;
+    PostOperationList _pendingOperations;
 };
 
 }  // namespace BranchIO
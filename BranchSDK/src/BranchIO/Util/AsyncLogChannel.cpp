@@ -0,0 +1,230 @@
+#include "AsyncLogChannel.h"
+#include <chrono>
+#include <cstddef>
+
+using namespace std;
+
+namespace BranchIO
+{
+    // How long the flusher sleeps when there is nothing to write.
+    static const chrono::milliseconds FlushInterval(100);
+
+    // Largest number of messages passed to the wrapped channel at once.
+    static const size_t MaxBatchSize = 256;
+
+    static size_t roundUpToPowerOf2(size_t n)
+    {
+        size_t size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    AsyncLogChannel::AsyncLogChannel(LogChannel* channel, size_t capacity, OverflowPolicy policy) :
+        _channel(channel),
+        _policy(policy),
+        _mask(roundUpToPowerOf2(capacity) - 1),
+        _slots(new Slot[_mask + 1]),
+        _enqueuePos(0),
+        _dequeuePos(0),
+        _dropped(0),
+        _reportedDropped(0),
+        _running(false),
+        _producers(0),
+        _flusherWaiting(false)
+    {
+        for (size_t j = 0; j <= _mask; ++j)
+        {
+            _slots[j].sequence.store(j, memory_order_relaxed);
+        }
+    }
+
+    AsyncLogChannel::~AsyncLogChannel()
+    {
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    bool AsyncLogChannel::open()
+    {
+        scoped_lock _l(_mutex);
+        if (_running.load())
+            return true;
+
+        _running.store(true);
+        _flusher = thread(&AsyncLogChannel::run, this);
+        return true;
+    }
+
+    void AsyncLogChannel::close()
+    {
+        {
+            scoped_lock _l(_mutex);
+            if (!_running.exchange(false))
+                return;
+        }
+
+        _condition.notify_all();
+        _flusher.join();
+
+        // A producer that saw _running before it was cleared may still be
+        // pushing. Any later one writes synchronously. Wait for the former,
+        // then write out everything left in the ring.
+        while (_producers.load() != 0)
+        {
+            this_thread::yield();
+        }
+
+        vector<string> batch;
+        do
+        {
+            drain(batch);
+        } while (!batch.empty());
+    }
+
+    void AsyncLogChannel::log(const std::string& message)
+    {
+        // Counted before checking _running, so close() either waits for this
+        // push or this call sees that the channel is closed.
+        _producers.fetch_add(1);
+        bool queued = _running.load() && enqueue(message);
+        _producers.fetch_sub(1);
+
+        if (!queued)
+        {
+            // Not started or already closed
+            _channel->log(message);
+        }
+    }
+
+    /**
+     * @return true if the message was queued or dropped, false if the channel
+     * was closed while waiting for room
+     */
+    bool AsyncLogChannel::enqueue(const std::string& message)
+    {
+        string copy(message);
+        while (!tryPush(copy))
+        {
+            if (_policy == DropWhenFull)
+            {
+                _dropped.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
+
+            if (!_running.load(memory_order_acquire))
+            {
+                // Closed while waiting. Nothing will make room.
+                return false;
+            }
+
+            _condition.notify_one();
+            this_thread::yield();
+        }
+
+        if (_flusherWaiting.load(memory_order_relaxed))
+            _condition.notify_one();
+        return true;
+    }
+
+    LogChannel* AsyncLogChannel::getChannel() const
+    {
+        return _channel;
+    }
+
+    uint64_t AsyncLogChannel::getDroppedCount() const
+    {
+        return _dropped.load(memory_order_relaxed);
+    }
+
+    bool AsyncLogChannel::tryPush(std::string& message)
+    {
+        Slot* slot;
+        size_t pos = _enqueuePos.load(memory_order_relaxed);
+        for (;;)
+        {
+            slot = &_slots[pos & _mask];
+            size_t sequence = slot->sequence.load(memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                // The slot is free. Claim it, unless another producer got there first.
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // The consumer hasn't emptied this slot yet.
+                return false;
+            }
+            else
+            {
+                pos = _enqueuePos.load(memory_order_relaxed);
+            }
+        }
+
+        slot->message.swap(message);
+        slot->sequence.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    bool AsyncLogChannel::tryPop(std::string& message)
+    {
+        // Only the flusher thread (or close() after it has stopped) pops.
+        Slot& slot = _slots[_dequeuePos & _mask];
+        if (slot.sequence.load(memory_order_acquire) != _dequeuePos + 1)
+            return false;
+
+        message.swap(slot.message);
+        slot.message.clear();
+        slot.sequence.store(_dequeuePos + _mask + 1, memory_order_release);
+        ++ _dequeuePos;
+        return true;
+    }
+
+    void AsyncLogChannel::run()
+    {
+        vector<string> batch;
+        batch.reserve(MaxBatchSize);
+
+        while (_running.load(memory_order_acquire))
+        {
+            drain(batch);
+            if (!batch.empty())
+                continue;
+
+            unique_lock<mutex> lock(_mutex);
+            _flusherWaiting.store(true);
+            _condition.wait_for(lock, FlushInterval, [this] {
+                return !_running.load() || _slots[_dequeuePos & _mask].sequence.load() == _dequeuePos + 1;
+            });
+            _flusherWaiting.store(false);
+        }
+
+        // close() writes out what is left once producers are done.
+    }
+
+    void AsyncLogChannel::drain(std::vector<std::string>& batch)
+    {
+        batch.clear();
+        string message;
+        while (batch.size() < MaxBatchSize && tryPop(message))
+        {
+            batch.push_back(std::move(message));
+        }
+
+        uint64_t dropped = _dropped.load(memory_order_relaxed);
+        if (dropped != _reportedDropped)
+        {
+            batch.push_back("AsyncLogChannel: " + to_string(dropped - _reportedDropped) + " messages dropped");
+            _reportedDropped = dropped;
+        }
+
+        if (!batch.empty())
+            _channel->log(batch);
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "LogChannel.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BranchIO {
+
+    /**
+     * AsyncLogChannel passes messages to another channel on a background thread.
+     *
+     * Logging threads push messages into a bounded lock-free ring buffer and
+     * return without waiting for I/O. A single flusher thread drains the ring
+     * and hands each batch of messages to the wrapped channel at once.
+     *
+     * The wrapped channel is not owned and must outlive this channel.
+     */
+    class AsyncLogChannel : public LogChannel
+    {
+    public:
+        /**
+         * What to do when a message is logged and the ring buffer is full.
+         */
+        enum OverflowPolicy
+        {
+            /// Discard the message. The number of dropped messages is logged later.
+            DropWhenFull,
+            /// Wait for the flusher to make room.
+            BlockWhenFull
+        };
+
+        /**
+         * Creates the channel. Call open() to start the flusher thread.
+         * @param channel the channel to write to
+         * @param capacity number of messages the ring buffer can hold, rounded up to a power of 2
+         * @param policy what to do when the ring buffer is full
+         */
+        AsyncLogChannel(LogChannel* channel, size_t capacity = 1024, OverflowPolicy policy = DropWhenFull);
+
+        /**
+         * Destructor - flush and stop the flusher thread.
+         */
+        ~AsyncLogChannel();
+
+        /**
+         * Opens the channel and starts the flusher thread.
+         */
+        bool open();
+
+        /**
+         * Writes out any queued messages and stops the flusher thread.
+         * Messages logged after close() are written synchronously.
+         */
+        void close();
+
+        /**
+         * Queues a message for the wrapped channel.
+         */
+        void log(const std::string& message);
+
+        /**
+         * @return the wrapped channel
+         */
+        LogChannel* getChannel() const;
+
+        /**
+         * @return the number of messages dropped because the ring buffer was full
+         */
+        uint64_t getDroppedCount() const;
+
+    private:
+        /**
+         * One slot in the ring buffer. The sequence number tells producers and
+         * the consumer whose turn it is to use the slot.
+         */
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            std::string message;
+        };
+
+        bool enqueue(const std::string& message);
+        bool tryPush(std::string& message);
+        bool tryPop(std::string& message);
+        void run();
+        void drain(std::vector<std::string>& batch);
+
+        LogChannel* _channel;
+        const OverflowPolicy _policy;
+        const size_t _mask;
+        std::unique_ptr<Slot[]> _slots;
+
+        // Producers and the consumer work on different cache lines.
+        alignas(64) std::atomic<size_t> _enqueuePos;
+        alignas(64) size_t _dequeuePos;
+
+        std::atomic<uint64_t> _dropped;
+        uint64_t _reportedDropped;
+        std::atomic<bool> _running;
+        // Number of threads in log() that may push a message
+        std::atomic<unsigned int> _producers;
+        std::atomic<bool> _flusherWaiting;
+
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::thread _flusher;
+    };
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "BranchIO/Util/BackoffPolicy.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace std;
+
+namespace BranchIO {
+
+/**
+ * @param low lower bound
+ * @param high upper bound
+ * @return a random number in [low, high]
+ */
+static int32_t
+randomBetween(int32_t low, int32_t high) {
+    // Seeded differently in each process, so installs don't retry together.
+    static thread_local mt19937 generator(random_device{}());
+    return uniform_int_distribution<int32_t>(low, max(low, high))(generator);
+}
+
+const BackoffPolicy&
+BackoffPolicy::getDefault() {
+    static const DecorrelatedJitterBackoff _policy(8000, 120000);
+    return _policy;
+}
+
+ExponentialBackoff::ExponentialBackoff(int32_t baseMillis, int32_t maxMillis) :
+    _baseMillis(max<int32_t>(1, baseMillis)),
+    _maxMillis(max(_baseMillis, maxMillis)) {
+}
+
+int32_t
+ExponentialBackoff::getBackoffMillis(int attemptCount, int32_t /* previousMillis */) const {
+    int32_t backoff(_baseMillis);
+    while (--attemptCount > 0 && backoff < _maxMillis) backoff *= 2;
+
+    return min(_maxMillis, backoff);
+}
+
+FullJitterBackoff::FullJitterBackoff(int32_t baseMillis, int32_t maxMillis) :
+    ExponentialBackoff(baseMillis, maxMillis) {
+}
+
+int32_t
+FullJitterBackoff::getBackoffMillis(int attemptCount, int32_t previousMillis) const {
+    return randomBetween(0, ExponentialBackoff::getBackoffMillis(attemptCount, previousMillis));
+}
+
+DecorrelatedJitterBackoff::DecorrelatedJitterBackoff(int32_t baseMillis, int32_t maxMillis) :
+    ExponentialBackoff(baseMillis, maxMillis) {
+}
+
+int32_t
+DecorrelatedJitterBackoff::getBackoffMillis(int /* attemptCount */, int32_t previousMillis) const {
+    int32_t previous = max(_baseMillis, previousMillis);
+    int32_t high = previous > _maxMillis / 3 ? _maxMillis : previous * 3;
+    return min(_maxMillis, randomBetween(_baseMillis, high));
+}
+
+}  // namespace BranchIO
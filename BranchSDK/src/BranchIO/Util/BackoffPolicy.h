@@ -0,0 +1,91 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_BACKOFFPOLICY_H__
+#define BRANCHIO_UTIL_BACKOFFPOLICY_H__
+
+#include <cstdint>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Decides how long to wait before retrying a failed request.
+ *
+ * Policies are stateless and may be shared by any number of requests.
+ * Whatever a request needs to remember between attempts is passed in.
+ */
+class BackoffPolicy {
+ public:
+    virtual ~BackoffPolicy() {}
+
+    /**
+     * @param attemptCount number of failed attempts so far, starting at 1
+     * @param previousMillis the delay returned for the previous attempt, or
+     *        0 after the first failure
+     * @return the delay before the next attempt, in ms
+     */
+    virtual int32_t getBackoffMillis(int attemptCount, int32_t previousMillis) const = 0;
+
+    /**
+     * @return the policy used by requests unless another is set:
+     *         DecorrelatedJitterBackoff from 8 s to 2 minutes
+     */
+    static const BackoffPolicy& getDefault();
+};
+
+/**
+ * (Internal) Doubles the delay after each failure, without randomness.
+ */
+class ExponentialBackoff : public BackoffPolicy {
+ public:
+    /**
+     * Constructor.
+     * @param baseMillis delay after the first failure, in ms
+     * @param maxMillis maximum delay, in ms
+     */
+    ExponentialBackoff(int32_t baseMillis, int32_t maxMillis);
+
+    int32_t getBackoffMillis(int attemptCount, int32_t previousMillis) const;
+
+ protected:
+    /// Delay after the first failure, in ms
+    const int32_t _baseMillis;
+    /// Maximum delay, in ms
+    const int32_t _maxMillis;
+};
+
+/**
+ * (Internal) Waits a random time between 0 and the exponential delay, so
+ * clients that failed at the same moment don't retry together.
+ */
+class FullJitterBackoff : public ExponentialBackoff {
+ public:
+    /**
+     * Constructor.
+     * @param baseMillis upper bound of the delay after the first failure, in ms
+     * @param maxMillis maximum delay, in ms
+     */
+    FullJitterBackoff(int32_t baseMillis, int32_t maxMillis);
+
+    int32_t getBackoffMillis(int attemptCount, int32_t previousMillis) const;
+};
+
+/**
+ * (Internal) Waits a random time between the base delay and three times
+ * the previous delay. Spreads out retries like FullJitterBackoff, but
+ * never retries sooner than the base delay.
+ */
+class DecorrelatedJitterBackoff : public ExponentialBackoff {
+ public:
+    /**
+     * Constructor.
+     * @param baseMillis minimum delay, in ms
+     * @param maxMillis maximum delay, in ms
+     */
+    DecorrelatedJitterBackoff(int32_t baseMillis, int32_t maxMillis);
+
+    int32_t getBackoffMillis(int attemptCount, int32_t previousMillis) const;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_BACKOFFPOLICY_H__
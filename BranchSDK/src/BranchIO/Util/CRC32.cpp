@@ -0,0 +1,44 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "CRC32.h"
+
+namespace BranchIO {
+
+const uint32_t CRC32::Initial = 0;
+
+namespace {
+
+struct CRC32Table {
+    uint32_t entries[256];
+
+    CRC32Table() {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[n] = c;
+        }
+    }
+};
+
+const CRC32Table& table() {
+    static const CRC32Table _table;
+    return _table;
+}
+
+}  // namespace
+
+uint32_t
+CRC32::update(uint32_t crc, const void* data, size_t length) {
+    const uint32_t* entries = table().entries;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+
+    crc = ~crc;
+    while (length-- > 0) {
+        crc = entries[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+}  // namespace BranchIO
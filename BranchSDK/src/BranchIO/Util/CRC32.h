@@ -0,0 +1,49 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_CRC32_H__
+#define BRANCHIO_UTIL_CRC32_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace BranchIO {
+
+/**
+ * (Internal) CRC-32 (ISO-HDLC, as used by zlib and gzip) checksum.
+   ```
+   uint32_t crc = CRC32::compute(data, length);
+
+   // or incrementally:
+   uint32_t crc = CRC32::Initial;
+   crc = CRC32::update(crc, part1, length1);
+   crc = CRC32::update(crc, part2, length2);
+   ```
+ */
+class CRC32 {
+ public:
+    /// Value to start an incremental computation with
+    static const uint32_t Initial;
+
+    /**
+     * Continue a checksum computation with more data.
+     * @param crc checksum of the data so far, or Initial
+     * @param data bytes to add
+     * @param length number of bytes
+     * @return the checksum of all data so far
+     */
+    static uint32_t update(uint32_t crc, const void* data, size_t length);
+
+    /**
+     * Compute the checksum of a buffer.
+     * @param data bytes to checksum
+     * @param length number of bytes
+     * @return the checksum
+     */
+    static uint32_t compute(const void* data, size_t length) {
+        return update(Initial, data, length);
+    }
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_CRC32_H__
@@ -0,0 +1,207 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "BranchIO/Util/CachingStorage.h"
+#include "BranchIO/Util/WindowsStorage.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+// Separates the scope and prefix from the key in a cache key
+static const char KeySeparator = '\x01';
+
+// Default value that no stored string is expected to have
+static const char* const MissingString = "\x01missing";
+
+IStorage&
+CachingStorage::instance() {
+    static CachingStorage _instance(WindowsStorage::instance());
+    return _instance;
+}
+
+CachingStorage::CachingStorage(IStorage& storage) : _storage(storage) {
+}
+
+std::string
+CachingStorage::getCacheKey(const std::string& key, Scope scope) const {
+    if (scope == Default) scope = _storage.getDefaultScope();
+    // Without a scope, there's nothing to cache.
+    if (scope == Default) return string();
+
+    string cacheKey(1, static_cast<char>('0' + scope));
+    cacheKey += _storage.getPrefix();
+    cacheKey += KeySeparator;
+    cacheKey += key;
+    return cacheKey;
+}
+
+void
+CachingStorage::invalidateLocked(const std::string& cacheKey) {
+    string::size_type keyStart = cacheKey.find(KeySeparator) + 1;
+
+    // The key and everything under it
+    if (cacheKey.size() == keyStart) {
+        for (auto it = _cache.begin(); it != _cache.end();) {
+            if (it->first.compare(0, keyStart, cacheKey) == 0) {
+                it = _cache.erase(it);
+            } else {
+                ++ it;
+            }
+        }
+        return;
+    }
+
+    _cache.erase(cacheKey);
+    string subtree(cacheKey + ".");
+    for (auto it = _cache.begin(); it != _cache.end();) {
+        if (it->first.compare(0, subtree.size(), subtree) == 0) {
+            it = _cache.erase(it);
+        } else {
+            ++ it;
+        }
+    }
+
+    // Writing a.b.c may create a and a.b, and removing it may remove them.
+    for (string::size_type dot = cacheKey.find('.', keyStart); dot != string::npos; dot = cacheKey.find('.', dot + 1)) {
+        auto it = _cache.find(cacheKey.substr(0, dot));
+        if (it != _cache.end()) it->second.hasLoaded = false;
+    }
+}
+
+IStorage::Scope
+CachingStorage::getDefaultScope() const {
+    return _storage.getDefaultScope();
+}
+
+IStorage&
+CachingStorage::setDefaultScope(Scope scope) {
+    _storage.setDefaultScope(scope);
+    return *this;
+}
+
+std::string
+CachingStorage::getPrefix() const {
+    return _storage.getPrefix();
+}
+
+IStorage&
+CachingStorage::setPrefix(const std::string& prefix) {
+    // The prefix is part of the cache key, so nothing to invalidate.
+    _storage.setPrefix(prefix);
+    return *this;
+}
+
+bool
+CachingStorage::has(const std::string& key, Scope scope) const {
+    string cacheKey(getCacheKey(key, scope));
+    if (cacheKey.empty()) return _storage.has(key, scope);
+
+    scoped_lock _l(_mutex);
+    Entry& entry = _cache[cacheKey];
+    if (!entry.hasLoaded) {
+        entry.hasValue = _storage.has(key, scope);
+        entry.hasLoaded = true;
+    }
+    return entry.hasValue;
+}
+
+std::string
+CachingStorage::getString(const std::string& key, const std::string& defaultValue, Scope scope) const {
+    string cacheKey(getCacheKey(key, scope));
+    if (cacheKey.empty()) return _storage.getString(key, defaultValue, scope);
+
+    scoped_lock _l(_mutex);
+    Entry& entry = _cache[cacheKey];
+    if (!entry.stringLoaded) {
+        // Distinguish a missing value from one equal to the default.
+        string value(_storage.getString(key, "", scope));
+        if (!value.empty() || _storage.getString(key, MissingString, scope) != MissingString) {
+            entry.stringValue = value;
+        }
+        entry.stringLoaded = true;
+    }
+    return entry.stringValue ? *entry.stringValue : defaultValue;
+}
+
+IStorage&
+CachingStorage::setString(const std::string& key, const std::string& value, Scope scope) {
+    string cacheKey(getCacheKey(key, scope));
+
+    scoped_lock _l(_mutex);
+    _storage.setString(key, value, scope);
+    if (cacheKey.empty()) return *this;
+
+    invalidateLocked(cacheKey);
+    Entry& entry = _cache[cacheKey];
+    entry.stringLoaded = true;
+    entry.stringValue = value;
+    entry.hasLoaded = true;
+    entry.hasValue = true;
+    return *this;
+}
+
+bool
+CachingStorage::getBoolean(const std::string& key, bool defaultValue, Scope scope) const {
+    string cacheKey(getCacheKey(key, scope));
+    if (cacheKey.empty()) return _storage.getBoolean(key, defaultValue, scope);
+
+    scoped_lock _l(_mutex);
+    Entry& entry = _cache[cacheKey];
+    if (!entry.booleanLoaded) {
+        // Distinguish a missing value from one equal to the default.
+        bool value = _storage.getBoolean(key, false, scope);
+        if (value || _storage.getBoolean(key, true, scope) == value) {
+            entry.booleanValue = value;
+        }
+        entry.booleanLoaded = true;
+    }
+    return entry.booleanValue ? *entry.booleanValue : defaultValue;
+}
+
+IStorage&
+CachingStorage::setBoolean(const std::string& key, bool value, Scope scope) {
+    string cacheKey(getCacheKey(key, scope));
+
+    scoped_lock _l(_mutex);
+    _storage.setBoolean(key, value, scope);
+    if (cacheKey.empty()) return *this;
+
+    invalidateLocked(cacheKey);
+    Entry& entry = _cache[cacheKey];
+    entry.booleanLoaded = true;
+    entry.booleanValue = value;
+    entry.hasLoaded = true;
+    entry.hasValue = true;
+    return *this;
+}
+
+bool
+CachingStorage::remove(const std::string& key, Scope scope) {
+    string cacheKey(getCacheKey(key, scope));
+
+    scoped_lock _l(_mutex);
+    bool removed = _storage.remove(key, scope);
+    if (!cacheKey.empty()) invalidateLocked(cacheKey);
+    return removed;
+}
+
+IStorage&
+CachingStorage::clear(Scope scope) {
+    string cacheKey(getCacheKey("", scope));
+
+    scoped_lock _l(_mutex);
+    _storage.clear(scope);
+    if (!cacheKey.empty()) invalidateLocked(cacheKey);
+    return *this;
+}
+
+void
+CachingStorage::invalidate(const std::string& key, Scope scope) {
+    string cacheKey(getCacheKey(key, scope));
+    if (cacheKey.empty()) return;
+
+    scoped_lock _l(_mutex);
+    invalidateLocked(cacheKey);
+}
+
+}  // namespace BranchIO
@@ -0,0 +1,122 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_CACHINGSTORAGE_H__
+#define BRANCHIO_UTIL_CACHINGSTORAGE_H__
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "BranchIO/Util/IStorage.h"
+
+namespace BranchIO {
+
+/**
+ * (Internal) In-memory cache in front of another IStorage.
+ *
+ * Values are read from the underlying storage the first time they are
+ * requested and kept in a hash map, keyed by scope, prefix and key. Missing
+ * keys are cached too. Writes go to the underlying storage immediately and
+ * update the cache, so the two never disagree about values written through
+ * this object. Call invalidate() if the underlying storage may have been
+ * changed some other way.
+ */
+class CachingStorage : public virtual IStorage {
+ public:
+    /**
+     * Singleton accessor. Caches the WindowsStorage singleton.
+     * @return the single CachingStorage instance
+     */
+    static IStorage& instance();
+
+    /**
+     * Constructor.
+     * @param storage the underlying storage. Must outlive this object.
+     */
+    explicit CachingStorage(IStorage& storage);
+
+    /**
+     * @copydoc IStorage::getDefaultScope
+     */
+    Scope getDefaultScope() const;
+
+    /**
+     * @copydoc IStorage::setDefaultScope
+     */
+    IStorage& setDefaultScope(Scope scope);
+
+    std::string getPrefix() const;
+    IStorage& setPrefix(const std::string& prefix);
+
+    /**
+     * @copydoc IStorage::has
+     */
+    bool has(const std::string& key, Scope scope = Default) const;
+
+    /**
+     * @copydoc IStorage::getString
+     */
+    std::string getString(const std::string& key, const std::string& defaultValue = "", Scope scope = Default) const;
+
+    /**
+     * @copydoc IStorage::setString
+     */
+    IStorage& setString(const std::string& key, const std::string& value, Scope scope = Default);
+
+    /**
+     * @copydoc IStorage::getBoolean
+     */
+    bool getBoolean(const std::string& key, bool defaultValue = false, Scope scope = Default) const;
+
+    /**
+     * @copydoc IStorage::setBoolean
+     */
+    IStorage& setBoolean(const std::string& key, bool value, Scope scope = Default);
+
+    /**
+     * @copydoc IStorage::remove
+     */
+    bool remove(const std::string& key, Scope scope = Default);
+
+    /**
+     * @copydoc IStorage::clear
+     */
+    IStorage& clear(Scope scope = Default);
+
+    /**
+     * Drop cached values for a key and everything under it, for the current
+     * prefix, so they are read again from the underlying storage.
+     * @param key a key, e.g. "session". Empty to drop everything.
+     * @param scope the scope for this key (optional if default scope set)
+     */
+    void invalidate(const std::string& key = "", Scope scope = Default);
+
+ private:
+    /**
+     * Cached values for one key. Strings and booleans are stored separately
+     * by the underlying storage, so each is loaded on its own.
+     */
+    struct Entry {
+        bool stringLoaded = false;
+        std::optional<std::string> stringValue;
+        bool booleanLoaded = false;
+        std::optional<bool> booleanValue;
+        bool hasLoaded = false;
+        bool hasValue = false;
+    };
+
+    std::string getCacheKey(const std::string& key, Scope scope) const;
+    void invalidateLocked(const std::string& cacheKey);
+
+    CachingStorage(const CachingStorage& o);
+    CachingStorage& operator=(const CachingStorage& o);
+
+    IStorage& _storage;
+    mutable std::mutex _mutex;
+    mutable std::unordered_map<std::string, Entry> _cache;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_CACHINGSTORAGE_H__
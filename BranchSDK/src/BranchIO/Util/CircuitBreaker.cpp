@@ -0,0 +1,107 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "BranchIO/Util/CircuitBreaker.h"
+
+#include <algorithm>
+
+#include "BranchIO/Util/Log.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+const unsigned int CircuitBreaker::DefaultFailureThreshold = 5;
+const int32_t CircuitBreaker::DefaultOpenMillis = 30000;
+
+// How often to ask again while another request is probing
+static const int32_t ProbeWaitMillis = 1000;
+
+CircuitBreaker&
+CircuitBreaker::instance() {
+    static CircuitBreaker _instance;
+    return _instance;
+}
+
+CircuitBreaker::CircuitBreaker(unsigned int failureThreshold, int32_t openMillis) :
+    _failureThreshold(max(1u, failureThreshold)),
+    _openDuration(chrono::milliseconds(openMillis)),
+    _state(Closed),
+    _failureCount(0),
+    _probeInFlight(false) {
+}
+
+int32_t
+CircuitBreaker::acquire() {
+    scoped_lock _l(_mutex);
+    if (_state == Closed) return 0;
+
+    if (_state == Open) {
+        Clock::time_point now = Clock::now();
+        if (now < _openUntil) {
+            auto remaining = chrono::duration_cast<chrono::milliseconds>(_openUntil - now).count();
+            return max<int32_t>(1, static_cast<int32_t>(remaining));
+        }
+
+        BRANCH_LOG_D("Circuit breaker half-open. Sending a probe request.");
+        _state = HalfOpen;
+        _probeInFlight = false;
+    }
+
+    if (_probeInFlight) return ProbeWaitMillis;
+
+    _probeInFlight = true;
+    return 0;
+}
+
+void
+CircuitBreaker::recordSuccess() {
+    scoped_lock _l(_mutex);
+    if (_state != Closed) {
+        BRANCH_LOG_I("Circuit breaker closed.");
+    }
+
+    _state = Closed;
+    _failureCount = 0;
+    _probeInFlight = false;
+}
+
+void
+CircuitBreaker::recordFailure() {
+    scoped_lock _l(_mutex);
+    switch (_state) {
+        case Closed:
+            if (++ _failureCount >= _failureThreshold) openLocked();
+            break;
+
+        case HalfOpen:
+            openLocked();
+            break;
+
+        default:
+            // A request sent before the breaker opened
+            break;
+    }
+}
+
+void
+CircuitBreaker::release() {
+    scoped_lock _l(_mutex);
+    if (_state == HalfOpen) _probeInFlight = false;
+}
+
+CircuitBreaker::State
+CircuitBreaker::getState() const {
+    scoped_lock _l(_mutex);
+    return _state;
+}
+
+void
+CircuitBreaker::openLocked() {
+    BRANCH_LOG_W("Circuit breaker open. Requests paused for "
+        << chrono::duration_cast<chrono::milliseconds>(_openDuration).count() << " ms.");
+    _state = Open;
+    _openUntil = Clock::now() + _openDuration;
+    _probeInFlight = false;
+}
+
+}  // namespace BranchIO
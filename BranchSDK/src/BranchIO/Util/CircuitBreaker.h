@@ -0,0 +1,105 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_CIRCUITBREAKER_H__
+#define BRANCHIO_UTIL_CIRCUITBREAKER_H__
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Stops requests to the API while it is failing.
+ *
+ * The breaker starts Closed, and requests are sent normally. After a number
+ * of consecutive failures it opens, and no requests are sent for a while.
+ * Then it is HalfOpen: a single request is sent as a probe. If it succeeds,
+ * the breaker closes again. If it fails, the breaker opens again.
+ *
+ * Every Request sends through the same breaker, so during an outage queued
+ * requests wait instead of each using up its own retries.
+ */
+class CircuitBreaker {
+ public:
+    /// Clock used for the open period
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * State of the breaker
+     */
+    enum State {
+        /// Requests are sent.
+        Closed,
+        /// Requests wait.
+        Open,
+        /// One request is sent to see if the API has recovered.
+        HalfOpen
+    };
+
+    /// Default number of consecutive failures that open the breaker
+    static const unsigned int DefaultFailureThreshold;
+
+    /// Default time the breaker stays open, in ms
+    static const int32_t DefaultOpenMillis;
+
+    /**
+     * @return the breaker shared by all requests
+     */
+    static CircuitBreaker& instance();
+
+    /**
+     * Constructor.
+     * @param failureThreshold number of consecutive failures that open the breaker
+     * @param openMillis time the breaker stays open, in ms
+     */
+    explicit CircuitBreaker(
+        unsigned int failureThreshold = DefaultFailureThreshold,
+        int32_t openMillis = DefaultOpenMillis);
+
+    /**
+     * Ask to send a request. If this returns 0, the caller must report the
+     * result with recordSuccess(), recordFailure() or release().
+     * @return 0 if the request may be sent now, otherwise the time to wait
+     *         before asking again, in ms
+     */
+    int32_t acquire();
+
+    /**
+     * Report that the API responded.
+     */
+    void recordSuccess();
+
+    /**
+     * Report that a request failed and may be retried.
+     */
+    void recordFailure();
+
+    /**
+     * Report that a request was abandoned without a result, e.g. on shutdown.
+     */
+    void release();
+
+    /**
+     * @return the current state
+     */
+    State getState() const;
+
+ private:
+    CircuitBreaker(const CircuitBreaker& o);
+    CircuitBreaker& operator=(const CircuitBreaker& o);
+
+    void openLocked();
+
+    mutable std::mutex _mutex;
+    const unsigned int _failureThreshold;
+    const Clock::duration _openDuration;
+    State _state;
+    unsigned int _failureCount;
+    Clock::time_point _openUntil;
+    bool _probeInFlight;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_CIRCUITBREAKER_H__
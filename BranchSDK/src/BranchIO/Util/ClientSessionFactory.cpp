@@ -0,0 +1,55 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "ClientSessionFactory.h"
+
+#include <mutex>
+#include <string>
+
+#include "APIClientSession.h"
+#include "CurlClientSession.h"
+#include "BranchIO/Defines.h"
+#include "BranchIO/Util/Log.h"
+
+namespace BranchIO {
+
+static std::mutex _defaultMutex;
+
+static Configuration&
+getDefaultConfiguration() {
+    static Configuration _configuration;
+    return _configuration;
+}
+
+std::unique_ptr<IClientSession>
+ClientSessionFactory::create(const Configuration& configuration, unsigned int maxConnections) {
+    std::string urlBase(configuration.getApiUrlBase());
+    if (urlBase.empty()) urlBase = BRANCH_IO_URL_BASE;
+
+    if (configuration.getHttpBackend() == Configuration::HttpBackendCurl) {
+#ifdef BRANCHIO_USE_CURL
+        return std::unique_ptr<IClientSession>(new CurlClientSession(urlBase, maxConnections, configuration.isHttp2Enabled(), configuration.getCompressionThreshold()));
+#else
+        BRANCH_LOG_W("Built without BRANCHIO_USE_CURL. Using the WinRT HTTP backend.");
+#endif  // BRANCHIO_USE_CURL
+    }
+
+    return std::unique_ptr<IClientSession>(new APIClientSession(urlBase, maxConnections, configuration.isHttp2Enabled(), configuration.getCompressionThreshold()));
+}
+
+std::unique_ptr<IClientSession>
+ClientSessionFactory::create(unsigned int maxConnections) {
+    Configuration configuration;
+    {
+        std::scoped_lock _l(_defaultMutex);
+        configuration = getDefaultConfiguration();
+    }
+    return create(configuration, maxConnections);
+}
+
+void
+ClientSessionFactory::setDefaultConfiguration(const Configuration& configuration) {
+    std::scoped_lock _l(_defaultMutex);
+    getDefaultConfiguration() = configuration;
+}
+
+}  // namespace BranchIO
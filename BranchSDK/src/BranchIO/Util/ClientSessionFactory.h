@@ -0,0 +1,47 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_CLIENTSESSIONFACTORY_H__
+#define BRANCHIO_UTIL_CLIENTSESSIONFACTORY_H__
+
+#include <memory>
+
+#include "BranchIO/Configuration.h"
+#include "IClientSession.h"
+
+namespace BranchIO {
+
+/**
+ * (Internal) Creates the IClientSession for the HTTP backend selected in a
+ * Configuration.
+ */
+class ClientSessionFactory {
+ public:
+    /**
+     * Create a client session for the API.
+     * @param configuration selects the HTTP backend and base URL
+     * @param maxConnections Maximum number of simultaneous connections to the server.
+     * @return the new session
+     * @throw whatever the session's constructor throws
+     */
+    static std::unique_ptr<IClientSession> create(const Configuration& configuration, unsigned int maxConnections);
+
+    /**
+     * Create a client session using the configuration passed to
+     * setDefaultConfiguration(). Used for requests that are not tied to a
+     * Branch instance, like short links.
+     * @param maxConnections Maximum number of simultaneous connections to the server.
+     * @return the new session
+     */
+    static std::unique_ptr<IClientSession> create(unsigned int maxConnections);
+
+    /**
+     * Set the configuration used by create(unsigned int). Called from
+     * Branch::create.
+     * @param configuration the configuration
+     */
+    static void setDefaultConfiguration(const Configuration& configuration);
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_CLIENTSESSIONFACTORY_H__
@@ -0,0 +1,411 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "CurlClientSession.h"
+
+#ifdef BRANCHIO_USE_CURL
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <ctime>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "BranchIO/IRequestCallback.h"
+#include "BranchIO/JSONObject.h"
+#include "BranchIO/Util/Gzip.h"
+#include "BranchIO/Util/Log.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+// Longest time the I/O thread waits for socket activity before checking timeouts
+static const int POLL_TIMEOUT_MILLIS = 1000;
+
+// Longest time to wait for a connection, and for a whole request and
+// response. Windows.Web.Http.HttpClient sets no timeouts of its own, so these
+// follow the WinINet defaults it runs on: 60 s to connect, then 30 s for the
+// response.
+static const long CONNECT_TIMEOUT_MILLIS = 60000;
+static const long REQUEST_TIMEOUT_MILLIS = 90000;
+
+/**
+ * A single request and its response. Owned by the thread in post(). The I/O
+ * thread only touches it between picking it up from _submitted and
+ * complete().
+ */
+struct CurlClientSession::Transfer {
+    Transfer() :
+        easy(curl_easy_init()),
+        headers(nullptr),
+        code(CURLE_OK),
+        done(false) {
+        errorBuffer[0] = '\0';
+    }
+
+    ~Transfer() {
+        if (easy) curl_easy_cleanup(easy);
+        if (headers) curl_slist_free_all(headers);
+    }
+
+    CURL* easy;
+    curl_slist* headers;
+    std::string compressedBody;
+    std::string response;
+    std::string reason;
+    std::string requestId;
+    std::string retryAfter;
+    char errorBuffer[CURL_ERROR_SIZE];
+    CURLcode code;
+    bool done;
+};
+
+/**
+ * Initialize libcurl once per process. Never cleaned up, since sessions
+ * may outlive static destruction.
+ */
+static void
+initCurl() {
+    static once_flag once;
+    call_once(once, []() {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+    });
+}
+
+/**
+ * @param value value of a Retry-After header
+ * @return the delay in ms, or -1 if there is none
+ */
+static int32_t
+getRetryAfterMillis(const string& value) {
+    if (value.empty()) return -1;
+
+    // Either a number of seconds or a date
+    long long delaySeconds = -1;
+    if (all_of(value.begin(), value.end(), [](char c) { return isdigit(static_cast<unsigned char>(c)); })) {
+        delaySeconds = value.size() > 9 ? INT32_MAX : stoll(value);
+    } else {
+        time_t date = curl_getdate(value.c_str(), nullptr);
+        if (date < 0) return -1;
+        delaySeconds = max<long long>(date - time(nullptr), 0);
+    }
+
+    return static_cast<int32_t>(min<long long>(delaySeconds * 1000, INT32_MAX));
+}
+
+/**
+ * @param s a header line
+ * @return s without leading and trailing whitespace, including CRLF
+ */
+static string
+trim(const string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == string::npos) return string();
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+CurlClientSession::CurlClientSession(const std::string& urlBase, unsigned int maxConnections, bool http2, size_t compressionThreshold) :
+    _urlBase(urlBase),
+    _http2(http2),
+    _compressionThreshold(compressionThreshold),
+    _shuttingDown(false),
+    _multi(nullptr) {
+    initCurl();
+
+    _multi = curl_multi_init();
+    if (!_multi) throw runtime_error("Failed to initialize libcurl");
+
+    long connections = maxConnections > 0 ? maxConnections : 1;
+    curl_multi_setopt(_multi, CURLMOPT_MAX_HOST_CONNECTIONS, connections);
+    curl_multi_setopt(_multi, CURLMOPT_MAXCONNECTS, connections);
+    curl_multi_setopt(_multi, CURLMOPT_PIPELINING, http2 ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+
+    _thread = thread(&CurlClientSession::run, this);
+}
+
+CurlClientSession::~CurlClientSession() {
+    stop();
+    if (_thread.joinable()) _thread.join();
+    curl_multi_cleanup(_multi);
+}
+
+void
+CurlClientSession::stop() {
+    {
+        std::scoped_lock _l(_mutex);
+        // Ignore subsequent calls
+        if (_shuttingDown) return;
+
+        _shuttingDown = true;
+    }
+
+    // The I/O thread aborts everything in flight and exits.
+    curl_multi_wakeup(_multi);
+}
+
+bool
+CurlClientSession::post(
+    const std::string& path,
+    const JSONObject& jsonPayload,
+    IRequestCallback& callback,
+    JSONObject& result) {
+    RetryInfo retryInfo;
+    return post(path, jsonPayload, callback, result, retryInfo);
+}
+
+bool
+CurlClientSession::post(
+    const std::string& path,
+    const JSONObject& jsonPayload,
+    IRequestCallback& callback,
+    JSONObject& result,
+    RetryInfo& retryInfo) {
+    if (isShuttingDown()) return false;
+
+    /* ----- Set up the HTTP request ----- */
+    Transfer transfer;
+    if (!transfer.easy) {
+        callback.onStatus(0, 0, "Failed to initialize libcurl");
+        return false;
+    }
+
+    string url(resolveUrl(_urlBase, path));
+
+    // Serialized once into a buffer kept by each calling thread, which is
+    // sent as it is. post() returns only after the transfer is complete.
+    static thread_local string body;
+    jsonPayload.stringify(body);
+    const string* postBody = &body;
+    BRANCH_LOG_D("URI: " << path);
+    BRANCH_LOG_D("Request body: " << body);
+
+    transfer.headers = curl_slist_append(transfer.headers, "Content-Type: application/json; charset=utf-8");
+    transfer.headers = curl_slist_append(transfer.headers, "Accept: application/json");
+    // Send the body without waiting for 100 Continue
+    transfer.headers = curl_slist_append(transfer.headers, "Expect:");
+
+    if (_compressionThreshold > 0 && body.size() >= _compressionThreshold) {
+        string compressed(Gzip::compress(body));
+        if (compressed.size() < body.size()) {
+            BRANCH_LOG_D("Compressed body: " << body.size() << " -> " << compressed.size() << " bytes");
+            transfer.compressedBody.swap(compressed);
+            postBody = &transfer.compressedBody;
+            transfer.headers = curl_slist_append(transfer.headers, "Content-Encoding: gzip");
+        }
+    }
+
+    CURL* easy = transfer.easy;
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(easy, CURLOPT_POST, 1L);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(postBody->size()));
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, postBody->data());
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer.headers);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, &CurlClientSession::onBody);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer);
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, &CurlClientSession::onHeader);
+    curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, &transfer);
+    curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer.errorBuffer);
+    curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    // A stalled server fails the request with CURLE_OPERATION_TIMEDOUT, which is retried
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, CONNECT_TIMEOUT_MILLIS);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, REQUEST_TIMEOUT_MILLIS);
+    if (_http2) {
+        // HTTP/2 over TLS, negotiated with ALPN. Prefer waiting for a stream on
+        // the existing connection over opening another one.
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    } else {
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+    }
+
+    /* ----- Send the request and body ----- */
+    {
+        std::unique_lock<std::mutex> _l(_mutex);
+        if (_shuttingDown) return false;
+        _submitted.push_back(&transfer);
+    }
+    curl_multi_wakeup(_multi);
+
+    {
+        std::unique_lock<std::mutex> _l(_mutex);
+        _completed.wait(_l, [&transfer]() { return transfer.done; });
+        if (_shuttingDown) return false;
+    }
+
+    if (transfer.code != CURLE_OK) {
+        string message(transfer.errorBuffer[0] ? transfer.errorBuffer : curl_easy_strerror(transfer.code));
+        BRANCH_LOG_W("Request failed. " << message);
+        callback.onStatus(0, 0, message);
+        return false;
+    }
+
+    BRANCH_LOG_D("Request sent. Waiting for response.");
+    return processResponse(callback, result, transfer, retryInfo);
+}
+
+bool
+CurlClientSession::processResponse(
+    IRequestCallback& callback,
+    JSONObject& result,
+    const Transfer& transfer,
+    RetryInfo& retryInfo) {
+
+    if (isShuttingDown()) return false;
+
+    long status = 0;
+    curl_easy_getinfo(transfer.easy, CURLINFO_RESPONSE_CODE, &status);
+
+    if (!transfer.requestId.empty()) {
+        BRANCH_LOG_D("[" << transfer.requestId << "] " << status << " " << transfer.reason);
+    }
+    else {
+        BRANCH_LOG_D(status << " " << transfer.reason);
+    }
+
+    if (status == 200) {
+        try {
+            result = JSONObject::parse(transfer.response);
+            if (!result.isEmpty())
+                BRANCH_LOG_D("Response : " << result.stringify());
+            callback.onSuccess(0, result);
+
+            return true;
+        }
+        catch (std::exception &) {
+            // Parsing Error.
+            callback.onStatus(0, 0, "Error parsing result");
+        }
+    }
+    else {
+        /*
+         * Report HTTP status != 200 as an error. Pass the status
+         * code as the error argument.
+         */
+        callback.onStatus(0, static_cast<int>(status), transfer.reason);
+        if (isShuttingDown()) return false;
+
+        if (status < 500 && status != 429) {
+            // We don't want to retry this.  Call the error handler and return "true" to indicate that this was handled.
+            callback.onError(0, static_cast<int>(status), transfer.reason);
+            return true;
+        }
+
+        // Typically sent with 429 and 503
+        retryInfo.retryAfterMillis = getRetryAfterMillis(transfer.retryAfter);
+        if (retryInfo.retryAfterMillis >= 0) {
+            BRANCH_LOG_D("Retry-After: " << retryInfo.retryAfterMillis << " ms");
+        }
+    }
+
+    return false;
+}
+
+void
+CurlClientSession::complete(Transfer* transfer, CURLcode code) {
+    {
+        std::scoped_lock _l(_mutex);
+        transfer->code = code;
+        transfer->done = true;
+    }
+    _completed.notify_all();
+}
+
+void
+CurlClientSession::run() {
+    // Transfers added to _multi and not yet complete. Only used on this thread.
+    unordered_set<Transfer*> active;
+    vector<Transfer*> submitted;
+
+    while (true) {
+        {
+            std::scoped_lock _l(_mutex);
+            if (_shuttingDown) break;
+            submitted.swap(_submitted);
+        }
+
+        for (Transfer* transfer : submitted) {
+            CURLMcode mc = curl_multi_add_handle(_multi, transfer->easy);
+            if (mc == CURLM_OK) {
+                active.insert(transfer);
+            } else {
+                complete(transfer, CURLE_FAILED_INIT);
+            }
+        }
+        submitted.clear();
+
+        int running = 0;
+        curl_multi_perform(_multi, &running);
+
+        CURLMsg* message;
+        int remaining = 0;
+        while ((message = curl_multi_info_read(_multi, &remaining))) {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            CURLcode code = message->data.result;
+            curl_multi_remove_handle(_multi, message->easy_handle);
+            active.erase(transfer);
+            complete(transfer, code);
+        }
+
+        curl_multi_poll(_multi, nullptr, 0, POLL_TIMEOUT_MILLIS, nullptr);
+    }
+
+    // Shutting down. post() cannot submit anything more now.
+    {
+        std::scoped_lock _l(_mutex);
+        submitted.swap(_submitted);
+    }
+    for (Transfer* transfer : active) {
+        curl_multi_remove_handle(_multi, transfer->easy);
+        complete(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+    for (Transfer* transfer : submitted) {
+        complete(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+}
+
+size_t
+CurlClientSession::onBody(char* data, size_t size, size_t count, void* transfer) {
+    static_cast<Transfer*>(transfer)->response.append(data, size * count);
+    return size * count;
+}
+
+size_t
+CurlClientSession::onHeader(char* data, size_t size, size_t count, void* userdata) {
+    Transfer* transfer = static_cast<Transfer*>(userdata);
+    string line(trim(string(data, size * count)));
+
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        // Status line, e.g. "HTTP/1.1 200 OK". Starts a new set of headers
+        // after a redirect or an interim response.
+        size_t code = line.find(' ');
+        size_t reason = code == string::npos ? string::npos : line.find(' ', code + 1);
+        transfer->reason = reason == string::npos ? string() : line.substr(reason + 1);
+        transfer->requestId.clear();
+        transfer->retryAfter.clear();
+        return size * count;
+    }
+
+    size_t colon = line.find(':');
+    if (colon == string::npos) return size * count;
+
+    string name(line.substr(0, colon));
+    transform(name.begin(), name.end(), name.begin(), [](char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); });
+    if (name == "x-branch-request-id") {
+        transfer->requestId = trim(line.substr(colon + 1));
+    } else if (name == "retry-after") {
+        transfer->retryAfter = trim(line.substr(colon + 1));
+    }
+    return size * count;
+}
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_USE_CURL
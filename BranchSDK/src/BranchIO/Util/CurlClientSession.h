@@ -0,0 +1,128 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_CURLCLIENTSESSION_H__
+#define BRANCHIO_UTIL_CURLCLIENTSESSION_H__
+
+#ifdef BRANCHIO_USE_CURL
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "BranchIO/fwd.h"
+#include "IClientSession.h"
+
+namespace BranchIO {
+
+/**
+ * (Internal) Client session built on the libcurl multi interface, for
+ * platforms without WinRT.
+ *
+ * All transfers are driven by one I/O thread with non-blocking sockets.
+ * post() hands its transfer to that thread and waits for it to finish, so
+ * it may be called concurrently from several threads. Connections are kept
+ * in the multi handle's connection cache and reused between requests.
+ *
+ * Only available when built with BRANCHIO_USE_CURL.
+ */
+class CurlClientSession
+    : public virtual IClientSession {
+ public:
+    /**
+     * Constructor.
+     * @param urlBase Base endpoint for the session conversation.
+     * @param maxConnections Maximum number of simultaneous connections to the server.
+     * @param http2 true to use HTTP/2 over TLS when the server supports it.
+     *        Concurrent requests are then multiplexed over one connection.
+     * @param compressionThreshold Minimum size of a request body sent gzip-compressed, or 0 for never.
+     * @throw std::runtime_error if libcurl could not be initialized
+     */
+    explicit CurlClientSession(const std::string& urlBase, unsigned int maxConnections = 1, bool http2 = false, size_t compressionThreshold = 0);
+
+    /**
+     * Destructor. Stops the session and waits for the I/O thread.
+     */
+    ~CurlClientSession();
+
+    /**
+     * @return the urlBase.
+     */
+    std::string getUrlBase() const {
+        return _urlBase;
+    }
+
+    bool post(
+        const std::string& path,
+        const JSONObject& jsonPayload,
+        IRequestCallback& callback,
+        JSONObject& result);
+
+    /**
+     * @copydoc IClientSession::post(const std::string&, const JSONObject&, IRequestCallback&, JSONObject&, RetryInfo&)
+     */
+    bool post(
+        const std::string& path,
+        const JSONObject& jsonPayload,
+        IRequestCallback& callback,
+        JSONObject& result,
+        RetryInfo& retryInfo);
+
+    /**
+     * Stop the session. Any requests in flight are aborted, and subsequent
+     * calls to post() return false immediately.
+     */
+    void stop();
+
+    /**
+     * Thread-safe method to determine if stop() has been called.
+     * @return true if shutting down, false otherwise
+     */
+    bool isShuttingDown() const {
+        std::scoped_lock _l(_mutex);
+        return _shuttingDown;
+    }
+
+ private:
+    struct Transfer;
+
+    CurlClientSession(const CurlClientSession& o);
+    CurlClientSession& operator=(const CurlClientSession& o);
+
+    /**
+     * Handle the response to a completed transfer.
+     * 5xx responses and 429 Too Many Requests may be retried.
+     */
+    bool processResponse(
+        IRequestCallback& callback,
+        JSONObject& result,
+        const Transfer& transfer,
+        RetryInfo& retryInfo);
+
+    void run();
+    void complete(Transfer* transfer, CURLcode code);
+
+    static size_t onBody(char* data, size_t size, size_t count, void* transfer);
+    static size_t onHeader(char* data, size_t size, size_t count, void* transfer);
+
+    mutable std::mutex _mutex;
+    // Signaled when a transfer completes
+    std::condition_variable _completed;
+    std::string const _urlBase;
+    bool const _http2;
+    size_t const _compressionThreshold;
+    bool _shuttingDown;
+    CURLM* _multi;
+    // Transfers waiting to be added to _multi by the I/O thread
+    std::vector<Transfer*> _submitted;
+    std::thread _thread;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_USE_CURL
+
+#endif  // BRANCHIO_UTIL_CURLCLIENTSESSION_H__
@@ -0,0 +1,341 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "DurableQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "CRC32.h"
+#include "Log.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+const size_t DurableQueue::CompactionThreshold = 256;
+
+namespace {
+
+// "BRQ1"
+const uint32_t RecordMagic = 0x31515242;
+
+// magic + type + id + payload length
+const size_t RecordHeaderSize = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t);
+const size_t RecordTrailerSize = sizeof(uint32_t);
+
+template <typename T>
+void appendValue(string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T readValue(const string& buffer, size_t offset) {
+    T value;
+    memcpy(&value, buffer.data() + offset, sizeof(value));
+    return value;
+}
+
+bool readFile(HANDLE hFile, string& contents) {
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size)) return false;
+
+    contents.resize(static_cast<size_t>(size.QuadPart));
+    size_t offset = 0;
+    while (offset < contents.size()) {
+        DWORD toRead = static_cast<DWORD>(min<size_t>(contents.size() - offset, 1 << 20));
+        DWORD bytesRead = 0;
+        if (!ReadFile(hFile, &contents[offset], toRead, &bytesRead, NULL) || bytesRead == 0) {
+            return false;
+        }
+        offset += bytesRead;
+    }
+    return true;
+}
+
+bool seek(HANDLE hFile, LONGLONG offset, DWORD method) {
+    LARGE_INTEGER distance;
+    distance.QuadPart = offset;
+    return SetFilePointerEx(hFile, distance, NULL, method) != FALSE;
+}
+
+}  // namespace
+
+DurableQueue::DurableQueue(const std::wstring& path, unsigned int syncCount, unsigned int syncIntervalMillis) :
+    _path(path),
+    _syncCount(max(syncCount, 1u)),
+    _syncInterval(syncIntervalMillis),
+    _hFile(INVALID_HANDLE_VALUE),
+    _nextId(1),
+    _deadCount(0),
+    _unsyncedCount(0),
+    _stopping(false) {
+}
+
+DurableQueue::~DurableQueue() {
+    try {
+        {
+            scoped_lock _l(_mutex);
+            _stopping = true;
+        }
+        _syncNeeded.notify_one();
+        if (_syncThread.joinable()) _syncThread.join();
+
+        scoped_lock _l(_mutex);
+        close();
+    }
+    catch (...) {
+    }
+}
+
+bool
+DurableQueue::isOpen() const {
+    scoped_lock _l(_mutex);
+    return _hFile != INVALID_HANDLE_VALUE;
+}
+
+unsigned int
+DurableQueue::getUnsyncedCount() const {
+    scoped_lock _l(_mutex);
+    return _unsyncedCount;
+}
+
+bool
+DurableQueue::open(std::vector<Record>& pending) {
+    scoped_lock _l(_mutex);
+    close();
+
+    _hFile = CreateFileW(_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (_hFile == INVALID_HANDLE_VALUE) {
+        BRANCH_LOG_E("Unable to open event queue file. Error " << GetLastError());
+        return false;
+    }
+
+    string contents;
+    if (!readFile(_hFile, contents)) {
+        BRANCH_LOG_E("Unable to read event queue file. Error " << GetLastError());
+        close();
+        return false;
+    }
+
+    _live.clear();
+    _deadCount = 0;
+    _nextId = 1;
+
+    size_t offset = 0;
+    while (contents.size() - offset >= RecordHeaderSize + RecordTrailerSize) {
+        if (readValue<uint32_t>(contents, offset) != RecordMagic) break;
+
+        uint8_t type = readValue<uint8_t>(contents, offset + 4);
+        uint64_t id = readValue<uint64_t>(contents, offset + 5);
+        uint32_t length = readValue<uint32_t>(contents, offset + 13);
+
+        if (contents.size() - offset - RecordHeaderSize - RecordTrailerSize < length) break;
+
+        uint32_t checksum = readValue<uint32_t>(contents, offset + RecordHeaderSize + length);
+        if (CRC32::compute(contents.data() + offset, RecordHeaderSize + length) != checksum) break;
+
+        if (type == APPEND) {
+            _live[id] = contents.substr(offset + RecordHeaderSize, length);
+        } else if (type == ACK && _live.erase(id) > 0) {
+            ++ _deadCount;
+        }
+        _nextId = max(_nextId, id + 1);
+
+        offset += RecordHeaderSize + length + RecordTrailerSize;
+    }
+
+    if (offset < contents.size()) {
+        // Torn write or corruption. Everything after the last good record is dropped.
+        BRANCH_LOG_W("Event queue file truncated after " << offset << " of " << contents.size() << " bytes.");
+        if (!seek(_hFile, static_cast<LONGLONG>(offset), FILE_BEGIN) || !SetEndOfFile(_hFile)) {
+            BRANCH_LOG_E("Unable to truncate event queue file. Error " << GetLastError());
+            close();
+            return false;
+        }
+    }
+
+    if (_deadCount > 0) {
+        compactLocked();
+    }
+
+    if (_hFile == INVALID_HANDLE_VALUE || !seek(_hFile, 0, FILE_END)) {
+        close();
+        return false;
+    }
+
+    pending.clear();
+    pending.reserve(_live.size());
+    for (const auto& entry : _live) {
+        pending.push_back(Record{ entry.first, entry.second });
+    }
+
+    if (!_syncThread.joinable()) {
+        _syncThread = thread(&DurableQueue::runSyncThread, this);
+    }
+
+    BRANCH_LOG_D("Event queue file opened with " << pending.size() << " pending records.");
+    return true;
+}
+
+uint64_t
+DurableQueue::append(const std::string& payload) {
+    scoped_lock _l(_mutex);
+    if (_hFile == INVALID_HANDLE_VALUE) return 0;
+
+    uint64_t id = _nextId++;
+    if (!writeRecord(_hFile, APPEND, id, payload)) {
+        BRANCH_LOG_E("Unable to write to event queue file. Error " << GetLastError());
+        return 0;
+    }
+
+    _live[id] = payload;
+    onRecordWritten();
+    return id;
+}
+
+void
+DurableQueue::acknowledge(uint64_t id) {
+    scoped_lock _l(_mutex);
+    if (_hFile == INVALID_HANDLE_VALUE || _live.erase(id) == 0) return;
+
+    if (!writeRecord(_hFile, ACK, id, string())) {
+        BRANCH_LOG_E("Unable to write to event queue file. Error " << GetLastError());
+        return;
+    }
+
+    ++ _deadCount;
+    onRecordWritten();
+
+    if (_deadCount >= CompactionThreshold && _deadCount > _live.size()) {
+        compactLocked();
+    }
+}
+
+void
+DurableQueue::sync() {
+    scoped_lock _l(_mutex);
+    syncLocked();
+}
+
+bool
+DurableQueue::compact() {
+    scoped_lock _l(_mutex);
+    return compactLocked();
+}
+
+bool
+DurableQueue::writeRecord(HANDLE hFile, RecordType type, uint64_t id, const std::string& payload) {
+    string record;
+    record.reserve(RecordHeaderSize + payload.size() + RecordTrailerSize);
+
+    appendValue(record, RecordMagic);
+    appendValue(record, static_cast<uint8_t>(type));
+    appendValue(record, id);
+    appendValue(record, static_cast<uint32_t>(payload.size()));
+    record.append(payload);
+    appendValue(record, CRC32::compute(record.data(), record.size()));
+
+    // One write per record, so a crash leaves at most one torn record at the end.
+    DWORD bytesWritten = 0;
+    return WriteFile(hFile, record.data(), static_cast<DWORD>(record.size()), &bytesWritten, NULL) &&
+        bytesWritten == record.size();
+}
+
+void
+DurableQueue::onRecordWritten() {
+    if (++ _unsyncedCount >= _syncCount) {
+        syncLocked();
+    } else if (_unsyncedCount == 1) {
+        // Start the clock for the background flush.
+        _firstUnsynced = chrono::steady_clock::now();
+        _syncNeeded.notify_one();
+    }
+}
+
+void
+DurableQueue::syncLocked() {
+    if (_hFile == INVALID_HANDLE_VALUE || _unsyncedCount == 0) return;
+
+    FlushFileBuffers(_hFile);
+    _unsyncedCount = 0;
+}
+
+void
+DurableQueue::runSyncThread() {
+    unique_lock<mutex> lock(_mutex);
+    while (!_stopping) {
+        if (_unsyncedCount == 0) {
+            _syncNeeded.wait(lock);
+            continue;
+        }
+
+        // Records written in the meantime are flushed along with these.
+        chrono::steady_clock::time_point due = _firstUnsynced + _syncInterval;
+        if (chrono::steady_clock::now() < due) {
+            _syncNeeded.wait_until(lock, due);
+            continue;
+        }
+
+        syncLocked();
+    }
+}
+
+bool
+DurableQueue::compactLocked() {
+    wstring tempPath(_path);
+    tempPath.append(L".tmp");
+
+    HANDLE hTemp = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hTemp == INVALID_HANDLE_VALUE) {
+        BRANCH_LOG_W("Unable to compact event queue file. Error " << GetLastError());
+        return false;
+    }
+
+    bool success = true;
+    for (const auto& entry : _live) {
+        if (!writeRecord(hTemp, APPEND, entry.first, entry.second)) {
+            success = false;
+            break;
+        }
+    }
+    success = success && FlushFileBuffers(hTemp);
+    CloseHandle(hTemp);
+
+    if (!success) {
+        BRANCH_LOG_W("Unable to compact event queue file. Error " << GetLastError());
+        DeleteFileW(tempPath.c_str());
+        return false;
+    }
+
+    // Replace the queue file. If this fails, keep appending to the old file.
+    syncLocked();
+    CloseHandle(_hFile);
+    success = MoveFileExW(tempPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+    if (!success) {
+        BRANCH_LOG_W("Unable to replace event queue file. Error " << GetLastError());
+        DeleteFileW(tempPath.c_str());
+    } else {
+        _deadCount = 0;
+    }
+
+    _hFile = CreateFileW(_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (_hFile == INVALID_HANDLE_VALUE || !seek(_hFile, 0, FILE_END)) {
+        BRANCH_LOG_E("Unable to reopen event queue file. Error " << GetLastError());
+        close();
+        return false;
+    }
+
+    _unsyncedCount = 0;
+    return success;
+}
+
+void
+DurableQueue::close() {
+    if (_hFile == INVALID_HANDLE_VALUE) return;
+
+    syncLocked();
+    CloseHandle(_hFile);
+    _hFile = INVALID_HANDLE_VALUE;
+}
+
+}  // namespace BranchIO
@@ -0,0 +1,136 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_DURABLEQUEUE_H__
+#define BRANCHIO_UTIL_DURABLEQUEUE_H__
+
+#include <Windows.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Crash-safe, append-only queue file of opaque payloads.
+ *
+ * Each append() writes a checksummed record to the end of the file, and
+ * acknowledge() appends a small record marking an earlier one as done.
+ * Records reach the operating system as soon as they are written, so they
+ * survive a crash of the process. FlushFileBuffers is only called every
+ * syncCount records, or by a background thread syncIntervalMillis after the
+ * first record written since the last flush, so protection against power
+ * loss does not cost a disk flush for every event and the last records of
+ * a burst are not left unflushed until the next write.
+ *
+ * open() returns the records that were never acknowledged. A torn or
+ * corrupt record at the end of the file, e.g. after a crash in the middle
+ * of a write, ends the replay. The file is compacted when it is opened and
+ * whenever acknowledged records outnumber live ones.
+ */
+class DurableQueue {
+ public:
+    /**
+     * A record read back from the queue file.
+     */
+    struct Record {
+        uint64_t id;          ///< Record id, passed to acknowledge()
+        std::string payload;  ///< Payload passed to append()
+    };
+
+    /**
+     * Constructor. Does not touch the file until open() is called.
+     * @param path path of the queue file
+     * @param syncCount number of records written between disk flushes
+     * @param syncIntervalMillis maximum time between disk flushes, in ms
+     */
+    DurableQueue(const std::wstring& path, unsigned int syncCount = 32, unsigned int syncIntervalMillis = 1000);
+
+    /**
+     * Destructor. Stops the background thread, then flushes and closes the
+     * file.
+     */
+    ~DurableQueue();
+
+    /**
+     * Open the queue file, creating it if necessary.
+     * @param pending receives the records not yet acknowledged, in order
+     * @return true on success, false if the file could not be opened
+     */
+    bool open(std::vector<Record>& pending);
+
+    /**
+     * Append a record.
+     * @param payload bytes to store
+     * @return the new record id, or 0 if the queue is not open or the write failed
+     */
+    uint64_t append(const std::string& payload);
+
+    /**
+     * Mark a record as done. It will not be returned by open() again.
+     * @param id record id returned by append() or open()
+     */
+    void acknowledge(uint64_t id);
+
+    /**
+     * Flush all records written so far to disk.
+     */
+    void sync();
+
+    /**
+     * Rewrite the file with only the live records.
+     * @return true on success
+     */
+    bool compact();
+
+    /**
+     * @return true if the queue file is open
+     */
+    bool isOpen() const;
+
+    /**
+     * @return the number of records written since the last disk flush
+     */
+    unsigned int getUnsyncedCount() const;
+
+    /// Minimum number of acknowledged records before the file is compacted
+    static const size_t CompactionThreshold;
+
+ private:
+    enum RecordType : uint8_t {
+        APPEND = 1,
+        ACK = 2
+    };
+
+    bool writeRecord(HANDLE hFile, RecordType type, uint64_t id, const std::string& payload);
+    void onRecordWritten();
+    bool compactLocked();
+    void syncLocked();
+    void close();
+    void runSyncThread();
+
+    mutable std::mutex _mutex;
+    std::wstring const _path;
+    unsigned int const _syncCount;
+    std::chrono::milliseconds const _syncInterval;
+    HANDLE _hFile;
+    uint64_t _nextId;
+    std::map<uint64_t, std::string> _live;
+    size_t _deadCount;
+    unsigned int _unsyncedCount;
+    // When the first record since the last flush was written
+    std::chrono::steady_clock::time_point _firstUnsynced;
+    // Flushes records syncInterval after they were written
+    std::thread _syncThread;
+    std::condition_variable _syncNeeded;
+    bool _stopping;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_DURABLEQUEUE_H__
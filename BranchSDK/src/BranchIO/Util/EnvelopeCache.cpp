@@ -0,0 +1,72 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "EnvelopeCache.h"
+
+#include "BranchIO/AdvertiserInfo.h"
+#include "BranchIO/AppInfo.h"
+#include "BranchIO/Defines.h"
+#include "BranchIO/DeviceInfo.h"
+#include "BranchIO/IPackagingInfo.h"
+#include "BranchIO/JSONObject.h"
+#include "BranchIO/SessionInfo.h"
+#include "BranchIO/Util/Storage.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+static const char *JSONKEY_ADVERTISING_IDS = "advertising_ids";
+
+bool
+EnvelopeCache::Key::operator==(const Key& other) const {
+    return sessionVersion == other.sessionVersion &&
+        deviceVersion == other.deviceVersion &&
+        appVersion == other.appVersion &&
+        advertiserVersion == other.advertiserVersion &&
+        trackingLimited == other.trackingLimited &&
+        identity == other.identity;
+}
+
+std::shared_ptr<const std::string>
+EnvelopeCache::getUserData(IPackagingInfo& packagingInfo) {
+    // Read the versions before the content. If a source changes in between,
+    // the cached text is newer than its key and is simply rebuilt next time.
+    AdvertiserInfo& advertiserInfo = packagingInfo.getAdvertiserInfo();
+
+    Key key;
+    key.sessionVersion = packagingInfo.getSessionInfo().getVersion();
+    key.deviceVersion = packagingInfo.getDeviceInfo().getVersion();
+    key.appVersion = packagingInfo.getAppInfo().getVersion();
+    key.advertiserVersion = advertiserInfo.getVersion();
+    key.trackingLimited = advertiserInfo.isTrackingLimited();
+    key.identity = Storage::instance().getString("session.identity");
+
+    scoped_lock _l(_mutex);
+    if (!_userData || !(key == _key)) {
+        _userData = build(packagingInfo, key);
+        _key = std::move(key);
+    }
+    return _userData;
+}
+
+std::shared_ptr<const std::string>
+EnvelopeCache::build(IPackagingInfo& packagingInfo, const Key& key) {
+    JSONObject userData;
+    userData += packagingInfo.getSessionInfo().toJSON();
+    userData += packagingInfo.getDeviceInfo().toJSON();
+    userData += packagingInfo.getAppInfo().toJSON();
+
+    // Advertising Ids
+    JSONObject adInfo = packagingInfo.getAdvertiserInfo().toJSON();
+    if (!key.trackingLimited && adInfo.size() > 0) {
+        userData.set(JSONKEY_ADVERTISING_IDS, adInfo);
+    }
+    userData.set(Defines::JSONKEY_APP_LAT_V2, (key.trackingLimited ? 1 : 0));
+
+    if (!key.identity.empty())
+        userData.set(Defines::JSONKEY_APP_DEVELOPER_IDENTITY, key.identity);
+
+    return make_shared<const string>(userData.stringify());
+}
+
+}  // namespace BranchIO
@@ -0,0 +1,57 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_ENVELOPECACHE_H__
+#define BRANCHIO_UTIL_ENVELOPECACHE_H__
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "BranchIO/fwd.h"
+
+namespace BranchIO {
+
+/**
+ * (Internal) Cache of the serialized user_data block sent with V2 events.
+ *
+ * The block is built from the session, device, app and advertiser info and
+ * the developer identity, which rarely change once the SDK is running. The
+ * serialized text is kept along with the version of each source it was built
+ * from and is only rebuilt when one of them changes, so packaging an event
+ * normally just shares the cached text.
+ */
+class EnvelopeCache {
+ public:
+    /**
+     * Get the serialized user_data block for the current state.
+     * @param packagingInfo source of the session, device, app and advertiser info
+     * @return JSON text for the user_data object
+     */
+    std::shared_ptr<const std::string> getUserData(IPackagingInfo& packagingInfo);
+
+ private:
+    /**
+     * Versions of everything the user_data block is built from.
+     */
+    struct Key {
+        uint64_t sessionVersion = 0;
+        uint64_t deviceVersion = 0;
+        uint64_t appVersion = 0;
+        uint64_t advertiserVersion = 0;
+        bool trackingLimited = false;
+        std::string identity;
+
+        bool operator==(const Key& other) const;
+    };
+
+    static std::shared_ptr<const std::string> build(IPackagingInfo& packagingInfo, const Key& key);
+
+    std::mutex _mutex;
+    Key _key;
+    std::shared_ptr<const std::string> _userData;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_ENVELOPECACHE_H__
@@ -0,0 +1,137 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "EventBatch.h"
+
+#include "BranchIO/JSONObject.h"
+#include "BranchIO/Util/Log.h"
+
+#include <algorithm>
+
+namespace BranchIO {
+
+EventBatch::EventBatch(Clock::time_point deadline) :
+    _byteCount(0),
+    _deadline(deadline),
+    _expiry(BaseEvent::Clock::time_point::min()) {
+}
+
+bool
+EventBatch::isBatchable(Defines::APIEndpoint endpoint) {
+    switch (endpoint) {
+        case Defines::TRACK_STANDARD_EVENT:
+        case Defines::TRACK_CUSTOM_EVENT:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void
+EventBatch::add(const BaseEvent& event, IRequestCallback* callback, uint64_t recordId) {
+    add(BaseEvent(event), callback, recordId);
+}
+
+void
+EventBatch::add(BaseEvent&& event, IRequestCallback* callback, uint64_t recordId) {
+    // Estimate: the envelope is shared, so only the event data counts.
+    size_t byteCount = event.toString().size() + event.getCustomData().stringify().size();
+    _expiry = std::max(_expiry, event.getDeadline());
+
+    _events.push_back(std::move(event));
+    _callbacks.push_back(callback);
+    _recordIds.push_back(recordId);
+    _byteCount += byteCount;
+}
+
+size_t
+EventBatch::size() const {
+    return _events.size();
+}
+
+size_t
+EventBatch::getByteCount() const {
+    return _byteCount;
+}
+
+EventBatch::Clock::time_point
+EventBatch::getDeadline() const {
+    return _deadline;
+}
+
+BaseEvent::Clock::time_point
+EventBatch::getExpiry() const {
+    return _expiry;
+}
+
+std::vector<uint64_t>
+EventBatch::getRecordIds() const {
+    std::vector<uint64_t> recordIds;
+    for (uint64_t recordId : _recordIds) {
+        if (recordId) recordIds.push_back(recordId);
+    }
+    return recordIds;
+}
+
+size_t
+EventBatch::removeExpired(BaseEvent::Clock::time_point now, std::vector<uint64_t>& recordIds) {
+    std::vector<BaseEvent> events;
+    std::vector<IRequestCallback*> callbacks;
+    std::vector<uint64_t> eventRecordIds;
+    _expiry = BaseEvent::Clock::time_point::min();
+
+    for (size_t j = 0; j < _events.size(); ++j) {
+        if (_events[j].isExpired(now)) {
+            BRANCH_LOG_W("Request expired.");
+            _callbacks[j]->onError(0, 0, "Request expired.");
+            if (_recordIds[j]) recordIds.push_back(_recordIds[j]);
+            continue;
+        }
+
+        _expiry = std::max(_expiry, _events[j].getDeadline());
+        events.push_back(std::move(_events[j]));
+        callbacks.push_back(_callbacks[j]);
+        eventRecordIds.push_back(_recordIds[j]);
+    }
+
+    size_t removed = _events.size() - events.size();
+    _events.swap(events);
+    _callbacks.swap(callbacks);
+    _recordIds.swap(eventRecordIds);
+    return removed;
+}
+
+void
+EventBatch::package(IPackagingInfo& packagingInfo, JSONObject& jsonPackage) const {
+    BaseEvent::packageBatch(packagingInfo, _events, jsonPackage);
+}
+
+void
+EventBatch::handleResult(const JSONObject& result) const {
+    for (const BaseEvent& event : _events) {
+        event.handleResult(result);
+    }
+}
+
+void
+EventBatch::onSuccess(int id, JSONObject jsonResponse) {
+    for (IRequestCallback* callback : _callbacks) {
+        callback->onSuccess(id, jsonResponse);
+    }
+}
+
+void
+EventBatch::onError(int id, int error, std::string description) {
+    for (IRequestCallback* callback : _callbacks) {
+        callback->onError(id, error, description);
+    }
+}
+
+void
+EventBatch::onStatus(int id, int error, std::string description) {
+    for (IRequestCallback* callback : _callbacks) {
+        callback->onStatus(id, error, description);
+    }
+}
+
+}  // namespace BranchIO
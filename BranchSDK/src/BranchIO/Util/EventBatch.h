@@ -0,0 +1,125 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_EVENTBATCH_H__
+#define BRANCHIO_UTIL_EVENTBATCH_H__
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BranchIO/Defines.h"
+#include "BranchIO/Event/BaseEvent.h"
+#include "BranchIO/IRequestCallback.h"
+#include "BranchIO/fwd.h"
+
+namespace BranchIO {
+
+/**
+ * (Internal) A group of V2 events sent to the server in a single request.
+ *
+ * The batch is filled by the RequestManager under its own lock, then sent
+ * by one worker thread. It acts as the callback for the batch request and
+ * passes each response on to the callback of every event in the batch.
+ */
+class EventBatch : public virtual IRequestCallback {
+ public:
+    /// Clock used for batch deadlines
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * Constructor.
+     * @param deadline time by which the batch should be sent
+     */
+    explicit EventBatch(Clock::time_point deadline);
+
+    /**
+     * Determine whether events for an endpoint may be batched.
+     * @param endpoint API Endpoint of an event
+     * @return true if the event may be added to a batch
+     */
+    static bool isBatchable(Defines::APIEndpoint endpoint);
+
+    /**
+     * Add an event to the end of the batch.
+     * @param event Event to send
+     * @param callback Interface for success and failure response for this event
+     * @param recordId id of the event in the durable event queue, or 0
+     */
+    void add(const BaseEvent& event, IRequestCallback* callback, uint64_t recordId = 0);
+
+    /**
+     * Move an event to the end of the batch.
+     * @param event Event to send
+     * @param callback Interface for success and failure response for this event
+     * @param recordId id of the event in the durable event queue, or 0
+     */
+    void add(BaseEvent&& event, IRequestCallback* callback, uint64_t recordId = 0);
+
+    /**
+     * @return the number of events in the batch
+     */
+    size_t size() const;
+
+    /**
+     * @return the approximate size of the event data in this batch in bytes
+     */
+    size_t getByteCount() const;
+
+    /**
+     * @return the time by which the batch should be sent
+     */
+    Clock::time_point getDeadline() const;
+
+    /**
+     * @return the latest deadline of the events in this batch. The batch
+     *         is not worth sending after this.
+     */
+    BaseEvent::Clock::time_point getExpiry() const;
+
+    /**
+     * @return the durable event queue ids of the events in this batch
+     */
+    std::vector<uint64_t> getRecordIds() const;
+
+    /**
+     * Remove the events that have expired. The callback of each one gets
+     * onError("Request expired."), and the expiry of the batch becomes the
+     * latest deadline of the events left.
+     * @param now the current time
+     * @param recordIds receives the durable event queue ids of the events
+     *        removed
+     * @return the number of events removed
+     */
+    size_t removeExpired(BaseEvent::Clock::time_point now, std::vector<uint64_t>& recordIds);
+
+    /**
+     * Prepare the batch package for transmission.
+     * @param packagingInfo Context for packaging events
+     * @param jsonPackage result of the packaging process
+     */
+    void package(IPackagingInfo& packagingInfo, JSONObject& jsonPackage) const;
+
+    /**
+     * Invoke the result handler of each event in the batch.
+     * @param result the result to pass to the handlers
+     */
+    void handleResult(const JSONObject& result) const;
+
+    virtual void onSuccess(int id, JSONObject jsonResponse);
+    virtual void onError(int id, int error, std::string description);
+    virtual void onStatus(int id, int error, std::string description);
+
+ private:
+    std::vector<BaseEvent> _events;
+    std::vector<IRequestCallback*> _callbacks;
+    // By event. 0 for events not in the durable event queue.
+    std::vector<uint64_t> _recordIds;
+    size_t _byteCount;
+    Clock::time_point const _deadline;
+    BaseEvent::Clock::time_point _expiry;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_EVENTBATCH_H__
@@ -0,0 +1,47 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "BranchIO/Util/EventCount.h"
+
+#include <windows.h>
+
+// WaitOnAddress and WakeByAddress*
+#pragma comment(lib, "Synchronization.lib")
+
+namespace BranchIO {
+
+EventCount::EventCount() : _epoch(0), _waiters(0) {
+}
+
+EventCount::Key
+EventCount::prepareWait() {
+    // Counted before reading the epoch, so a notifier that changes the
+    // condition after this point sees the waiter.
+    _waiters.fetch_add(1);
+    return _epoch.load();
+}
+
+void
+EventCount::cancelWait() {
+    _waiters.fetch_sub(1);
+}
+
+void
+EventCount::wait(Key key, int32_t timeoutMillis) {
+    // Returns immediately if the epoch has already changed.
+    WaitOnAddress(&_epoch, &key, sizeof(key), timeoutMillis < 0 ? INFINITE : static_cast<DWORD>(timeoutMillis));
+    _waiters.fetch_sub(1);
+}
+
+void
+EventCount::notifyOne() {
+    _epoch.fetch_add(1);
+    if (_waiters.load() > 0) WakeByAddressSingle(&_epoch);
+}
+
+void
+EventCount::notifyAll() {
+    _epoch.fetch_add(1);
+    if (_waiters.load() > 0) WakeByAddressAll(&_epoch);
+}
+
+}  // namespace BranchIO
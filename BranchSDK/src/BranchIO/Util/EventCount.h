@@ -0,0 +1,69 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_EVENTCOUNT_H__
+#define BRANCHIO_UTIL_EVENTCOUNT_H__
+
+#include <atomic>
+#include <cstdint>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Lets threads wait for a condition that other threads change
+ * without taking a lock.
+ *
+ * A waiter calls prepareWait(), checks its condition, then calls wait()
+ * with the key, or cancelWait() if the condition is already true. A
+ * notifier changes the condition, then calls notifyOne() or notifyAll().
+ * A notification between prepareWait() and wait() is not lost.
+ *
+ * Notifying is an atomic increment, plus a wake-up system call only if
+ * some thread is waiting. Waiting uses WaitOnAddress.
+ */
+class EventCount {
+ public:
+    /// Identifies the notifications seen by a waiter
+    typedef uint32_t Key;
+
+    EventCount();
+
+    /**
+     * Announce an intention to wait. Must be followed by wait() or cancelWait().
+     * @return the key to pass to wait()
+     */
+    Key prepareWait();
+
+    /**
+     * Give up waiting after prepareWait().
+     */
+    void cancelWait();
+
+    /**
+     * Wait until notified after the prepareWait() call that returned the
+     * key, or until the timeout. May also return early spuriously.
+     * @param key key returned by prepareWait()
+     * @param timeoutMillis maximum wait in ms, or -1 to wait indefinitely
+     */
+    void wait(Key key, int32_t timeoutMillis = -1);
+
+    /**
+     * Wake one waiting thread.
+     */
+    void notifyOne();
+
+    /**
+     * Wake all waiting threads.
+     */
+    void notifyAll();
+
+ private:
+    EventCount(const EventCount& o);
+    EventCount& operator=(const EventCount& o);
+
+    std::atomic<Key> _epoch;
+    std::atomic<uint32_t> _waiters;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_EVENTCOUNT_H__
@@ -0,0 +1,46 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "Executor.h"
+
+#include <exception>
+#include <memory>
+#include <windows.h>
+
+#include "BranchIO/Util/Log.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+static void
+runTask(Executor::Task& task) {
+    try {
+        task();
+    }
+    catch (std::exception& e) {
+        BRANCH_LOG_E("Exception in background task: " << e.what());
+    }
+    catch (...) {
+        BRANCH_LOG_E("Unexpected exception in background task.");
+    }
+}
+
+static VOID CALLBACK
+threadPoolCallback(PTP_CALLBACK_INSTANCE instance, PVOID context) {
+    unique_ptr<Executor::Task> task(static_cast<Executor::Task*>(context));
+    runTask(*task);
+}
+
+void
+Executor::submit(Task task) {
+    if (!task) return;
+
+    auto context = new Task(std::move(task));
+    if (!TrySubmitThreadpoolCallback(threadPoolCallback, context, nullptr)) {
+        BRANCH_LOG_W("Thread pool unavailable. Running task synchronously.");
+        unique_ptr<Task> owned(context);
+        runTask(*owned);
+    }
+}
+
+}  // namespace BranchIO
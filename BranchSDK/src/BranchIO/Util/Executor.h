@@ -0,0 +1,32 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_EXECUTOR_H__
+#define BRANCHIO_UTIL_EXECUTOR_H__
+
+#include <functional>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Runs short tasks in the background on the process-wide
+ * Windows thread pool, rather than starting a thread for each task.
+ */
+class Executor {
+ public:
+    /**
+     * A task to run
+     */
+    typedef std::function<void()> Task;
+
+    /**
+     * Run a task on a thread pool thread. If the task can't be queued, it
+     * runs on the calling thread before this returns. Exceptions thrown by
+     * the task are logged and discarded.
+     * @param task the task to run
+     */
+    static void submit(Task task);
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_EXECUTOR_H__
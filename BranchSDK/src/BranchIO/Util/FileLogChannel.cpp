@@ -48,20 +48,35 @@ namespace BranchIO
 
     void FileLogChannel::log(const std::string& message)
     {
+        std::string logText;
+        logText.reserve(message.size() + 16); // keep some reserve for \n -> \r\n and terminating \r\n
+        appendLine(logText, message);
+
         scoped_lock _l(_mutex);
+        write(logText);
+    }
 
-        if (mustRotate())
+    void FileLogChannel::log(const std::vector<std::string>& messages)
+    {
+        size_t size = 0;
+        for (const std::string& message : messages)
         {
-            rotateFile();
+            size += message.size() + 16;
         }
 
-        if (_hFile == INVALID_HANDLE_VALUE)
+        std::string logText;
+        logText.reserve(size);
+        for (const std::string& message : messages)
         {
-            open();
+            appendLine(logText, message);
         }
 
-        std::string logText;
-        logText.reserve(message.size() + 16); // keep some reserve for \n -> \r\n and terminating \r\n
+        scoped_lock _l(_mutex);
+        write(logText);
+    }
+
+    void FileLogChannel::appendLine(std::string& logText, const std::string& message)
+    {
         for (char c : message)
         {
             if (c == '\n')
@@ -70,10 +85,22 @@ namespace BranchIO
                 logText += c;
         }
         logText += "\r\n";
+    }
+
+    void FileLogChannel::write(const std::string& logText)
+    {
+        if (mustRotate())
+        {
+            rotateFile();
+        }
+
+        if (_hFile == INVALID_HANDLE_VALUE)
+        {
+            open();
+        }
 
         DWORD bytesWritten;
         BOOL res = WriteFile(_hFile, logText.data(), static_cast<DWORD>(logText.size()), &bytesWritten, NULL);
-        string errorMsg = system_category().message(GetLastError());
         if (!res)
         {
             string errorMsg = system_category().message(GetLastError()) + "\n";
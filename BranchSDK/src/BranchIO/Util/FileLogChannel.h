@@ -39,6 +39,11 @@ namespace BranchIO {
          */
         void log(const std::string& message);
 
+        /**
+         * Logs a batch of messages to the channel with a single write.
+         */
+        void log(const std::vector<std::string>& messages);
+
         /**
          * Sets log file rotation count. File is rotated when its max size is exceeded.
          * When the number of backup files is exceeded, they are deleted.
@@ -58,6 +63,8 @@ namespace BranchIO {
         std::int64_t   _maxFileSize;
         int  _logFileRotationCount;
 
+        void write(const std::string& logText);
+        static void appendLine(std::string& logText, const std::string& message);
         bool ifFileExists(std::wstring filePath);
         bool mustRotate();
         void rotateFile();
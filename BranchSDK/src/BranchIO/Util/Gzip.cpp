@@ -0,0 +1,195 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "Gzip.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "CRC32.h"
+
+namespace BranchIO {
+
+namespace {
+
+// Matches may refer back this far
+const size_t WindowSize = 32768;
+const size_t MinMatch = 3;
+const size_t MaxMatch = 258;
+const int HashBits = 15;
+// Candidates examined per position. More finds longer matches, slower.
+const int MaxChain = 64;
+
+const uint16_t LengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t LengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t DistanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const uint8_t DistanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/**
+ * Appends bits to a string, least significant bit first.
+ */
+class BitWriter {
+ public:
+    explicit BitWriter(std::string& out) : _out(out), _bits(0), _count(0) {}
+
+    void write(uint32_t value, int count) {
+        _bits |= static_cast<uint64_t>(value) << _count;
+        _count += count;
+        while (_count >= 8) {
+            _out.push_back(static_cast<char>(_bits & 0xFF));
+            _bits >>= 8;
+            _count -= 8;
+        }
+    }
+
+    // Huffman codes are packed starting with their most significant bit.
+    void writeCode(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int j = 0; j < length; ++j) {
+            reversed = (reversed << 1) | ((code >> j) & 1);
+        }
+        write(reversed, length);
+    }
+
+    void flush() {
+        if (_count > 0) {
+            _out.push_back(static_cast<char>(_bits & 0xFF));
+            _bits = 0;
+            _count = 0;
+        }
+    }
+
+ private:
+    std::string& _out;
+    uint64_t _bits;
+    int _count;
+};
+
+/**
+ * Write a literal/length symbol with the fixed Huffman code.
+ */
+void
+writeSymbol(BitWriter& writer, unsigned int symbol) {
+    if (symbol < 144) {
+        writer.writeCode(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        writer.writeCode(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        writer.writeCode(symbol - 256, 7);
+    } else {
+        writer.writeCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+void
+writeMatch(BitWriter& writer, size_t length, size_t distance) {
+    int code = 28;
+    while (LengthBase[code] > length) --code;
+    writeSymbol(writer, 257 + code);
+    writer.write(static_cast<uint32_t>(length - LengthBase[code]), LengthExtra[code]);
+
+    code = 29;
+    while (DistanceBase[code] > distance) --code;
+    writer.writeCode(code, 5);
+    writer.write(static_cast<uint32_t>(distance - DistanceBase[code]), DistanceExtra[code]);
+}
+
+uint32_t
+hash(const uint8_t* p) {
+    uint32_t key = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    return (key * 2654435761u) >> (32 - HashBits);
+}
+
+void
+appendLE32(std::string& out, uint32_t value) {
+    for (int j = 0; j < 4; ++j) {
+        out.push_back(static_cast<char>((value >> (8 * j)) & 0xFF));
+    }
+}
+
+}  // namespace
+
+std::string
+Gzip::compress(const void* data, size_t length) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+
+    // Deflate, no file name, no modification time, unknown OS
+    static const unsigned char Header[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+    std::string out(reinterpret_cast<const char*>(Header), sizeof(Header));
+    out.reserve(length / 2 + 32);
+
+    BitWriter writer(out);
+    // One final block with the fixed Huffman codes
+    writer.write(1, 1);
+    writer.write(1, 2);
+
+    // Latest position with each hash, and for each position in the window
+    // the previous one with the same hash
+    std::vector<int32_t> head(size_t(1) << HashBits, -1);
+    std::vector<int32_t> previous(std::min(length, WindowSize));
+    auto insert = [&](size_t position) {
+        uint32_t h = hash(in + position);
+        previous[position & (WindowSize - 1)] = head[h];
+        head[h] = static_cast<int32_t>(position);
+    };
+
+    size_t position = 0;
+    while (position < length) {
+        size_t bestLength = 0;
+        size_t bestDistance = 0;
+
+        if (position + MinMatch <= length) {
+            size_t maxLength = std::min(MaxMatch, length - position);
+            int32_t candidate = head[hash(in + position)];
+            for (int chain = 0; candidate >= 0 && chain < MaxChain; ++chain) {
+                size_t distance = position - candidate;
+                if (distance > WindowSize) break;
+
+                if (in[candidate + bestLength] == in[position + bestLength]) {
+                    size_t n = 0;
+                    while (n < maxLength && in[candidate + n] == in[position + n]) ++n;
+                    if (n > bestLength) {
+                        bestLength = n;
+                        bestDistance = distance;
+                        if (n == maxLength) break;
+                    }
+                }
+                candidate = previous[candidate & (WindowSize - 1)];
+            }
+            insert(position);
+        }
+
+        if (bestLength >= MinMatch) {
+            writeMatch(writer, bestLength, bestDistance);
+            for (size_t j = 1; j < bestLength; ++j) {
+                if (position + j + MinMatch <= length) insert(position + j);
+            }
+            position += bestLength;
+        } else {
+            writeSymbol(writer, in[position]);
+            ++ position;
+        }
+    }
+
+    // End of block
+    writeSymbol(writer, 256);
+    writer.flush();
+
+    appendLE32(out, CRC32::compute(data, length));
+    appendLE32(out, static_cast<uint32_t>(length));
+    return out;
+}
+
+}  // namespace BranchIO
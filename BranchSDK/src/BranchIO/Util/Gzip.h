@@ -0,0 +1,44 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_GZIP_H__
+#define BRANCHIO_UTIL_GZIP_H__
+
+#include <cstddef>
+#include <string>
+
+namespace BranchIO {
+
+/**
+ * (Internal) gzip (RFC 1952) compression of request bodies.
+   ```
+   std::string compressed = Gzip::compress(body);
+   ```
+ *
+ * The data is deflated (RFC 1951) as a single block using LZ77 matching
+ * within a 32 kB window and the fixed Huffman codes. That suits JSON
+ * payloads, which compress mostly through repeated keys and values, and
+ * keeps the encoder small.
+ */
+class Gzip {
+ public:
+    /**
+     * Compress a buffer.
+     * @param data bytes to compress
+     * @param length number of bytes
+     * @return the gzip stream
+     */
+    static std::string compress(const void* data, size_t length);
+
+    /**
+     * Compress a string.
+     * @param data bytes to compress
+     * @return the gzip stream
+     */
+    static std::string compress(const std::string& data) {
+        return compress(data.data(), data.size());
+    }
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_GZIP_H__
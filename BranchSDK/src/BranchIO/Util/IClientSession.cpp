@@ -0,0 +1,33 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "IClientSession.h"
+
+#include <cstring>
+
+#include "BranchIO/Defines.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+string
+IClientSession::resolveUrl(const string& urlBase, const string& path) {
+    string relativePath(path);
+    size_t apiBaseLength = strlen(BRANCH_IO_URL_BASE);
+    if (relativePath.compare(0, apiBaseLength, BRANCH_IO_URL_BASE) == 0) {
+        relativePath.erase(0, apiBaseLength);
+    } else if (relativePath.find("://") != string::npos) {
+        // Some other server
+        return relativePath;
+    }
+
+    if (urlBase.empty() || relativePath.empty()) return urlBase + relativePath;
+
+    bool slashBase = urlBase.back() == '/';
+    bool slashPath = relativePath.front() == '/';
+    if (slashBase && slashPath) return urlBase + relativePath.substr(1);
+    if (!slashBase && !slashPath) return urlBase + "/" + relativePath;
+    return urlBase + relativePath;
+}
+
+}  // namespace BranchIO
@@ -3,12 +3,23 @@
 #ifndef BRANCHIO_UTIL_ICLIENTSESSION_H__
 #define BRANCHIO_UTIL_ICLIENTSESSION_H__
 
+#include <cstdint>
 #include <string>
 
 #include "BranchIO/fwd.h"
 
 namespace BranchIO {
 
+/**
+ * (Internal) What the server said about retrying a failed post().
+ */
+struct RetryInfo {
+    RetryInfo() : retryAfterMillis(-1) {}
+
+    /// Time to wait before retrying from a Retry-After header in ms, or -1
+    int32_t retryAfterMillis;
+};
+
 /**
  * (Internal)
  * @todo(jdee): Document
@@ -16,6 +27,15 @@ namespace BranchIO {
 struct IClientSession {
     virtual ~IClientSession() {}
 
+    /**
+     * Build the URL of a request.
+     * @param urlBase Base endpoint of the session
+     * @param path API Endpoint: a path relative to urlBase, or a full URL
+     *        under BRANCH_IO_URL_BASE as built by Defines::stringify
+     * @return the URL, with BRANCH_IO_URL_BASE replaced by urlBase
+     */
+    static std::string resolveUrl(const std::string& urlBase, const std::string& path);
+
     /**
      * @todo(jdee): Document
      */
@@ -34,6 +54,25 @@ struct IClientSession {
         const JSONObject& jsonPayload,
         IRequestCallback& callback,
         JSONObject& result) = 0;
+
+    /**
+     * Send this request as a "Post", and report the server's retry advice
+     * if it fails. The default ignores retryInfo.
+     * @param path API Endpoint
+     * @param jsonPayload JSON Payload to send
+     * @param callback Interface for success and failure response.
+     * @param result On success, the response body is stored here.
+     * @param retryInfo On failure, receives the server's retry advice, if any.
+     * @return true if successful
+     */
+    virtual bool post(
+        const std::string& path,
+        const JSONObject& jsonPayload,
+        IRequestCallback& callback,
+        JSONObject& result,
+        RetryInfo& retryInfo) {
+        return post(path, jsonPayload, callback, result);
+    }
 };
 
 }  // namespace BranchIO
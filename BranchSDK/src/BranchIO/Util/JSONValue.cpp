@@ -0,0 +1,431 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "JSONValue.h"
+
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace BranchIO {
+
+namespace {
+
+/// Maximum nesting of objects and arrays accepted by the parser
+const int MaxDepth = 512;
+
+void writeNumber(string& out, double value) {
+    char buffer[32];
+    to_chars_result result;
+
+    if (!isfinite(value)) {
+        // Not representable in JSON
+        out.append("null");
+        return;
+    }
+
+    if (value == floor(value) && fabs(value) < 1e15) {
+        result = to_chars(buffer, buffer + sizeof(buffer), static_cast<long long>(value));
+    } else {
+        result = to_chars(buffer, buffer + sizeof(buffer), value);
+    }
+    out.append(buffer, result.ptr);
+}
+
+void appendUTF8(string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+/**
+ * Recursive descent parser for RFC 8259 JSON text.
+ */
+class Parser {
+ public:
+    explicit Parser(const string& text) :
+        _p(text.data()),
+        _end(text.data() + text.size()),
+        _depth(0) {
+    }
+
+    shared_ptr<JSONObjectData> parseDocument() {
+        skipWhitespace();
+        if (peek() != '{') fail("Expected an object");
+
+        shared_ptr<JSONObjectData> object = parseObject();
+
+        skipWhitespace();
+        if (_p != _end) fail("Unexpected data after the object");
+        return object;
+    }
+
+ private:
+    [[noreturn]] void fail(const char* message) const {
+        throw invalid_argument(string("JSON parse error: ") + message);
+    }
+
+    char peek() const {
+        return _p < _end ? *_p : '\0';
+    }
+
+    void expect(char c) {
+        if (peek() != c) fail("Unexpected character");
+        ++ _p;
+    }
+
+    void skipWhitespace() {
+        while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) ++ _p;
+    }
+
+    void matchLiteral(const char* literal) {
+        for (; *literal; ++literal) {
+            expect(*literal);
+        }
+    }
+
+    JSONValue parseValue() {
+        skipWhitespace();
+        switch (peek()) {
+            case '{':
+                return JSONValue(parseObject());
+            case '[':
+                return JSONValue(parseArray());
+            case '"':
+                return JSONValue(parseString());
+            case 't':
+                matchLiteral("true");
+                return JSONValue(true);
+            case 'f':
+                matchLiteral("false");
+                return JSONValue(false);
+            case 'n':
+                matchLiteral("null");
+                return JSONValue();
+            default:
+                return JSONValue(parseNumber());
+        }
+    }
+
+    shared_ptr<JSONObjectData> parseObject() {
+        if (++_depth > MaxDepth) fail("Nesting too deep");
+        expect('{');
+
+        auto object = make_shared<JSONObjectData>();
+        skipWhitespace();
+        if (peek() == '}') {
+            ++ _p;
+            -- _depth;
+            return object;
+        }
+
+        for (;;) {
+            skipWhitespace();
+            string key(parseString());
+            skipWhitespace();
+            expect(':');
+            object->set(key, parseValue());
+
+            skipWhitespace();
+            if (peek() == ',') {
+                ++ _p;
+                continue;
+            }
+            expect('}');
+            break;
+        }
+
+        -- _depth;
+        return object;
+    }
+
+    shared_ptr<JSONArrayData> parseArray() {
+        if (++_depth > MaxDepth) fail("Nesting too deep");
+        expect('[');
+
+        auto array = make_shared<JSONArrayData>();
+        skipWhitespace();
+        if (peek() == ']') {
+            ++ _p;
+            -- _depth;
+            return array;
+        }
+
+        for (;;) {
+            array->push_back(parseValue());
+
+            skipWhitespace();
+            if (peek() == ',') {
+                ++ _p;
+                continue;
+            }
+            expect(']');
+            break;
+        }
+
+        -- _depth;
+        return array;
+    }
+
+    uint32_t parseHex4() {
+        if (_end - _p < 4) fail("Truncated escape");
+
+        uint32_t value = 0;
+        for (int j = 0; j < 4; ++j) {
+            char c = *_p++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                value |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                value |= c - 'A' + 10;
+            } else {
+                fail("Invalid escape");
+            }
+        }
+        return value;
+    }
+
+    string parseString() {
+        expect('"');
+
+        string value;
+        for (;;) {
+            // Copy runs of plain characters at once
+            const char* start = _p;
+            while (_p < _end && *_p != '"' && *_p != '\\' && static_cast<unsigned char>(*_p) >= 0x20) ++ _p;
+            value.append(start, _p);
+
+            if (_p >= _end) fail("Unterminated string");
+            char c = *_p++;
+            if (c == '"') break;
+            if (c != '\\') fail("Control character in string");
+
+            if (_p >= _end) fail("Unterminated string");
+            switch (*_p++) {
+                case '"': value.push_back('"'); break;
+                case '\\': value.push_back('\\'); break;
+                case '/': value.push_back('/'); break;
+                case 'b': value.push_back('\b'); break;
+                case 'f': value.push_back('\f'); break;
+                case 'n': value.push_back('\n'); break;
+                case 'r': value.push_back('\r'); break;
+                case 't': value.push_back('\t'); break;
+                case 'u': {
+                    uint32_t cp = parseHex4();
+                    if (cp >= 0xD800 && cp < 0xDC00) {
+                        // High surrogate; a low surrogate must follow
+                        if (_end - _p < 2 || _p[0] != '\\' || _p[1] != 'u') fail("Unpaired surrogate");
+                        _p += 2;
+                        uint32_t low = parseHex4();
+                        if (low < 0xDC00 || low > 0xDFFF) fail("Unpaired surrogate");
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                        fail("Unpaired surrogate");
+                    }
+                    appendUTF8(value, cp);
+                    break;
+                }
+                default:
+                    fail("Invalid escape");
+            }
+        }
+        return value;
+    }
+
+    double parseNumber() {
+        // Validate the JSON number grammar, which is stricter than from_chars.
+        const char* start = _p;
+        if (peek() == '-') ++ _p;
+        if (peek() == '0') {
+            ++ _p;
+        } else if (peek() >= '1' && peek() <= '9') {
+            while (peek() >= '0' && peek() <= '9') ++ _p;
+        } else {
+            fail("Unexpected character");
+        }
+        if (peek() == '.') {
+            ++ _p;
+            if (!(peek() >= '0' && peek() <= '9')) fail("Invalid number");
+            while (peek() >= '0' && peek() <= '9') ++ _p;
+        }
+        if (peek() == 'e' || peek() == 'E') {
+            ++ _p;
+            if (peek() == '+' || peek() == '-') ++ _p;
+            if (!(peek() >= '0' && peek() <= '9')) fail("Invalid number");
+            while (peek() >= '0' && peek() <= '9') ++ _p;
+        }
+
+        double value = 0;
+        from_chars_result result = from_chars(start, _p, value);
+        if (result.ec == errc::invalid_argument) fail("Invalid number");
+        return value;
+    }
+
+    const char* _p;
+    const char* const _end;
+    int _depth;
+};
+
+}  // namespace
+
+void
+JSONValue::write(std::string& out) const {
+    switch (getType()) {
+        case NullValue:
+            out.append("null");
+            break;
+        case BooleanValue:
+            out.append(getBoolean() ? "true" : "false");
+            break;
+        case NumberValue:
+            writeNumber(out, getNumber());
+            break;
+        case StringValue:
+            writeString(out, getString());
+            break;
+        case ArrayValue: {
+            out.push_back('[');
+            bool first = true;
+            for (const JSONValue& element : *getArray()) {
+                if (!first) out.push_back(',');
+                first = false;
+                element.write(out);
+            }
+            out.push_back(']');
+            break;
+        }
+        case ObjectValue:
+            getObject()->write(out);
+            break;
+        case RawValue:
+            out.append(getRaw());
+            break;
+    }
+}
+
+void
+JSONValue::writeString(std::string& out, const std::string& value) {
+    static const char* const hex = "0123456789abcdef";
+
+    out.push_back('"');
+    const char* p = value.data();
+    const char* end = p + value.size();
+    while (p < end) {
+        // Copy runs of characters that need no escaping at once
+        const char* start = p;
+        while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) ++p;
+        out.append(start, p);
+        if (p >= end) break;
+
+        char c = *p++;
+        switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                out.append("\\u00");
+                out.push_back(hex[(c >> 4) & 0xF]);
+                out.push_back(hex[c & 0xF]);
+                break;
+        }
+    }
+    out.push_back('"');
+}
+
+JSONValue
+JSONValue::clone() const {
+    switch (getType()) {
+        case ArrayValue: {
+            auto array = make_shared<JSONArrayData>();
+            array->reserve(getArray()->size());
+            for (const JSONValue& element : *getArray()) {
+                array->push_back(element.clone());
+            }
+            return JSONValue(array);
+        }
+        case ObjectValue:
+            return JSONValue(getObject()->clone());
+        default:
+            return *this;
+    }
+}
+
+std::shared_ptr<JSONObjectData>
+JSONValue::parseObject(const std::string& text) {
+    return Parser(text).parseDocument();
+}
+
+const JSONValue*
+JSONObjectData::find(const std::string& key) const {
+    for (const auto& member : members) {
+        if (member.first == key) return &member.second;
+    }
+    return nullptr;
+}
+
+void
+JSONObjectData::set(const std::string& key, JSONValue value) {
+    for (auto& member : members) {
+        if (member.first == key) {
+            member.second = std::move(value);
+            return;
+        }
+    }
+    members.emplace_back(key, std::move(value));
+}
+
+bool
+JSONObjectData::remove(const std::string& key) {
+    for (auto it = members.begin(); it != members.end(); ++it) {
+        if (it->first == key) {
+            members.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+JSONObjectData::write(std::string& out) const {
+    out.push_back('{');
+    bool first = true;
+    for (const auto& member : members) {
+        if (!first) out.push_back(',');
+        first = false;
+        JSONValue::writeString(out, member.first);
+        out.push_back(':');
+        member.second.write(out);
+    }
+    out.push_back('}');
+}
+
+std::shared_ptr<JSONObjectData>
+JSONObjectData::clone() const {
+    auto object = make_shared<JSONObjectData>();
+    object->members.reserve(members.size());
+    for (const auto& member : members) {
+        object->members.emplace_back(member.first, member.second.clone());
+    }
+    return object;
+}
+
+}  // namespace BranchIO
@@ -0,0 +1,211 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_JSONVALUE_H__
+#define BRANCHIO_UTIL_JSONVALUE_H__
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace BranchIO {
+
+class JSONValue;
+struct JSONObjectData;
+
+/// (Internal) Elements of a JSON array
+typedef std::vector<JSONValue> JSONArrayData;
+
+/**
+ * (Internal) A JSON value in the native UTF-8 DOM behind JSONObject.
+ *
+ * Scalars are stored inline; strings use std::string, so short keys and
+ * values don't allocate. Objects and arrays are held by shared pointer, so,
+ * as with the WinRT JsonObject this replaces, copying a value that holds an
+ * object or array refers to the same container rather than copying it.
+ */
+class JSONValue {
+ public:
+    /**
+     * JSON value types
+     */
+    enum Type {
+        NullValue,
+        BooleanValue,
+        NumberValue,
+        StringValue,
+        ArrayValue,
+        ObjectValue,
+        RawValue
+    };
+
+    /**
+     * Construct a null value.
+     */
+    JSONValue() : _value(nullptr) {}
+
+    /**
+     * Construct a boolean value.
+     * @param value the value
+     */
+    explicit JSONValue(bool value) : _value(value) {}
+
+    /**
+     * Construct a number value.
+     * @param value the value
+     */
+    explicit JSONValue(double value) : _value(value) {}
+
+    /**
+     * Construct a string value.
+     * @param value UTF-8 string
+     */
+    explicit JSONValue(std::string value) : _value(std::move(value)) {}
+
+    /// Not a boolean. Use the std::string constructor.
+    JSONValue(const char*) = delete;
+
+    /**
+     * Construct an array value.
+     * @param value the array
+     */
+    explicit JSONValue(std::shared_ptr<JSONArrayData> value) : _value(std::move(value)) {}
+
+    /**
+     * Construct an object value.
+     * @param value the object
+     */
+    explicit JSONValue(std::shared_ptr<JSONObjectData> value) : _value(std::move(value)) {}
+
+    /**
+     * Construct a value from pre-serialized JSON text, which is written
+     * verbatim. The text is shared, not copied, so the same fragment may be
+     * spliced into many documents.
+     * @param json valid JSON text for a single value
+     */
+    explicit JSONValue(std::shared_ptr<const std::string> json) : _value(std::move(json)) {}
+
+    /**
+     * @return the type of this value
+     */
+    Type getType() const { return static_cast<Type>(_value.index()); }
+
+    /**
+     * @return the boolean value
+     * @throw std::bad_variant_access if this is not a boolean
+     */
+    bool getBoolean() const { return std::get<bool>(_value); }
+
+    /**
+     * @return the number value
+     * @throw std::bad_variant_access if this is not a number
+     */
+    double getNumber() const { return std::get<double>(_value); }
+
+    /**
+     * @return the string value
+     * @throw std::bad_variant_access if this is not a string
+     */
+    const std::string& getString() const { return std::get<std::string>(_value); }
+
+    /**
+     * @return the array
+     * @throw std::bad_variant_access if this is not an array
+     */
+    const std::shared_ptr<JSONArrayData>& getArray() const { return std::get<std::shared_ptr<JSONArrayData>>(_value); }
+
+    /**
+     * @return the object
+     * @throw std::bad_variant_access if this is not an object
+     */
+    const std::shared_ptr<JSONObjectData>& getObject() const { return std::get<std::shared_ptr<JSONObjectData>>(_value); }
+
+    /**
+     * @return the pre-serialized JSON text
+     * @throw std::bad_variant_access if this is not a raw value
+     */
+    const std::string& getRaw() const { return *std::get<std::shared_ptr<const std::string>>(_value); }
+
+    /**
+     * Append the JSON text for this value to a buffer.
+     * @param out buffer to append to
+     */
+    void write(std::string& out) const;
+
+    /**
+     * Append a quoted, escaped JSON string to a buffer.
+     * @param out buffer to append to
+     * @param value UTF-8 string to quote
+     */
+    static void writeString(std::string& out, const std::string& value);
+
+    /**
+     * @return a deep copy of this value. Objects and arrays are copied
+     * rather than shared. Raw text is still shared, since it is immutable.
+     */
+    JSONValue clone() const;
+
+    /**
+     * Parse JSON text that must contain a single object.
+     * @param text UTF-8 JSON text
+     * @return the parsed object
+     * @throw std::invalid_argument in case of parse failure
+     */
+    static std::shared_ptr<JSONObjectData> parseObject(const std::string& text);
+
+ private:
+    std::variant<
+        std::nullptr_t,
+        bool,
+        double,
+        std::string,
+        std::shared_ptr<JSONArrayData>,
+        std::shared_ptr<JSONObjectData>,
+        std::shared_ptr<const std::string>> _value;
+};
+
+/**
+ * (Internal) Members of a JSON object in insertion order. Objects in this
+ * SDK are small, so lookups are a linear scan of contiguous storage.
+ */
+struct JSONObjectData {
+    /// Key/value pairs in insertion order
+    std::vector<std::pair<std::string, JSONValue>> members;
+
+    /**
+     * Find a member.
+     * @param key the key
+     * @return a pointer to the value or NULL
+     */
+    const JSONValue* find(const std::string& key) const;
+
+    /**
+     * Set a member, replacing any existing value for the key in place.
+     * @param key the key
+     * @param value the value
+     */
+    void set(const std::string& key, JSONValue value);
+
+    /**
+     * Remove a member.
+     * @param key the key
+     * @return true if the key was present
+     */
+    bool remove(const std::string& key);
+
+    /**
+     * Append the JSON text for this object to a buffer.
+     * @param out buffer to append to
+     */
+    void write(std::string& out) const;
+
+    /**
+     * @return a deep copy of this object
+     */
+    std::shared_ptr<JSONObjectData> clone() const;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_JSONVALUE_H__
@@ -0,0 +1,197 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "LinkCache.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "BranchIO/Configuration.h"
+#include "BranchIO/JSONObject.h"
+#include "BranchIO/Util/JSONValue.h"
+
+using namespace std;
+
+namespace BranchIO {
+
+static void
+writeCanonical(string& out, const JSONValue& value);
+
+static void
+writeCanonical(string& out, const JSONObjectData& object) {
+    vector<const pair<string, JSONValue>*> members;
+    members.reserve(object.members.size());
+    for (const auto& member : object.members) {
+        members.push_back(&member);
+    }
+    sort(members.begin(), members.end(), [](const pair<string, JSONValue>* a, const pair<string, JSONValue>* b) {
+        return a->first < b->first;
+    });
+
+    out.push_back('{');
+    bool first = true;
+    for (const auto* member : members) {
+        if (!first) out.push_back(',');
+        first = false;
+        JSONValue::writeString(out, member->first);
+        out.push_back(':');
+        writeCanonical(out, member->second);
+    }
+    out.push_back('}');
+}
+
+static void
+writeCanonical(string& out, const JSONValue& value) {
+    switch (value.getType()) {
+        case JSONValue::ObjectValue:
+            writeCanonical(out, *value.getObject());
+            break;
+        case JSONValue::ArrayValue: {
+            out.push_back('[');
+            bool first = true;
+            for (const JSONValue& element : *value.getArray()) {
+                if (!first) out.push_back(',');
+                first = false;
+                writeCanonical(out, element);
+            }
+            out.push_back(']');
+            break;
+        }
+        default:
+            value.write(out);
+            break;
+    }
+}
+
+LinkCache&
+LinkCache::instance() {
+    static LinkCache _instance(
+        Configuration::DefaultLinkCacheMaxEntries,
+        chrono::milliseconds(Configuration::DefaultLinkCacheTTLMillis));
+    return _instance;
+}
+
+LinkCache::LinkCache(size_t maxEntries, Clock::duration ttl) :
+    _maxEntries(maxEntries),
+    _ttl(ttl) {
+}
+
+void
+LinkCache::setLimits(size_t maxEntries, Clock::duration ttl) {
+    scoped_lock _l(_mutex);
+    _maxEntries = maxEntries;
+    _ttl = ttl;
+
+    while (_entries.size() > _maxEntries) {
+        _index.erase(_entries.back().key);
+        _entries.pop_back();
+    }
+}
+
+std::string
+LinkCache::makeKey(const JSONObject& payload) {
+    // Reparse, since raw values are written verbatim and not sorted.
+    string key;
+    writeCanonical(key, *JSONValue::parseObject(payload.stringify()));
+    return key;
+}
+
+LinkCache::Status
+LinkCache::acquire(const std::string& key, std::string& url, Waiter waiter) {
+    scoped_lock _l(_mutex);
+
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        if (it->second->expires > Clock::now()) {
+            // Move to the front of the LRU list
+            _entries.splice(_entries.begin(), _entries, it->second);
+            url = it->second->url;
+            return Hit;
+        }
+
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+
+    auto flight = _inFlight.find(key);
+    if (flight != _inFlight.end()) {
+        flight->second.push_back(std::move(waiter));
+        return Joined;
+    }
+
+    _inFlight[key];
+    return Leader;
+}
+
+void
+LinkCache::complete(const std::string& key, const std::string* url) {
+    vector<Waiter> waiters;
+    {
+        scoped_lock _l(_mutex);
+        auto flight = _inFlight.find(key);
+        if (flight != _inFlight.end()) {
+            waiters.swap(flight->second);
+            _inFlight.erase(flight);
+        }
+
+        if (url) insertLocked(key, *url);
+    }
+
+    for (Waiter& waiter : waiters) {
+        waiter(Hit, url);
+    }
+}
+
+void
+LinkCache::abandon(const std::string& key) {
+    Waiter next;
+    {
+        scoped_lock _l(_mutex);
+        auto flight = _inFlight.find(key);
+        if (flight == _inFlight.end()) return;
+
+        if (flight->second.empty()) {
+            _inFlight.erase(flight);
+            return;
+        }
+
+        // The key stays in flight under the new leader.
+        next = std::move(flight->second.front());
+        flight->second.erase(flight->second.begin());
+    }
+
+    next(Leader, nullptr);
+}
+
+void
+LinkCache::insertLocked(const std::string& key, const std::string& url) {
+    if (_maxEntries == 0) return;
+
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        _entries.erase(it->second);
+        _index.erase(it);
+    }
+
+    _entries.push_front(Entry{ key, url, Clock::now() + _ttl });
+    _index[key] = _entries.begin();
+
+    while (_entries.size() > _maxEntries) {
+        _index.erase(_entries.back().key);
+        _entries.pop_back();
+    }
+}
+
+size_t
+LinkCache::size() const {
+    scoped_lock _l(_mutex);
+    return _entries.size();
+}
+
+void
+LinkCache::clear() {
+    scoped_lock _l(_mutex);
+    _entries.clear();
+    _index.clear();
+}
+
+}  // namespace BranchIO
@@ -0,0 +1,147 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_LINKCACHE_H__
+#define BRANCHIO_UTIL_LINKCACHE_H__
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BranchIO/fwd.h"
+
+namespace BranchIO {
+
+/**
+ * (Internal) Cache of short links created by LinkInfo, shared by all
+ * LinkInfo objects in the process.
+ *
+ * Links are keyed by the canonical form of the /v1/url request payload, so
+ * links requested with the same key and parameters share one entry. The
+ * cache holds at most a fixed number of links, dropping the least recently
+ * used, and each link expires after a fixed time.
+ *
+ * Only one request is sent at a time for each key. The first caller for a
+ * key becomes the leader and sends the request; callers that arrive while
+ * it is in progress wait for its result instead of sending their own. A
+ * leader that gives up without a result hands the request over to the
+ * first waiter.
+ */
+class LinkCache {
+ public:
+    /// Clock used for expiry
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * Result of acquire()
+     */
+    enum Status {
+        /// The URL was cached.
+        Hit,
+        /// Another caller is sending the same request. The waiter will be called.
+        Joined,
+        /// The caller must send the request, then call complete() or abandon().
+        Leader
+    };
+
+    /**
+     * Called when a request another caller sent is finished: with Hit and
+     * the short URL, or NULL if the request failed. Called with Leader if
+     * the other caller abandoned the request, in which case this caller
+     * must send it.
+     */
+    typedef std::function<void(Status status, const std::string* url)> Waiter;
+
+    /**
+     * @return the cache shared by all LinkInfo objects
+     */
+    static LinkCache& instance();
+
+    /**
+     * Constructor.
+     * @param maxEntries maximum number of cached links. 0 disables caching.
+     * @param ttl how long a link is reused
+     */
+    LinkCache(size_t maxEntries, Clock::duration ttl);
+
+    /**
+     * Change the size and time to live. Takes effect for later lookups and
+     * insertions.
+     * @param maxEntries maximum number of cached links. 0 disables caching.
+     * @param ttl how long a link is reused
+     */
+    void setLimits(size_t maxEntries, Clock::duration ttl);
+
+    /**
+     * Build the cache key for a request. Object members are sorted, so the
+     * order in which link properties were set doesn't matter.
+     * @param payload /v1/url request payload, including the Branch key
+     * @return the key
+     */
+    static std::string makeKey(const JSONObject& payload);
+
+    /**
+     * Look up a link, or join or start a request for it.
+     * @param key key from makeKey()
+     * @param url receives the URL in case of a Hit
+     * @param waiter called in case of Joined, when the leader completes
+     * @return Hit, Joined or Leader
+     */
+    Status acquire(const std::string& key, std::string& url, Waiter waiter);
+
+    /**
+     * Called by the leader when its request is finished. Caches the URL
+     * and passes the result to any waiters.
+     * @param key key from makeKey()
+     * @param url the short URL, or NULL if the request failed
+     */
+    void complete(const std::string& key, const std::string* url);
+
+    /**
+     * Called by the leader instead of complete() when its request was
+     * canceled. The first waiter, if any, becomes the leader. The others
+     * keep waiting.
+     * @param key key from makeKey()
+     */
+    void abandon(const std::string& key);
+
+    /**
+     * @return the number of cached links, including expired ones not yet removed
+     */
+    size_t size() const;
+
+    /**
+     * Remove all cached links. Requests in progress are not affected.
+     */
+    void clear();
+
+ private:
+    /**
+     * A cached link
+     */
+    struct Entry {
+        std::string key;
+        std::string url;
+        Clock::time_point expires;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    void insertLocked(const std::string& key, const std::string& url);
+
+    mutable std::mutex _mutex;
+    size_t _maxEntries;
+    Clock::duration _ttl;
+
+    // Most recently used first
+    EntryList _entries;
+    std::unordered_map<std::string, EntryList::iterator> _index;
+    std::unordered_map<std::string, std::vector<Waiter>> _inFlight;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_LINKCACHE_H__
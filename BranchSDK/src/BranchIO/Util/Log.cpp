@@ -8,6 +8,7 @@
 #include <sstream>
 #include <iomanip>
 #include <chrono>
+#include "AsyncLogChannel.h"
 #include "FileLogChannel.h"
 #include "ConsoleLogChannel.h"
 #include "StringUtils.h"
@@ -71,6 +72,9 @@ operator>>(std::istream& s, BranchIO::Log::Level& level) {
 
 namespace BranchIO {
 
+static_assert(Log::Error == BRANCHIO_LOG_LEVEL_ERROR && Log::Verbose == BRANCHIO_LOG_LEVEL_VERBOSE,
+    "BRANCHIO_LOG_LEVEL_* values must match Log::Level");
+
 int Log::_level = Log::getDefaultLogLevel();
 LogChannel* Log:: _channel = NULL;
 
@@ -118,6 +122,33 @@ Log::enableConsoleLogging(bool enableColors) {
     return instance();
 }
 
+Log&
+Log::enableAsyncLogging(size_t capacity, bool blockWhenFull) {
+    if (!_channel || dynamic_cast<AsyncLogChannel*>(_channel)) {
+        return instance();
+    }
+
+    AsyncLogChannel* channel = new AsyncLogChannel(
+        _channel,
+        capacity,
+        blockWhenFull ? AsyncLogChannel::BlockWhenFull : AsyncLogChannel::DropWhenFull);
+    channel->open();
+    _channel = channel;
+    return instance();
+}
+
+Log&
+Log::disableAsyncLogging() {
+    AsyncLogChannel* channel = dynamic_cast<AsyncLogChannel*>(_channel);
+    if (channel) {
+        _channel = channel->getChannel();
+        // Like the other channels, this one is not deleted, since another
+        // thread may still be using it. Once closed it writes synchronously.
+        channel->close();
+    }
+    return instance();
+}
+
 void
 Log::error(const std::string& message, const char* func, const char* file, int line) {
     if (_level >= Log::Error && _channel)
@@ -150,13 +181,11 @@ Log::verbose(const std::string& message, const char* func, const char* file, int
 
 std::string
 Log::buildMessage(Level level, const std::string& message, const char* func, const char* file, int line) {
-    string path(file ? file : "");
-
-    static const char* const separator("\\");
-
     // Just show the last path component
-    string::size_type offset = path.find_last_of(separator);
-    if (offset != string::npos) path = path.substr(offset + 1);
+    const char* path = file ? file : "";
+    for (const char* p = path; *p; ++p) {
+        if (*p == '\\' || *p == '/') path = p + 1;
+    }
 
     ostringstream oss;
     oss << getTimeStamp();
@@ -164,7 +193,7 @@ Log::buildMessage(Level level, const std::string& message, const char* func, con
     oss << GetCurrentThreadId() << "|";
     oss << level << "|";
 
-    if (!path.empty()) {
+    if (*path) {
         oss << path << ":" << line;
     }
 
@@ -103,6 +103,16 @@ class BRANCHIO_DLL_EXPORT Log {
         instance().verbose(message, func, file, line);
     }
 
+    /**
+     * Determine whether messages at a level will be logged. The BRANCH_LOG_*
+     * macros check this before building the message.
+     * @param level a Log::Level value
+     * @return true if messages at this level are written to a channel
+     */
+    static bool isEnabled(Level level) {
+        return _level >= level && _channel;
+    }
+
     /**
      * @return an instance of the Branch Log.
      */
@@ -131,6 +141,24 @@ class BRANCHIO_DLL_EXPORT Log {
      */
     static Log& enableFileLogging(const std::string& path);
 
+    /**
+     * Write log output on a background thread, so that logging never waits
+     * for I/O. Wraps the current channel. Call disableAsyncLogging() before
+     * exit to write out queued messages.
+     * @param capacity number of messages that can be queued
+     * @param blockWhenFull whether to wait for room when the queue is full,
+     *        rather than drop the message
+     * @return the singleton instance
+     */
+    static Log& enableAsyncLogging(size_t capacity = 1024, bool blockWhenFull = false);
+
+    /**
+     * Write out any queued messages and go back to writing log output on the
+     * calling thread.
+     * @return the singleton instance
+     */
+    static Log& disableAsyncLogging();
+
     /**
      * Send log output to the system log (only partly working)
      * @return the singleton instance
@@ -166,46 +194,68 @@ class BRANCHIO_DLL_EXPORT Log {
 
 }  // namespace BranchIO
 
-#define BRANCH_LOG_E(m) \
-    { \
-        std::ostringstream oss; \
-        oss << m; \
-        BranchIO::Log::e(oss.str(), __func__, __FILE__, __LINE__); \
-    }
+/*
+ * Compile-time log level. Calls to the BRANCH_LOG_* macros for less severe
+ * levels are removed entirely. Define BRANCHIO_LOG_MIN_LEVEL to one of the
+ * values below to override the default, which keeps Debug and Verbose
+ * logging in Debug builds only.
+ */
+#define BRANCHIO_LOG_LEVEL_ERROR    0
+#define BRANCHIO_LOG_LEVEL_WARNING  1
+#define BRANCHIO_LOG_LEVEL_INFO     2
+#define BRANCHIO_LOG_LEVEL_DEBUG    3
+#define BRANCHIO_LOG_LEVEL_VERBOSE  4
+
+#ifndef BRANCHIO_LOG_MIN_LEVEL
+    #ifdef DEBUG
+        #define BRANCHIO_LOG_MIN_LEVEL BRANCHIO_LOG_LEVEL_VERBOSE
+    #else
+        #define BRANCHIO_LOG_MIN_LEVEL BRANCHIO_LOG_LEVEL_INFO
+    #endif  // DEBUG
+#endif  // BRANCHIO_LOG_MIN_LEVEL
+
+/*
+ * The level is checked before the message is streamed, so arguments are
+ * not evaluated when the level is disabled.
+ */
+#define BRANCH_LOG_AT_LEVEL(level, fn, m) \
+    do { \
+        if (BranchIO::Log::isEnabled(level)) { \
+            std::ostringstream oss; \
+            oss << m; \
+            BranchIO::Log::fn(oss.str(), __func__, __FILE__, __LINE__); \
+        } \
+    } while (0)
 
-#define BRANCH_LOG_W(m) \
-    { \
-        std::ostringstream oss; \
-        oss << m; \
-        BranchIO::Log::w(oss.str(), __func__, __FILE__, __LINE__); \
-    }
+#if BRANCHIO_LOG_MIN_LEVEL >= BRANCHIO_LOG_LEVEL_ERROR
+    #define BRANCH_LOG_E(m) BRANCH_LOG_AT_LEVEL(BranchIO::Log::Error, e, m)
+#else
+    #define BRANCH_LOG_E(m)
+#endif
 
-#define BRANCH_LOG_I(m) \
-    { \
-        std::ostringstream oss; \
-        oss << m; \
-        BranchIO::Log::i(oss.str(), __func__, __FILE__, __LINE__); \
-    }
+#if BRANCHIO_LOG_MIN_LEVEL >= BRANCHIO_LOG_LEVEL_WARNING
+    #define BRANCH_LOG_W(m) BRANCH_LOG_AT_LEVEL(BranchIO::Log::Warning, w, m)
+#else
+    #define BRANCH_LOG_W(m)
+#endif
 
-#ifdef DEBUG
-    #define BRANCH_LOG_D(m) \
-        { \
-            std::ostringstream oss; \
-            oss << m; \
-            BranchIO::Log::d(oss.str(), __func__, __FILE__, __LINE__); \
-        }
+#if BRANCHIO_LOG_MIN_LEVEL >= BRANCHIO_LOG_LEVEL_INFO
+    #define BRANCH_LOG_I(m) BRANCH_LOG_AT_LEVEL(BranchIO::Log::Info, i, m)
+#else
+    #define BRANCH_LOG_I(m)
+#endif
 
-    #define BRANCH_LOG_V(m) \
-        { \
-            std::ostringstream oss; \
-            oss << m; \
-            BranchIO::Log::v(oss.str(), __func__, __FILE__, __LINE__); \
-        }
+#if BRANCHIO_LOG_MIN_LEVEL >= BRANCHIO_LOG_LEVEL_DEBUG
+    #define BRANCH_LOG_D(m) BRANCH_LOG_AT_LEVEL(BranchIO::Log::Debug, d, m)
 #else
-    // Debug and Verbose compiled out in Release builds.
     #define BRANCH_LOG_D(m)
+#endif
+
+#if BRANCHIO_LOG_MIN_LEVEL >= BRANCHIO_LOG_LEVEL_VERBOSE
+    #define BRANCH_LOG_V(m) BRANCH_LOG_AT_LEVEL(BranchIO::Log::Verbose, v, m)
+#else
     #define BRANCH_LOG_V(m)
-#endif  // DEBUG
+#endif
 
 std::ostream&
 operator<<(std::ostream& s, BranchIO::Log::Level level);
@@ -15,6 +15,14 @@ namespace BranchIO
     {
     }
 
+    void LogChannel::log(const std::vector<std::string>& messages)
+    {
+        for (const std::string& message : messages)
+        {
+            log(message);
+        }
+    }
+
     LogChannel::~LogChannel()
     {
     }
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 
 
 namespace BranchIO {
@@ -33,6 +34,13 @@ namespace BranchIO {
 		 */
 		virtual void log(const std::string& message) = 0;
 
+		/**
+		 * Logs a batch of messages to the channel, in order.
+		 * The default calls log() for each message. Channels that can
+		 * write several messages at once should override this.
+		 */
+		virtual void log(const std::vector<std::string>& messages);
+
 	protected:
 		virtual ~LogChannel();
 
@@ -0,0 +1,97 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_MPSCQUEUE_H__
+#define BRANCHIO_UTIL_MPSCQUEUE_H__
+
+#include <atomic>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Link for objects held in an MPSCQueue.
+ */
+struct MPSCQueueNode {
+    MPSCQueueNode() : mpscNext(nullptr) {}
+
+    /// Next node in the queue. Only used by MPSCQueue.
+    std::atomic<MPSCQueueNode*> mpscNext;
+};
+
+/**
+ * (Internal) Intrusive lock-free FIFO queue for any number of producers
+ * and a single consumer (D. Vyukov's node-based MPSC queue).
+ *
+ * push() is wait-free: an atomic exchange and a store. pop() must only be
+ * called by one thread at a time. The queue does not own its elements.
+ *
+ * pop() may return NULL while a push() on another thread is half done.
+ * The producer should notify the consumer after push() returns, and the
+ * consumer try again then.
+ *
+ * @tparam T element type, derived from MPSCQueueNode
+ */
+template <typename T>
+class MPSCQueue {
+ public:
+    MPSCQueue() : _head(&_stub), _tail(&_stub) {}
+
+    /**
+     * Add an element at the back of the queue. Safe to call from any thread.
+     * @param element the element. Must not be in any queue.
+     */
+    void push(T* element) {
+        push(static_cast<MPSCQueueNode*>(element));
+    }
+
+    /**
+     * Remove the element at the front of the queue. Single consumer only.
+     * @return the element, or NULL if the queue is empty
+     */
+    T* pop() {
+        MPSCQueueNode* tail = _tail;
+        MPSCQueueNode* next = tail->mpscNext.load(std::memory_order_acquire);
+        if (tail == &_stub) {
+            if (!next) return nullptr;
+            _tail = next;
+            tail = next;
+            next = next->mpscNext.load(std::memory_order_acquire);
+        }
+
+        if (next) {
+            _tail = next;
+            return static_cast<T*>(tail);
+        }
+
+        // tail is the last element, unless a producer is linking a new one.
+        if (tail != _head.load(std::memory_order_acquire)) return nullptr;
+
+        // Put the stub back so tail can be removed.
+        push(&_stub);
+        next = tail->mpscNext.load(std::memory_order_acquire);
+        if (next) {
+            _tail = next;
+            return static_cast<T*>(tail);
+        }
+
+        return nullptr;
+    }
+
+ private:
+    MPSCQueue(const MPSCQueue& o);
+    MPSCQueue& operator=(const MPSCQueue& o);
+
+    void push(MPSCQueueNode* node) {
+        node->mpscNext.store(nullptr, std::memory_order_relaxed);
+        MPSCQueueNode* previous = _head.exchange(node, std::memory_order_acq_rel);
+        previous->mpscNext.store(node, std::memory_order_release);
+    }
+
+    // Producers and the consumer work on different cache lines.
+    alignas(64) std::atomic<MPSCQueueNode*> _head;
+    alignas(64) MPSCQueueNode* _tail;
+    MPSCQueueNode _stub;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_MPSCQUEUE_H__
@@ -0,0 +1,223 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_OBJECTPOOL_H__
+#define BRANCHIO_UTIL_OBJECTPOOL_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Thread-safe pool of objects allocated in slabs.
+ *
+ * Memory is allocated a slab of objects at a time and kept on a free list
+ * when an object is released, so a steady stream of short-lived objects
+ * causes no heap allocation once the pool has grown to the largest number
+ * alive at once. Memory is returned to the heap when the pool is
+ * destroyed. Every object must be released before then.
+ *
+ * The free list is a lock-free (Treiber) stack, so acquiring and releasing
+ * objects takes no lock. Slots are linked by index, and the head carries a
+ * tag that changes on every update, so a slot that is popped and pushed
+ * again while another thread is about to pop it cannot corrupt the list.
+ * Only growing the pool by a slab takes a lock. A pool holds at most
+ * MaxSlabs slabs.
+ *
+ * acquire() returns a Ptr, a std::unique_ptr that releases the object to
+ * the pool when it goes out of scope. Ptr::release() and adopt() pass the
+ * object through containers that hold raw pointers.
+ *
+ * @tparam T type of the objects
+ */
+template <typename T>
+class ObjectPool {
+ public:
+    /// Maximum number of slabs in a pool
+    static const size_t MaxSlabs = 4096;
+
+    /**
+     * Deleter for Ptr. Destroys the object and puts its memory back on the
+     * free list.
+     */
+    class Deleter {
+     public:
+        Deleter() : _pool(nullptr) {}
+        explicit Deleter(ObjectPool* pool) : _pool(pool) {}
+
+        void operator()(T* object) const {
+            if (_pool) _pool->release(object);
+        }
+
+     private:
+        ObjectPool* _pool;
+    };
+
+    /// Owning pointer to a pooled object
+    typedef std::unique_ptr<T, Deleter> Ptr;
+
+    /**
+     * Constructor.
+     * @param slabSize number of objects allocated at once
+     */
+    explicit ObjectPool(size_t slabSize = 64) :
+        _slabSize(slabSize ? slabSize : 1),
+        _slabCount(0),
+        _free(EmptyHead),
+        _liveCount(0) {
+        for (std::atomic<Slot*>& slab : _slabs) {
+            slab.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ObjectPool() {
+        for (size_t j = 0; j < _slabCount.load(); ++j) {
+            delete[] _slabs[j].load();
+        }
+    }
+
+    /**
+     * Construct an object in pooled memory. Thread-safe.
+     * @param args arguments to T's constructor
+     * @return the new object
+     * @throw whatever T's constructor throws. The memory is returned to the pool.
+     * @throw std::bad_alloc if the pool already has MaxSlabs slabs
+     */
+    template <typename... Args>
+    Ptr acquire(Args&&... args) {
+        Slot* slot = allocate();
+        try {
+            T* object = new (slot->storage) T(std::forward<Args>(args)...);
+            return adopt(object);
+        }
+        catch (...) {
+            deallocate(slot);
+            throw;
+        }
+    }
+
+    /**
+     * Take ownership of an object previously obtained from acquire() and
+     * passed on with Ptr::release().
+     * @param object the object, or NULL
+     * @return an owning pointer to it
+     */
+    Ptr adopt(T* object) {
+        return Ptr(object, Deleter(this));
+    }
+
+    /**
+     * @return the number of objects that have been acquired and not released
+     */
+    size_t getLiveCount() const {
+        return _liveCount.load();
+    }
+
+    /**
+     * @return the number of objects the pool has memory for
+     */
+    size_t getCapacity() const {
+        return _slabCount.load() * _slabSize;
+    }
+
+ private:
+    ObjectPool(const ObjectPool& o);
+    ObjectPool& operator=(const ObjectPool& o);
+
+    // Index of no slot
+    static const uint32_t Null = UINT32_MAX;
+    // Free list head: tag in the high 32 bits, index of the first slot in the low
+    static const uint64_t EmptyHead = Null;
+
+    /**
+     * Memory for one object, with its free list link. The object is at the
+     * start, so a pointer to it is a pointer to its slot.
+     */
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        std::atomic<uint32_t> next;
+        uint32_t index;
+    };
+
+    static uint64_t makeHead(uint64_t previous, uint32_t index) {
+        return (((previous >> 32) + 1) << 32) | index;
+    }
+
+    Slot* getSlot(uint32_t index) const {
+        return _slabs[index / _slabSize].load(std::memory_order_acquire) + index % _slabSize;
+    }
+
+    Slot* allocate() {
+        uint64_t head = _free.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t index = static_cast<uint32_t>(head);
+            if (index == Null) {
+                grow();
+                head = _free.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // The slot may be taken by another thread in the meantime. Then
+            // the tag has changed and the exchange fails.
+            Slot* slot = getSlot(index);
+            uint32_t next = slot->next.load(std::memory_order_relaxed);
+            if (_free.compare_exchange_weak(head, makeHead(head, next), std::memory_order_acquire, std::memory_order_acquire)) {
+                _liveCount.fetch_add(1, std::memory_order_relaxed);
+                return slot;
+            }
+        }
+    }
+
+    void push(Slot* first, Slot* last) {
+        uint64_t head = _free.load(std::memory_order_relaxed);
+        do {
+            last->next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        } while (!_free.compare_exchange_weak(head, makeHead(head, first->index), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void deallocate(Slot* slot) {
+        push(slot, slot);
+        _liveCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void release(T* object) {
+        object->~T();
+        deallocate(reinterpret_cast<Slot*>(object));
+    }
+
+    void grow() {
+        std::scoped_lock _l(_growMutex);
+        // Another thread may have grown the pool, or released an object.
+        if (static_cast<uint32_t>(_free.load(std::memory_order_acquire)) != Null) return;
+
+        size_t slabIndex = _slabCount.load(std::memory_order_relaxed);
+        if (slabIndex == MaxSlabs || (slabIndex + 1) * _slabSize >= Null) throw std::bad_alloc();
+
+        Slot* slab = new Slot[_slabSize];
+        for (size_t j = 0; j < _slabSize; ++j) {
+            slab[j].index = static_cast<uint32_t>(slabIndex * _slabSize + j);
+            slab[j].next.store(j + 1 < _slabSize ? slab[j].index + 1 : Null, std::memory_order_relaxed);
+        }
+        _slabs[slabIndex].store(slab, std::memory_order_release);
+        _slabCount.store(slabIndex + 1);
+
+        push(&slab[0], &slab[_slabSize - 1]);
+    }
+
+    size_t const _slabSize;
+    std::atomic<Slot*> _slabs[MaxSlabs];
+    std::atomic<size_t> _slabCount;
+    // Only held while adding a slab
+    std::mutex _growMutex;
+    std::atomic<uint64_t> _free;
+    std::atomic<size_t> _liveCount;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_OBJECTPOOL_H__
@@ -2,10 +2,16 @@
 
 #include "RequestManager.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <climits>
+#include <winrt/Windows.Foundation.h>
 
+#include "BranchIO/Util/ClientSessionFactory.h"
 #include "BranchIO/Util/IClientSession.h"
 #include "BranchIO/AdvertiserInfo.h"
+#include "BranchIO/Event/PersistedEvent.h"
 #include "BranchIO/IPackagingInfo.h"
 #include "BranchIO/Util/Log.h"
 #include "BranchIO/Util/Storage.h"
@@ -13,60 +19,190 @@
 
 namespace BranchIO {
 
-RequestManager::RequestManager(IPackagingInfo& packagingInfo, IClientSession *clientSession) :
+/**
+ * (Internal) Callback for events restored from the event queue file. The
+ * callbacks passed when they were originally queued are gone.
+ */
+class PersistedEventCallback : public IRequestCallback {
+ public:
+    virtual void onSuccess(int id, JSONObject jsonResponse) {
+        BRANCH_LOG_D("Persisted event sent.");
+    }
+
+    virtual void onError(int id, int error, std::string description) {
+        BRANCH_LOG_W("Persisted event failed. " << error << ": " << description);
+    }
+
+    virtual void onStatus(int id, int error, std::string description) {
+        BRANCH_LOG_V("Persisted event status. " << error << ": " << description);
+    }
+};
+
+static PersistedEventCallback persistedEventCallback;
+
+static std::vector<unsigned int> getPriorityWeights() {
+    std::vector<unsigned int> weights;
+    for (int j = 0; j < RequestManager::PriorityCount; ++j) {
+        weights.push_back(RequestManager::getPriorityWeight(static_cast<RequestManager::Priority>(j)));
+    }
+    return weights;
+}
+
+RequestManager::RequestManager(
+    IPackagingInfo& packagingInfo,
+    IClientSession *clientSession,
+    const Configuration& configuration) :
+    _queue(getPriorityWeights()),
+    _queuedSequencedCount(0),
+    _activeSequencedCount(0),
+    _configuration(configuration),
     _defaultCallback(nullptr),
     _packagingInfo(&packagingInfo),
     _clientSession(clientSession),
-    _shuttingDown(false),
-    _currentRequest(nullptr) {
+    _shuttingDown(false) {
+    if (!_configuration.getEventQueuePath().empty()) {
+        _durableQueue.reset(new DurableQueue(_configuration.getEventQueuePath(), _configuration.getEventQueueSyncCount()));
+        if (!_durableQueue->open(_persistedRecords)) {
+            _durableQueue.reset();
+        }
+    }
 }
 
 RequestManager::~RequestManager() {
     // Make sure the thread is terminated before we exit.
     stop();
     waitTillFinished();
+    releaseTasks();
 }
 
 RequestManager&
 RequestManager::setDefaultCallback(IRequestCallback* callback) {
-    std::scoped_lock _l(_mutex);
-    _defaultCallback = callback;
+    _defaultCallback.store(callback);
     return *this;
 }
 
 IRequestCallback*
 RequestManager::getDefaultCallback() const {
-    std::scoped_lock _l(_mutex);
-    return _defaultCallback;
+    return _defaultCallback.load();
 }
 
 RequestManager& RequestManager::enqueue(
     const BaseEvent& event,
     IRequestCallback* callback,
     bool urgent) {
-    // Make a copy of the Request on the heap. This will throw if both
-    // callback and getDefaultCallback() are NULL.
-    RequestTask* task = new RequestTask(*this, event, callback ? callback : getDefaultCallback());
+    return enqueue(BaseEvent(event), callback, urgent);
+}
+
+RequestManager& RequestManager::enqueue(
+    std::unique_ptr<BaseEvent> event,
+    IRequestCallback* callback,
+    bool urgent) {
+    if (!event) throw std::exception("InvalidArgumentException - event cannot be NULL.");
+    return enqueue(std::move(*event), callback, urgent);
+}
+
+RequestManager& RequestManager::enqueue(
+    BaseEvent&& event,
+    IRequestCallback* callback,
+    bool urgent) {
+    callback = callback ? callback : getDefaultCallback();
+    if (!callback) throw std::exception("InvalidArgumentException - callback cannot be NULL.");
+
+    // Before it is persisted, so that the deadline survives a restart
+    if (!event.hasDeadline() && _configuration.getEventTTLMillis() > 0) {
+        event.setTimeToLive(std::chrono::milliseconds(_configuration.getEventTTLMillis()));
+    }
+
+    uint64_t recordId = 0;
+    if (_durableQueue && !urgent && isPersistent(event.getAPIEndpoint())) {
+        recordId = _durableQueue->append(PersistedEvent::serialize(event));
+    }
+
+    enqueueEvent(std::move(event), callback, urgent, recordId);
+    return *this;
+}
+
+void RequestManager::enqueueEvent(
+    BaseEvent&& event,
+    IRequestCallback* callback,
+    bool urgent,
+    uint64_t recordId) {
+    if (!urgent && _configuration.isBatchingEnabled() && EventBatch::isBatchable(event.getAPIEndpoint())) {
+        enqueueBatchedEvent(std::move(event), callback, recordId);
+        return;
+    }
+
+    // Make a copy of the Request in the task pool. This will throw if
+    // callback is NULL.
+    TaskPool::Ptr task(_taskPool.acquire(*this, std::move(event), callback, recordId));
 
     if (urgent) {
-        enqueueUrgentTask(task);
+        enqueueUrgentTask(task.release());
     } else {
-        enqueueTask(task);
+        enqueueTask(task.release());
+    }
+}
+
+void RequestManager::enqueuePersistedEvents() {
+    std::vector<DurableQueue::Record> records;
+    {
+        std::scoped_lock _l(_mutex);
+        records.swap(_persistedRecords);
     }
 
-    return *this;
+    for (const DurableQueue::Record& record : records) {
+        std::unique_ptr<PersistedEvent> event(PersistedEvent::deserialize(record.payload));
+        if (!event) {
+            BRANCH_LOG_W("Discarding unreadable persisted event " << record.id);
+            _durableQueue->acknowledge(record.id);
+            continue;
+        }
+
+        enqueueEvent(std::move(*event), &persistedEventCallback, false, record.id);
+    }
+
+    if (!records.empty()) {
+        BRANCH_LOG_I("Restored " << records.size() << " persisted events.");
+    }
+}
+
+bool RequestManager::isPersistent(Defines::APIEndpoint endpoint) {
+    switch (endpoint) {
+        case Defines::COMPLETED_ACTION:
+        case Defines::CONTENT_EVENT:
+        case Defines::TRACK_STANDARD_EVENT:
+        case Defines::TRACK_CUSTOM_EVENT:
+            return true;
+
+        default:
+            return false;
+    }
 }
 
 void RequestManager::start() {
-    // start background thread for sending events to server
-    _thread = std::thread(&RequestManager::run, this);
+    if (_durableQueue) enqueuePersistedEvents();
+
+    // start background threads for sending events to server
+    for (unsigned int j = 0; j < _configuration.getRequestConcurrency(); ++j) {
+        _threads.emplace_back(&RequestManager::run, this);
+    }
 }
 
 void RequestManager::stop() {
-    if (getCurrentRequest()) getCurrentRequest()->cancel();
+    {
+        std::scoped_lock _l(_mutex);
+        for (RequestTask* task : _activeTasks) {
+            task->getRequest().cancel();
+        }
+
+        // Retries are not sent. Their events stay in the event queue file.
+        _retryTimers.clear();
+        _dueRetries.clear();
+    }
     if (getClientSession()) getClientSession()->stop();
+    if (_durableQueue) _durableQueue->sync();
 
-    if (!_thread.joinable()) return;
+    if (_threads.empty()) return;
 
     // Stop the background thread
     {
@@ -79,7 +215,35 @@ void RequestManager::stop() {
 
 void
 RequestManager::waitTillFinished() {
-    _thread.join();
+    for (std::thread& thread : _threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+IClientSession* RequestManager::acquireClientSession() {
+    IClientSession* clientSession = _clientSession.load();
+    if (clientSession) return clientSession;
+
+    std::scoped_lock _l(_mutex);
+    if (_clientSession.load() || _shuttingDown) return _clientSession.load();
+
+    try {
+        /*
+         * One session for the lifetime of this RequestManager. It keeps
+         * connections to the API alive between requests and allows one
+         * connection per worker thread.
+         */
+        _ownedClientSession = ClientSessionFactory::create(_configuration, _configuration.getRequestConcurrency());
+        _clientSession.store(_ownedClientSession.get());
+    }
+    catch (winrt::hresult_error const& e) {
+        BRANCH_LOG_E("Connection failed. " << e.code() << ": " << e.message().c_str());
+    }
+    catch (std::exception const& e) {
+        BRANCH_LOG_E("Connection failed. " << e.what());
+    }
+
+    return _clientSession.load();
 }
 
 bool RequestManager::isShuttingDown() const {
@@ -87,6 +251,9 @@ bool RequestManager::isShuttingDown() const {
 }
 
 void RequestManager::run() {
+    // Each worker makes WinRT calls through the shared client session.
+    winrt::init_apartment();
+
     try {
         while (!isShuttingDown()) {
             RequestTask* requestTask = waitDequeueNotification();
@@ -98,9 +265,12 @@ void RequestManager::run() {
 
             // We have an indefinite wait, so the only way we can get here is
             // if we have a notification.
-            setCurrentRequest(&requestTask->getRequest());
-            requestTask->runTask();
-            setCurrentRequest(nullptr);
+            int32_t retryMillis = requestTask->runTask();
+            if (retryMillis > 0) {
+                scheduleRetry(requestTask, retryMillis);
+            } else {
+                finishTask(requestTask);
+            }
         }
     }
     catch (std::exception& e) {
@@ -117,18 +287,94 @@ void RequestManager::run() {
 
 RequestManager::RequestTask::RequestTask(
     RequestManager& manager,
-    const BaseEvent& event,
-    IRequestCallback* callback) :
+    BaseEvent&& event,
+    IRequestCallback* callback,
+    uint64_t recordId) :
         _manager(manager),
-        _event(event),
-        _callback(callback) {
+        _event(std::move(event)),
+        _callback(callback),
+        _sequenced(RequestManager::isSequenced(_event->getAPIEndpoint())),
+        _packaged(false) {
     if (!_callback) throw std::exception("InvalidArgumentException - callback cannot be NULL.");
+    if (recordId) _recordIds.push_back(recordId);
+    _request.setDeadline(_event->getDeadline());
 }
 
-void
+RequestManager::RequestTask::RequestTask(
+    RequestManager& manager,
+    const std::shared_ptr<EventBatch>& batch) :
+        _manager(manager),
+        _batch(batch),
+        _callback(batch.get()),
+        _sequenced(false),
+        _recordIds(batch->getRecordIds()),
+        _packaged(false) {
+    _request.setDeadline(batch->getExpiry());
+}
+
+Defines::APIEndpoint
+RequestManager::RequestTask::getAPIEndpoint() const {
+    return _batch ? Defines::TRACK_EVENT_BATCH : _event->getAPIEndpoint();
+}
+
+int32_t
 RequestManager::RequestTask::runTask() {
-    JSONObject payload;
-    _event.package(_manager.getPackagingInfo(), payload);
+    // A batch lives as long as its latest event. Events that expired
+    // before it was sent are dropped from it.
+    if (_batch && removeExpiredEvents() && _batch->size() == 0) return 0;
+
+    // Retries send the same payload.
+    if (!_packaged) {
+        package(_payload);
+        _packaged = true;
+    }
+
+    // Send request synchronously
+    // _clientSession may be passed in for testing. If not, the manager
+    // creates a real one on first use and all tasks reuse it.
+    JSONObject result;
+    IClientSession* clientSession = _manager.acquireClientSession();
+    if (clientSession) {
+        try {
+            int32_t retryMillis = _request.attempt(getAPIEndpoint(), _payload, *_callback, clientSession, result);
+            if (retryMillis > 0) return retryMillis;
+        }
+        catch (winrt::hresult_error const& e) {
+            BRANCH_LOG_E("Connection failed. " << e.code() << ": " << e.message().c_str());
+        }
+    }
+
+    if (_batch) {
+        _batch->handleResult(result);
+    } else {
+        _event->handleResult(result);
+    }
+    return 0;
+}
+
+bool
+RequestManager::RequestTask::removeExpiredEvents() {
+    std::vector<uint64_t> expiredRecordIds;
+    if (_batch->removeExpired(BaseEvent::Clock::now(), expiredRecordIds) == 0) return false;
+
+    // Expired events are not sent later either.
+    for (uint64_t recordId : expiredRecordIds) {
+        if (_manager._durableQueue) _manager._durableQueue->acknowledge(recordId);
+        _recordIds.erase(std::remove(_recordIds.begin(), _recordIds.end(), recordId), _recordIds.end());
+    }
+
+    _request.setDeadline(_batch->getExpiry());
+    _packaged = false;
+    return true;
+}
+
+void
+RequestManager::RequestTask::package(JSONObject& payload) {
+    if (_batch) {
+        _batch->package(_manager.getPackagingInfo(), payload);
+    } else {
+        _event->package(_manager.getPackagingInfo(), payload);
+    }
 
     if (_manager.getPackagingInfo().getAdvertiserInfo().isTrackingDisabled()) {
         payload.set(Defines::JSONKEY_TRACKING_DISABLED, true);
@@ -142,62 +388,303 @@ RequestManager::RequestTask::runTask() {
         payload.remove(Defines::JSONKEY_SESSION_RANDOMIZED_BUNDLE_TOKEN);         // randomized_bundle_token
         payload.remove("advertising_ids");
     }
+}
 
-    // Send request synchronously
-    // _clientSession may be passed in for testing. If not, we
-    // create/reuse a real one here
-    JSONObject result;
-    if (_manager.getClientSession()) {
-        result = _request.send(_event.getAPIEndpoint(), payload, *_callback, _manager.getClientSession());
+void RequestManager::enqueueTask(RequestTask* task)
+{
+    if (_configuration.isBatchingEnabled()) {
+        std::scoped_lock  lock(_mutex);
+        // Events batched before this request are queued ahead of it.
+        drainLanes();
+        flushPendingBatch();
+        pushTask(task);
     } else {
-        try {
-            APIClientSession clientSession(BRANCH_IO_URL_BASE);
-            _manager.setClientSession(&clientSession);
-            result = _request.send(_event.getAPIEndpoint(), payload, *_callback, &clientSession);
-            _manager.setClientSession(nullptr);
-        }
-        catch (winrt::hresult_error const& e) {
-            BRANCH_LOG_E("Connection failed. " << e.code() << ": " << e.message().c_str());
-        }
+        _normalLane.push(task);
     }
+    _available.notifyOne();
+}
 
-    _event.handleResult(result);
+void RequestManager::enqueueUrgentTask(RequestTask* task)
+{
+    _urgentLane.push(task);
+    _available.notifyOne();
 }
 
-void RequestManager::enqueueTask(RequestTask* task)
+void RequestManager::drainLanes()
 {
-    std::scoped_lock  lock(_mutex);
-    _queue.push_back(task);
-    _available.notify_one();
+    while (RequestTask* task = _normalLane.pop()) {
+        flushPendingBatch();
+        pushTask(task);
+    }
+
+    while (RequestTask* task = _urgentLane.pop()) {
+        _queue.push(PriorityUrgent, task);
+    }
 }
 
-void RequestManager::enqueueUrgentTask(RequestTask* task)
+void RequestManager::enqueueBatchedEvent(BaseEvent&& event, IRequestCallback* callback, uint64_t recordId)
 {
+    if (!callback) throw std::exception("InvalidArgumentException - callback cannot be NULL.");
+
     std::scoped_lock  lock(_mutex);
-    _queue.push_front(task);
-    _available.notify_one();
+    if (!_pendingBatch) {
+        EventBatch::Clock::time_point deadline =
+            EventBatch::Clock::now() + std::chrono::milliseconds(_configuration.getBatchMaxAgeMillis());
+        _pendingBatch = std::make_shared<EventBatch>(deadline);
+    }
+
+    _pendingBatch->add(std::move(event), callback, recordId);
+
+    if (_pendingBatch->size() >= _configuration.getBatchMaxEvents() ||
+        _pendingBatch->getByteCount() >= _configuration.getBatchMaxBytes()) {
+        flushPendingBatch();
+    }
+
+    // Wake a worker to send the batch or wait for its deadline.
+    _available.notifyOne();
+}
+
+void RequestManager::flushPendingBatch()
+{
+    if (!_pendingBatch) return;
+
+    TaskPool::Ptr task(_taskPool.acquire(*this, _pendingBatch));
+    pushTask(task.get());
+    task.release();
+    _pendingBatch.reset();
 }
 
+void RequestManager::pushTask(RequestTask* task)
+{
+    // Nothing queued after a sequenced task may be dequeued before it.
+    if (_queuedSequencedCount > 0) {
+        _heldTasks.push_back(task);
+        return;
+    }
+
+    _queue.push(getPriority(task->getAPIEndpoint()), task);
+    if (task->isSequenced()) ++ _queuedSequencedCount;
+}
+
+void RequestManager::releaseHeldTasks()
+{
+    while (!_heldTasks.empty() && _queuedSequencedCount == 0) {
+        RequestTask* task = _heldTasks.front();
+        _heldTasks.pop_front();
+        pushTask(task);
+    }
+}
 
 RequestManager::RequestTask* RequestManager::waitDequeueNotification()
 {
     std::unique_lock<std::mutex>  lock(_mutex);
 
-    _available.wait(lock, [=] { return (!_queue.empty() ||(_shuttingDown == true));});
+    /*
+     * The task at the front of the queue may be sent if no sequenced task is
+     * in flight. A sequenced task must also wait for every other active
+     * task to finish. An expired task is dropped right away. Held tasks
+     * wait for the sequenced task in the queue.
+     */
+    auto isReady = [=] {
+        if (_shuttingDown || !_dueRetries.empty()) return true;
+        if (_queue.empty()) return false;
+        RequestTask* next = _queue.front();
+        if (next->getRequest().isExpired()) return true;
+        if (_activeSequencedCount > 0) return false;
+        return !next->isSequenced() || _activeTasks.empty();
+    };
+
+    auto moveDueRetries = [=](EventBatch::Clock::time_point now) {
+        _retryTimers.advance(now, [=](RequestTask* task) { _dueRetries.push_back(task); });
+    };
+
+    // A pending batch is queued once it reaches its deadline. A task
+    // waiting to be retried is run again once its timer fires.
+    drainLanes();
+    moveDueRetries(EventBatch::Clock::now());
+    while (!isReady()) {
+        EventBatch::Clock::time_point now = EventBatch::Clock::now();
+        if (_pendingBatch && now >= _pendingBatch->getDeadline()) {
+            flushPendingBatch();
+            continue;
+        }
+
+        EventBatch::Clock::time_point deadline(EventBatch::Clock::time_point::max());
+        if (_pendingBatch) deadline = _pendingBatch->getDeadline();
+
+        EventBatch::Clock::time_point retryDeadline;
+        if (_retryTimers.getNextDeadline(retryDeadline) && retryDeadline < deadline) {
+            deadline = retryDeadline;
+        }
+
+        // Tasks pushed onto a lane after this are not missed.
+        EventCount::Key key = _available.prepareWait();
+        drainLanes();
+        if (isReady()) {
+            _available.cancelWait();
+            break;
+        }
+
+        int32_t timeoutMillis = -1;
+        if (deadline != EventBatch::Clock::time_point::max()) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+            timeoutMillis = static_cast<int32_t>(std::min<long long>(remaining, INT32_MAX));
+        }
+
+        lock.unlock();
+        _available.wait(key, timeoutMillis);
+        lock.lock();
+
+        drainLanes();
+        moveDueRetries(EventBatch::Clock::now());
+    }
+
+    if (!_dueRetries.empty() && !_shuttingDown) {
+        // Already active
+        RequestManager::RequestTask* task = _dueRetries.front();
+        _dueRetries.pop_front();
+        return task;
+    }
+
+    if (_shuttingDown) return NULL;
+
+    RequestManager::RequestTask* task = NULL;
+    if (!_queue.empty()) {
+        task = _queue.pop();
+        if (task->isSequenced()) {
+            // The tasks queued after it, up to the next sequenced one, may
+            // now be scheduled. They still wait for it to finish.
+            -- _queuedSequencedCount;
+            releaseHeldTasks();
+        }
+    }
 
-    if (!_queue.empty()){
-        RequestManager::RequestTask* task = _queue.front();
-        _queue.pop_front();
+    if (task) {
+        _activeTasks.push_back(task);
+        if (task->isSequenced()) ++ _activeSequencedCount;
         return task;
     } else {
         return NULL;
     }
 }
 
-void RequestManager::wakeUpAll()
+void RequestManager::scheduleRetry(RequestTask* task, int32_t delayMillis)
+{
+    std::scoped_lock lock(_mutex);
+    if (_shuttingDown) return;
+
+    _retryTimers.schedule(EventBatch::Clock::now() + std::chrono::milliseconds(delayMillis), task);
+
+    // A waiting worker may have to wake up sooner.
+    _available.notifyAll();
+}
+
+void RequestManager::finishTask(RequestTask* task)
+{
+    // Back to the pool once it is no longer active
+    TaskPool::Ptr finished(_taskPool.adopt(task));
+
+    // Requests canceled on shutdown stay in the event queue file to be sent
+    // next time. Anything else was either sent or failed permanently.
+    if (_durableQueue && !task->getRequest().isCanceled()) {
+        for (uint64_t recordId : task->getRecordIds()) {
+            _durableQueue->acknowledge(recordId);
+        }
+    }
+
+    std::scoped_lock lock(_mutex);
+    _activeTasks.erase(std::remove(_activeTasks.begin(), _activeTasks.end(), task), _activeTasks.end());
+    if (task->isSequenced()) -- _activeSequencedCount;
+
+    // A sequenced task may now be able to run, or other tasks may be unblocked.
+    _available.notifyAll();
+}
+
+void RequestManager::releaseTasks()
 {
     std::scoped_lock lock(_mutex);
-    _available.notify_all();
+    drainLanes();
+
+    // Tasks waiting to be retried are also active.
+    _retryTimers.clear();
+    _dueRetries.clear();
+    for (RequestTask* task : _activeTasks) {
+        _taskPool.adopt(task);
+    }
+    _activeTasks.clear();
+    _activeSequencedCount = 0;
+
+    _queue.forEach([this](RequestTask* task) { _taskPool.adopt(task); });
+    _queue.clear();
+    _queuedSequencedCount = 0;
+    for (RequestTask* task : _heldTasks) {
+        _taskPool.adopt(task);
+    }
+    _heldTasks.clear();
+}
+
+RequestManager::Priority RequestManager::getPriority(Defines::APIEndpoint endpoint)
+{
+    switch (endpoint) {
+        case Defines::REGISTER_OPEN:
+        case Defines::REGISTER_CLOSE:
+            return PrioritySession;
+
+        case Defines::IDENTIFY_USER:
+        case Defines::LOGOUT:
+            return PriorityIdentity;
+
+        case Defines::URL:
+        case Defines::REDEEM_REWARDS:
+        case Defines::GET_CREDITS:
+        case Defines::GET_CREDIT_HISTORY:
+        case Defines::GET_REFERRAL_CODE:
+        case Defines::VALIDATE_REFERRAL_CODE:
+        case Defines::APPLY_REFERRAL_CODE:
+            return PriorityLink;
+
+        case Defines::TRACK_STANDARD_EVENT:
+            return PriorityCommerce;
+
+        default:
+            return PriorityAnalytics;
+    }
+}
+
+unsigned int RequestManager::getPriorityWeight(Priority priority)
+{
+    switch (priority) {
+        case PriorityUrgent:
+            return 0;
+        case PrioritySession:
+            return 16;
+        case PriorityIdentity:
+        case PriorityLink:
+            return 8;
+        case PriorityCommerce:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+bool RequestManager::isSequenced(Defines::APIEndpoint endpoint)
+{
+    switch (endpoint) {
+        case Defines::REGISTER_OPEN:
+        case Defines::REGISTER_CLOSE:
+        case Defines::LOGOUT:
+        case Defines::IDENTIFY_USER:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void RequestManager::wakeUpAll()
+{
+    _available.notifyAll();
 }
 
 
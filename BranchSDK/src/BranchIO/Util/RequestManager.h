@@ -3,26 +3,99 @@
 #ifndef BRANCHIO_UTIL_REQUESTMANAGER_H__
 #define BRANCHIO_UTIL_REQUESTMANAGER_H__
 
-#include "APIClientSession.h"
+#include "BranchIO/Configuration.h"
 #include "BranchIO/Event/Event.h"
 #include "BranchIO/fwd.h"
 #include "BranchIO/Request.h"
+#include "DurableQueue.h"
+#include "EventBatch.h"
+#include "EventCount.h"
+#include "IClientSession.h"
+#include "MPSCQueue.h"
+#include "ObjectPool.h"
+#include "TimerWheel.h"
+#include "WeightedFairQueue.h"
+#include <atomic>
 #include <deque>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
 
 namespace BranchIO {
 
 /**
- * (Internal) Thread-safe request manager class with an optional background thread
+ * (Internal) Thread-safe request manager class with a pool of background threads
  * that manages a priority request queue with callbacks.
+ *
+ * Each Priority has its own FIFO lane. Urgent requests are sent first. The
+ * other lanes are served in proportion to their weights, so opens and
+ * links are not stuck behind a backlog of analytics events, which still
+ * get their share.
+ *
+ * Session requests (opens, closes, logouts and identity requests) are
+ * sequenced. They go in the session and identity lanes like any other
+ * request, so they overtake the events queued before them. Once dequeued,
+ * a sequenced request waits for the requests in flight to finish, and
+ * nothing else is dequeued until it completes. Requests queued after a
+ * sequenced request are held back until it is dequeued, so none of them
+ * is sent before it. Urgent requests are never held back. All other
+ * requests are sent in parallel by up to
+ * Configuration::getRequestConcurrency() worker threads.
+ *
+ * When batching is enabled in the Configuration, standard and custom events
+ * are collected into an EventBatch that is queued as a single request when
+ * it is full or too old, or before any other request is queued behind it.
+ *
+ * When an event queue path is set in the Configuration, events other than
+ * session requests are also written to a DurableQueue when they are queued
+ * and acknowledged when they have been sent. Events left in the file by a
+ * previous run are queued again by start().
+ *
+ * Requests are queued without taking a lock: enqueue() pushes them onto
+ * one of two lock-free MPSC queues, one for urgent requests and one for
+ * the rest, and the worker threads move them into the priority lanes.
+ * Only batched events are queued under the lock.
+ *
+ * An event may have a deadline, set on the event or from
+ * Configuration::getEventTTLMillis(). An expired event is dropped when it
+ * is dequeued or before it is retried, and its callback's onError is
+ * called. It does not wait for a session request in flight. Expired events
+ * are also removed from a batch before it is sent.
+ *
+ * A request that fails is not retried by the worker that sent it. It is
+ * put on a timer wheel until its retry time, and the worker goes on to
+ * other requests. It still counts as in flight for sequencing.
+ *
+ * Tasks are allocated from a pool owned by the manager and returned to it
+ * when they finish. Tasks still queued when the manager is destroyed are
+ * released by the destructor.
  */
 class BRANCHIO_DLL_EXPORT RequestManager {
  public:
+    /**
+     * Request priority classes, from highest to lowest.
+     */
+    enum Priority {
+        PriorityUrgent,     ///< Requests queued with the urgent flag
+        PrioritySession,    ///< Opens and closes
+        PriorityIdentity,   ///< Identify and logout requests
+        PriorityLink,       ///< Links, referral codes, credits and rewards
+        PriorityCommerce,   ///< Standard events, which include commerce events
+        PriorityAnalytics,  ///< Custom and content events, completed actions and batches
+        PriorityCount       ///< Number of priority classes
+    };
+
     /**
      * Constructor.
      * @param packagingInfo reference to a source of packaging information
      * @param clientSession existing client session, or NULL to start a new session
+     * @param configuration SDK configuration, e.g. the number of worker threads
      */
-    explicit RequestManager(IPackagingInfo& packagingInfo, IClientSession* clientSession = nullptr);
+    explicit RequestManager(
+        IPackagingInfo& packagingInfo,
+        IClientSession* clientSession = nullptr,
+        const Configuration& configuration = Configuration());
     ~RequestManager();
 
     /**
@@ -40,14 +113,15 @@ class BRANCHIO_DLL_EXPORT RequestManager {
     IRequestCallback* getDefaultCallback() const;
 
     /**
-     * Insert a request at the back of the queue with an optional callback.
-     * If callback is NULL, the
-     * Requests are processed in insertion order. However if the optional urgent
-     * flag is set, the request is inserted at the front of the queue.
+     * Insert a request at the back of its priority lane with an optional
+     * callback. If callback is NULL, the default callback is used.
+     * Requests in the same lane are processed in insertion order. If the
+     * optional urgent flag is set, the request goes in the urgent lane,
+     * which is served before all others.
      *
      * @param event Event to send
      * @param callback (optional) Interface for success and failure response.
-     * @param urgent (optional) if true, the request is inserted at the front of the queue instead of the back.
+     * @param urgent (optional) if true, the request is inserted in the urgent lane instead of its priority lane.
      * @return a reference to the RequestManager
      * @throw std::exception - InvalidArgumentException if callback and the default callback are both NULL
      */
@@ -57,25 +131,57 @@ class BRANCHIO_DLL_EXPORT RequestManager {
         bool urgent = false);
 
     /**
-     * Start(create) the request manager's background thread.
+     * Move a request to the back of the queue with an optional callback.
+     * The event's properties are moved into the request instead of copied.
+     *
+     * @param event Event to send. Left empty.
+     * @param callback (optional) Interface for success and failure response.
+     * @param urgent (optional) if true, the request is inserted in the urgent lane instead of its priority lane.
+     * @return a reference to the RequestManager
+     * @throw std::exception - InvalidArgumentException if callback and the default callback are both NULL
+     */
+    RequestManager& enqueue(
+        BaseEvent&& event,
+        IRequestCallback* callback = nullptr,
+        bool urgent = false);
+
+    /**
+     * Insert a request at the back of the queue, taking ownership of the
+     * event. The event's properties are moved into the request instead of
+     * copied.
+     *
+     * @param event Event to send. Must not be NULL.
+     * @param callback (optional) Interface for success and failure response.
+     * @param urgent (optional) if true, the request is inserted in the urgent lane instead of its priority lane.
+     * @return a reference to the RequestManager
+     * @throw std::exception - InvalidArgumentException if event is NULL, or if callback and the default callback are both NULL
+     */
+    RequestManager& enqueue(
+        std::unique_ptr<BaseEvent> event,
+        IRequestCallback* callback = nullptr,
+        bool urgent = false);
+
+    /**
+     * Start(create) the request manager's background threads. Events
+     * restored from the event queue file, if any, are queued first.
      */
     void start();
 
     /**
-     *  Request manager's background thread executes this method when its started.
-     *  It dequeues RequestTask from queue and executes them one by one.
+     *  Each of the request manager's background threads executes this method when started.
+     *  It dequeues RequestTasks from the queue and executes them one by one.
      */
     void run();
 
     /**
-     * Stop the request manager's background thread and join the worker thread.
+     * Stop the request manager's background threads and cancel any requests in flight.
      * Automatically called from the destructor. Safe to call explicitly as
      * well.
      */
     void stop();
 
     /**
-     * Block until the background thread has terminated. The destructor also
+     * Block until all background threads have terminated. The destructor also
      * blocks.
      */
     void waitTillFinished();
@@ -85,6 +191,23 @@ class BRANCHIO_DLL_EXPORT RequestManager {
      */
     bool isShuttingDown() const;
 
+    /**
+     * Determine the priority class of requests to an endpoint.
+     * @param endpoint the API endpoint
+     * @return the priority of requests queued without the urgent flag
+     */
+    static Priority getPriority(Defines::APIEndpoint endpoint);
+
+    /**
+     * Get the share of the workers a priority lane gets while other lanes
+     * also have requests waiting. A lane with weight 8 is served eight
+     * times as often as one with weight 1.
+     * @param priority a priority class
+     * @return the lane's weight, or 0 for the urgent lane, which is always
+     *         served first
+     */
+    static unsigned int getPriorityWeight(Priority priority);
+
  protected:
     /**
      * (Unimplemented) Copy constructor.
@@ -106,19 +229,29 @@ class BRANCHIO_DLL_EXPORT RequestManager {
      * Just contains the request and callback and sends the request
      * synchronously via runTask().
      */
-    struct RequestTask {
+    struct RequestTask : public MPSCQueueNode {
         /**
          * Constructor.
          * @param manager A reference to the RequestManager that enqueued this
-         * @param event Event to send
+         * @param event Event to send. Moved into the task.
          * @param callback Interface for success and failure response.
+         * @param recordId id of the event in the durable event queue, or 0
+         */
+        RequestTask(RequestManager& manager, BaseEvent&& event, IRequestCallback* callback, uint64_t recordId = 0);
+
+        /**
+         * Constructor for a batch of events sent in a single request.
+         * @param manager A reference to the RequestManager that enqueued this
+         * @param batch Events to send. The batch is also the callback.
          */
-        RequestTask(RequestManager& manager, const BaseEvent& event, IRequestCallback* callback);
+        RequestTask(RequestManager& manager, const std::shared_ptr<EventBatch>& batch);
 
         /**
-         * Task Runner
+         * Task Runner. Makes one attempt to send the request.
+         * @return 0 if the task is finished, otherwise the time in ms until
+         *         it should run again
          */
-        void runTask();
+        int32_t runTask();
 
         /**
          * Get a reference to the Request object. Used to terminate retry loops
@@ -134,80 +267,193 @@ class BRANCHIO_DLL_EXPORT RequestManager {
          */
         Request const& getRequest() const { return _request; }
 
+        /**
+         * Determine if this task must be sent in order relative to all other tasks.
+         * @return true if this is a sequenced (session) request
+         */
+        bool isSequenced() const { return _sequenced; }
+
+        /**
+         * @return the endpoint this task is sent to
+         */
+        Defines::APIEndpoint getAPIEndpoint() const;
+
+        /**
+         * @return the durable event queue ids of the events sent by this task
+         */
+        const std::vector<uint64_t>& getRecordIds() const { return _recordIds; }
+
      private:
+        void package(JSONObject& payload);
+
+        /**
+         * Remove the expired events from the batch and acknowledge them in
+         * the durable event queue.
+         * @return true if any event was removed
+         */
+        bool removeExpiredEvents();
+
         RequestManager& _manager;
         Request _request;
-        BaseEvent _event;
+        // Empty for a batch
+        std::optional<BaseEvent> _event;
+        std::shared_ptr<EventBatch> _batch;
         IRequestCallback* _callback;
+        bool const _sequenced;
+        std::vector<uint64_t> _recordIds;
+        JSONObject _payload;
+        bool _packaged;
     };
 
+    /// Pool of RequestTasks
+    typedef ObjectPool<RequestTask> TaskPool;
+
     /**
-    * Inserts a RequestTask at the back of the queue and notifies about it.
+     * Queue an event for sending.
+     * @param event Event to send. Moved into the request.
+     * @param callback Interface for success and failure response.
+     * @param urgent if true, the request is inserted at the front of the queue
+     * @param recordId id of the event in the durable event queue, or 0
+     */
+    void enqueueEvent(BaseEvent&& event, IRequestCallback* callback, bool urgent, uint64_t recordId);
+
+    /**
+     * Queue the events left in the event queue file by a previous run.
+     */
+    void enqueuePersistedEvents();
+
+    /**
+     * Determine whether requests to an endpoint are kept in the durable
+     * event queue until they have been sent.
+     * @param endpoint the API endpoint
+     * @return true if requests to this endpoint are persisted
+     */
+    static bool isPersistent(Defines::APIEndpoint endpoint);
+
+    /**
+    * Inserts a RequestTask at the back of its priority lane and notifies about it.
     * @param task RequestTask to be added.
     */
     void enqueueTask(RequestTask* task);
     
     /**
-    * Inserts a RequestTask in the front of the queue and notifies about it.
+    * Inserts a RequestTask at the back of the urgent lane and notifies about it.
     * @param task RequestTask to be added.
     */
     void enqueueUrgentTask(RequestTask* task);
+
+    /**
+     * Move tasks from the MPSC queues into the priority lanes. Must be called
+     * with _mutex locked.
+     */
+    void drainLanes();
+
+    /**
+     * Add an event to the pending batch, creating one if necessary. Queues
+     * the batch if it is now full.
+     * @param event Event to send. Moved into the batch.
+     * @param callback Interface for success and failure response.
+     * @param recordId id of the event in the durable event queue, or 0
+     */
+    void enqueueBatchedEvent(BaseEvent&& event, IRequestCallback* callback, uint64_t recordId);
+
+    /**
+     * Queue the pending batch, if any, at the back of its priority lane.
+     * Must be called with _mutex locked.
+     */
+    void flushPendingBatch();
+
+    /**
+     * Insert a non-urgent task at the back of its priority lane, or hold it
+     * back if a sequenced task is queued. Must be called with _mutex locked.
+     * @param task RequestTask to be added.
+     */
+    void pushTask(RequestTask* task);
+
+    /**
+     * Move the held tasks, up to and including the next sequenced task,
+     * into the priority lanes. Called when a sequenced task is dequeued.
+     * Must be called with _mutex locked.
+     */
+    void releaseHeldTasks();
     
     /**
-     * Pops and returns a RequestTask in the front of the queue. 
+     * Pops and returns the next RequestTask from the priority lanes, or a
+     * task due to be retried.
      * If queue is empty, it waits until any RequestTask in enqueued.
+     * If the task at the front of the queue cannot be sent yet because of
+     * a sequenced request, waits until it can.
+     * The returned task is tracked as active until finishTask() is called.
      * @return task RequestTask in the front of the queue.
      */
     RequestTask* waitDequeueNotification();
 
+    /**
+     * Called by a worker thread after a task failed. Keeps the task active
+     * and runs it again after a delay.
+     * @param task the RequestTask to retry
+     * @param delayMillis time until the retry in ms
+     */
+    void scheduleRetry(RequestTask* task, int32_t delayMillis);
+
+    /**
+     * Called by a worker thread after a task has run. Removes it from the
+     * active tasks, wakes up any threads waiting on a sequenced request and
+     * returns the task to the pool.
+     * @param task the RequestTask that completed
+     */
+    void finishTask(RequestTask* task);
+
+    /**
+     * Return every task still held by the manager to the pool. Called by the
+     * destructor once the worker threads have terminated.
+     */
+    void releaseTasks();
+
+    /**
+     * Determine whether requests to an endpoint change session state and must
+     * be sent in order relative to all other requests.
+     * @param endpoint the API endpoint
+     * @return true if requests to this endpoint are sequenced
+     */
+    static bool isSequenced(Defines::APIEndpoint endpoint);
+
     /**
      * Wakes up all threads that wait for a task.
      */
     void wakeUpAll();
 
     /**
-     * Synchronized getter for _clientSession. Will usually only
-     * be non-NULL in unit tests.
+     * Lock-free getter for _clientSession. Will be NULL until the first
+     * request is sent unless a session was passed to the constructor.
      * @return pointer to an IClientSession or NULL
      */
     IClientSession *getClientSession() const {
-        std::scoped_lock _l(_mutex);
-        return _clientSession;
+        return _clientSession.load();
     }
 
     /**
-     * Synchronized setter for _clientSession. Called from the
+     * Get the client session used to send requests. Returns the session passed
+     * to the constructor, if any. Otherwise the first call creates a long-lived
+     * session for the configured HTTP backend, owned by this RequestManager,
+     * which is reused by all workers so that connections are kept alive
+     * between requests.
+     * @return pointer to an IClientSession or NULL if one could not be created
+     */
+    IClientSession *acquireClientSession();
+
+    /**
+     * Lock-free setter for _clientSession. Called from the
      * constructor in unit tests.
      * @param clientSession pointer to an IClientSession to use
      */
     void setClientSession(IClientSession *clientSession) {
-        std::scoped_lock _l(_mutex);
-        _clientSession = clientSession;
+        _clientSession.store(clientSession);
     }
 
     /// Allow RequestTask to call protected and private methods
     friend struct RequestTask;
 
-    /**
-     * Gets a pointer to the current outstanding Request, if any
-     * @return the current Request or NULL if none
-     */
-    Request* getCurrentRequest() const {
-        std::scoped_lock _l(_mutex);
-        return _currentRequest;
-    }
-
-    /**
-     * Sets the current request.
-     * @param request the current Request or NULL
-     * @return *this
-     */
-    RequestManager& setCurrentRequest(Request* request) {
-        std::scoped_lock _l(_mutex);
-        _currentRequest = request;
-        return *this;
-    }
-
     /**
      * Packaging info getter
      * @return the IPackagingInfo
@@ -215,15 +461,33 @@ class BRANCHIO_DLL_EXPORT RequestManager {
     IPackagingInfo& getPackagingInfo() { return *_packagingInfo; }
 
  private:
-    std::deque<RequestTask *>  _queue;
+    // Declared first so that it outlives every task
+    TaskPool _taskPool;
+    WeightedFairQueue<RequestTask *> _queue;
+    // Tasks queued after a sequenced task still in _queue, in order
+    std::deque<RequestTask *> _heldTasks;
+    // Number of sequenced tasks in _queue, at most 1
+    int _queuedSequencedCount;
+    std::vector<RequestTask *> _activeTasks;
+    // Active tasks waiting to be retried, and those due
+    TimerWheel<RequestTask *> _retryTimers;
+    std::deque<RequestTask *> _dueRetries;
+    int _activeSequencedCount;
     mutable std::mutex _mutex;
-    std::condition_variable mutable _available;
-    std::thread _thread;
-    IRequestCallback* volatile _defaultCallback;
+    // Signaled when a worker may have something to do
+    EventCount _available;
+    MPSCQueue<RequestTask> _urgentLane;
+    MPSCQueue<RequestTask> _normalLane;
+    std::vector<std::thread> _threads;
+    Configuration const _configuration;
+    std::atomic<IRequestCallback*> _defaultCallback;
     IPackagingInfo* volatile _packagingInfo;
-    IClientSession* volatile _clientSession;
-    bool volatile _shuttingDown;
-    Request* volatile _currentRequest;
+    std::atomic<IClientSession*> _clientSession;
+    std::unique_ptr<IClientSession> _ownedClientSession;
+    std::shared_ptr<EventBatch> _pendingBatch;
+    std::unique_ptr<DurableQueue> _durableQueue;
+    std::vector<DurableQueue::Record> _persistedRecords;
+    std::atomic<bool> _shuttingDown;
 };
 
 }  // namespace BranchIO
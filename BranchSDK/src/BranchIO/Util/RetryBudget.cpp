@@ -0,0 +1,68 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "BranchIO/Util/RetryBudget.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace BranchIO {
+
+const unsigned int RetryBudget::DefaultCapacity = 10;
+const int32_t RetryBudget::DefaultRefillMillis = 2000;
+
+RetryBudget&
+RetryBudget::instance() {
+    static RetryBudget _instance;
+    return _instance;
+}
+
+RetryBudget::RetryBudget(unsigned int capacity, int32_t refillMillis) :
+    _capacity(max(1u, capacity)),
+    _refillInterval(chrono::milliseconds(max<int32_t>(1, refillMillis))),
+    _tokens(_capacity),
+    _lastRefill(Clock::now()) {
+}
+
+int32_t
+RetryBudget::acquire() {
+    scoped_lock _l(_mutex);
+    Clock::time_point now = Clock::now();
+    refillLocked(now);
+
+    if (_tokens > 0) {
+        -- _tokens;
+        return 0;
+    }
+
+    auto remaining = chrono::duration_cast<chrono::milliseconds>(_lastRefill + _refillInterval - now).count();
+    return max<int32_t>(1, static_cast<int32_t>(remaining));
+}
+
+unsigned int
+RetryBudget::getTokenCount() const {
+    scoped_lock _l(_mutex);
+    refillLocked(Clock::now());
+    return _tokens;
+}
+
+void
+RetryBudget::refillLocked(Clock::time_point now) const {
+    if (_tokens >= _capacity) {
+        _lastRefill = now;
+        return;
+    }
+
+    auto added = (now - _lastRefill) / _refillInterval;
+    if (added <= 0) return;
+
+    if (static_cast<unsigned int>(added) >= _capacity - _tokens) {
+        _tokens = _capacity;
+        _lastRefill = now;
+    } else {
+        _tokens += static_cast<unsigned int>(added);
+        _lastRefill += added * _refillInterval;
+    }
+}
+
+}  // namespace BranchIO
@@ -0,0 +1,72 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_RETRYBUDGET_H__
+#define BRANCHIO_UTIL_RETRYBUDGET_H__
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Token bucket limiting how often failed requests are retried,
+ * across all requests.
+ *
+ * Each retry takes a token. Tokens are added at a fixed rate, up to a
+ * maximum, so a burst of retries is allowed but the sustained retry rate
+ * is bounded no matter how many requests are failing.
+ */
+class RetryBudget {
+ public:
+    /// Clock used for refilling
+    typedef std::chrono::steady_clock Clock;
+
+    /// Default maximum number of tokens
+    static const unsigned int DefaultCapacity;
+
+    /// Default time to add one token, in ms
+    static const int32_t DefaultRefillMillis;
+
+    /**
+     * @return the budget shared by all requests
+     */
+    static RetryBudget& instance();
+
+    /**
+     * Constructor. The bucket starts full.
+     * @param capacity maximum number of tokens
+     * @param refillMillis time to add one token, in ms
+     */
+    explicit RetryBudget(
+        unsigned int capacity = DefaultCapacity,
+        int32_t refillMillis = DefaultRefillMillis);
+
+    /**
+     * Take a token for a retry.
+     * @return 0 if a token was taken, otherwise the time until one is
+     *         available, in ms
+     */
+    int32_t acquire();
+
+    /**
+     * @return the number of tokens available now
+     */
+    unsigned int getTokenCount() const;
+
+ private:
+    RetryBudget(const RetryBudget& o);
+    RetryBudget& operator=(const RetryBudget& o);
+
+    void refillLocked(Clock::time_point now) const;
+
+    mutable std::mutex _mutex;
+    const unsigned int _capacity;
+    const Clock::duration _refillInterval;
+    mutable unsigned int _tokens;
+    mutable Clock::time_point _lastRefill;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_RETRYBUDGET_H__
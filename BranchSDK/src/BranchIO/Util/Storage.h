@@ -3,11 +3,11 @@
 #ifndef BRANCHIO_UTIL_STORAGE_H__
 #define BRANCHIO_UTIL_STORAGE_H__
 
-#include "WindowsStorage.h"
+#include "CachingStorage.h"
 
 namespace BranchIO {
 
-typedef WindowsStorage Storage;
+typedef CachingStorage Storage;
 
 }  // namespace BranchIO
 
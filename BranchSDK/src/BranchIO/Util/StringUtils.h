@@ -3,13 +3,14 @@
 #ifndef BRANCHIO_UTIL_STRINGUTILS_H__
 #define BRANCHIO_UTIL_STRINGUTILS_H__
 
-#include <codecvt>
 #include <string>
 #include <Windows.Foundation.h>
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Security.Cryptography.h>
 #include <winrt/Windows.Storage.Streams.h>
 
+#include "UTF.h"
+
 namespace BranchIO {
 
 /**
@@ -54,8 +55,9 @@ class StringUtils {
     * @return wstring - converted string if not empty. If empty or error occurs it returns ""
     */
     static std::wstring utf8_to_wstring(const std::string& string) {
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
-        return myconv.from_bytes(string);
+        std::wstring wide_string;
+        UTF::fromUTF8(string, wide_string);
+        return wide_string;
     }
 
     /**
@@ -64,8 +66,9 @@ class StringUtils {
     * @return string - converted string if not empty. If empty or error occurs it returns ""
     */
     static std::string wstring_to_utf8(const std::wstring& wide_string) {
-        std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
-        return myconv.to_bytes(wide_string);
+        std::string string;
+        UTF::toUTF8(wide_string, string);
+        return string;
     }
 
     /**
@@ -0,0 +1,212 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_TIMERWHEEL_H__
+#define BRANCHIO_UTIL_TIMERWHEEL_H__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Hierarchical timer wheel holding values until their deadline.
+ *
+ * Time is divided into ticks. The first level has a slot for each of the
+ * next 64 ticks, the second level a slot for each of the next 64 groups of
+ * 64 ticks, and so on. Scheduling a timer and firing it take constant
+ * time, however many timers are pending. Entries in higher levels move
+ * down a level each time the level below wraps around.
+ *
+ * The wheel has no thread of its own and is not thread-safe. The owner
+ * calls advance() with the current time, and can use getNextDeadline() to
+ * decide how long to wait.
+ *
+ * @tparam T type of the values held
+ */
+template <typename T>
+class TimerWheel {
+ public:
+    /// Clock for deadlines
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * Constructor.
+     * @param tick resolution of the wheel. Timers fire up to one tick late.
+     * @param start time of tick 0
+     */
+    explicit TimerWheel(
+        Clock::duration tick = std::chrono::milliseconds(10),
+        Clock::time_point start = Clock::now()) :
+        _tick(tick),
+        _start(start),
+        _currentTick(0),
+        _size(0),
+        _levels(Levels, std::vector<Slot>(SlotCount)) {
+    }
+
+    /**
+     * Add a timer. Deadlines more than about 46 hours out, at the default
+     * tick, fire at the end of the wheel's range instead.
+     * @param deadline when the timer fires
+     * @param value value passed to advance()'s function when it fires
+     */
+    void schedule(Clock::time_point deadline, T value) {
+        uint64_t expiry = toTick(deadline, true);
+        if (expiry <= _currentTick) expiry = _currentTick + 1;
+        if (expiry - _currentTick >= MaxTicks) expiry = _currentTick + MaxTicks - 1;
+
+        insert(Entry{ expiry, std::move(value) });
+        ++ _size;
+    }
+
+    /**
+     * Fire all timers due by a time.
+     * @param now the current time
+     * @param fire called with the value of each timer that fires, in
+     *        deadline order
+     * @return the number of timers fired
+     */
+    template <typename Function>
+    size_t advance(Clock::time_point now, Function fire) {
+        uint64_t target = toTick(now, false);
+        size_t fired = 0;
+
+        while (_currentTick < target) {
+            if (_size == 0) {
+                _currentTick = target;
+                break;
+            }
+
+            ++ _currentTick;
+            cascade();
+
+            Slot& slot = _levels[0][_currentTick & SlotMask];
+            if (slot.empty()) continue;
+
+            Slot expired;
+            expired.swap(slot);
+            _size -= expired.size();
+            for (Entry& entry : expired) {
+                fire(std::move(entry.value));
+                ++ fired;
+            }
+        }
+
+        return fired;
+    }
+
+    /**
+     * Get the time by which advance() must next be called. This is the
+     * deadline of the next timer, or earlier when timers have to move
+     * down a level.
+     * @param deadline receives the time
+     * @return false if no timers are pending
+     */
+    bool getNextDeadline(Clock::time_point& deadline) const {
+        if (_size == 0) return false;
+
+        for (uint64_t tick = _currentTick + 1; tick <= _currentTick + SlotCount; ++ tick) {
+            if (!_levels[0][tick & SlotMask].empty() || ((tick & SlotMask) == 0 && hasHigherLevelEntries())) {
+                deadline = _start + _tick * tick;
+                return true;
+            }
+        }
+
+        // Not reached: level 0 covers the next SlotCount ticks.
+        deadline = _start + _tick * (_currentTick + SlotCount);
+        return true;
+    }
+
+    /**
+     * @return the number of pending timers
+     */
+    size_t size() const { return _size; }
+
+    /**
+     * @return true if no timers are pending
+     */
+    bool empty() const { return _size == 0; }
+
+    /**
+     * Drop all pending timers without firing them.
+     */
+    void clear() {
+        for (std::vector<Slot>& level : _levels) {
+            for (Slot& slot : level) {
+                Slot().swap(slot);
+            }
+        }
+        _size = 0;
+    }
+
+ private:
+    static const unsigned int SlotBits = 6;
+    static const uint64_t SlotCount = 1 << SlotBits;
+    static const uint64_t SlotMask = SlotCount - 1;
+    static const unsigned int Levels = 4;
+    static const uint64_t MaxTicks = uint64_t(1) << (SlotBits * Levels);
+
+    struct Entry {
+        uint64_t expiry;
+        T value;
+    };
+
+    typedef std::vector<Entry> Slot;
+
+    uint64_t toTick(Clock::time_point time, bool roundUp) const {
+        if (time <= _start) return 0;
+        Clock::duration elapsed = time - _start;
+        uint64_t ticks = static_cast<uint64_t>(elapsed / _tick);
+        if (roundUp && elapsed % _tick != Clock::duration::zero()) ++ ticks;
+        return ticks;
+    }
+
+    void insert(Entry&& entry) {
+        uint64_t delta = entry.expiry - _currentTick;
+        unsigned int level = 0;
+        while (level + 1 < Levels && delta >= (uint64_t(1) << (SlotBits * (level + 1)))) {
+            ++ level;
+        }
+
+        uint64_t index = (entry.expiry >> (SlotBits * level)) & SlotMask;
+        _levels[level][index].push_back(std::move(entry));
+    }
+
+    // Move entries down from each level whose slot has come up.
+    void cascade() {
+        for (unsigned int level = 1; level < Levels; ++ level) {
+            if ((_currentTick & ((uint64_t(1) << (SlotBits * level)) - 1)) != 0) break;
+
+            Slot& slot = _levels[level][(_currentTick >> (SlotBits * level)) & SlotMask];
+            if (slot.empty()) continue;
+
+            Slot entries;
+            entries.swap(slot);
+            for (Entry& entry : entries) {
+                insert(std::move(entry));
+            }
+        }
+    }
+
+    bool hasHigherLevelEntries() const {
+        for (unsigned int level = 1; level < Levels; ++ level) {
+            for (const Slot& slot : _levels[level]) {
+                if (!slot.empty()) return true;
+            }
+        }
+        return false;
+    }
+
+    const Clock::duration _tick;
+    const Clock::time_point _start;
+    uint64_t _currentTick;
+    size_t _size;
+    std::vector<std::vector<Slot>> _levels;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_TIMERWHEEL_H__
@@ -0,0 +1,263 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#include "UTF.h"
+
+#include <cstdint>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BRANCHIO_UTF_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace BranchIO {
+
+const size_t UTF::Invalid = static_cast<size_t>(-1);
+
+namespace {
+
+template <typename CharT>
+inline uint32_t
+unit(CharT c) {
+    return static_cast<uint32_t>(static_cast<typename std::make_unsigned<CharT>::type>(c));
+}
+
+/**
+ * Write one code point as UTF-16 or UTF-32.
+ * @return false if there is no room
+ */
+template <typename CharT>
+inline bool
+writeWide(uint32_t c, CharT*& out, CharT* end) {
+    if (sizeof(CharT) == 2 && c >= 0x10000) {
+        if (end - out < 2) return false;
+        c -= 0x10000;
+        *out++ = static_cast<CharT>(0xD800 + (c >> 10));
+        *out++ = static_cast<CharT>(0xDC00 + (c & 0x3FF));
+        return true;
+    }
+
+    if (out == end) return false;
+    *out++ = static_cast<CharT>(c);
+    return true;
+}
+
+/**
+ * Write one code point as UTF-8.
+ * @return false if there is no room
+ */
+inline bool
+writeUTF8(uint32_t c, char*& out, char* end) {
+    if (c < 0x80) {
+        if (out == end) return false;
+        *out++ = static_cast<char>(c);
+    } else if (c < 0x800) {
+        if (end - out < 2) return false;
+        *out++ = static_cast<char>(0xC0 | (c >> 6));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        if (end - out < 3) return false;
+        *out++ = static_cast<char>(0xE0 | (c >> 12));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        if (end - out < 4) return false;
+        *out++ = static_cast<char>(0xF0 | (c >> 18));
+        *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return true;
+}
+
+#ifdef BRANCHIO_UTF_SSE2
+
+/**
+ * Convert 16 ASCII bytes to wide characters, if they are all ASCII.
+ * @return false if any byte is not ASCII
+ */
+template <typename CharT>
+inline bool
+widenAscii(const char* in, CharT* out) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    if (_mm_movemask_epi8(bytes) != 0) return false;
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    __m128i* o = reinterpret_cast<__m128i*>(out);
+    if (sizeof(CharT) == 2) {
+        _mm_storeu_si128(o, low);
+        _mm_storeu_si128(o + 1, high);
+    } else {
+        _mm_storeu_si128(o, _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128(o + 1, _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128(o + 2, _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(o + 3, _mm_unpackhi_epi16(high, zero));
+    }
+    return true;
+}
+
+/**
+ * Convert 16 wide characters to ASCII bytes, if they are all ASCII.
+ * @return false if any character is not ASCII
+ */
+template <typename CharT>
+inline bool
+narrowAscii(const CharT* in, char* out) {
+    const __m128i* i = reinterpret_cast<const __m128i*>(in);
+    __m128i zero = _mm_setzero_si128();
+    __m128i packed;
+    if (sizeof(CharT) == 2) {
+        __m128i a = _mm_loadu_si128(i);
+        __m128i b = _mm_loadu_si128(i + 1);
+        __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF) return false;
+        packed = _mm_packus_epi16(a, b);
+    } else {
+        __m128i a = _mm_loadu_si128(i);
+        __m128i b = _mm_loadu_si128(i + 1);
+        __m128i c = _mm_loadu_si128(i + 2);
+        __m128i d = _mm_loadu_si128(i + 3);
+        __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        __m128i high = _mm_and_si128(all, _mm_set1_epi32(~0x7F));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) != 0xFFFF) return false;
+        packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+    return true;
+}
+
+#endif  // BRANCHIO_UTF_SSE2
+
+}  // namespace
+
+template <typename CharT>
+size_t
+UTF::fromUTF8(const char* in, size_t length, CharT* out, size_t capacity) {
+    const char* p = in;
+    const char* end = in + length;
+    CharT* o = out;
+    CharT* outEnd = out + capacity;
+
+    while (p < end) {
+#ifdef BRANCHIO_UTF_SSE2
+        while (end - p >= 16 && outEnd - o >= 16 && widenAscii(p, o)) {
+            p += 16;
+            o += 16;
+        }
+        if (p == end) break;
+#endif  // BRANCHIO_UTF_SSE2
+
+        uint32_t c = static_cast<uint8_t>(*p);
+        if (c < 0x80) {
+            if (o == outEnd) return Invalid;
+            *o++ = static_cast<CharT>(c);
+            ++ p;
+            continue;
+        }
+
+        size_t trailing;
+        uint32_t minimum;
+        if ((c & 0xE0) == 0xC0) {
+            trailing = 1;
+            c &= 0x1F;
+            minimum = 0x80;
+        } else if ((c & 0xF0) == 0xE0) {
+            trailing = 2;
+            c &= 0x0F;
+            minimum = 0x800;
+        } else if ((c & 0xF8) == 0xF0) {
+            trailing = 3;
+            c &= 0x07;
+            minimum = 0x10000;
+        } else {
+            return Invalid;
+        }
+
+        if (static_cast<size_t>(end - p) <= trailing) return Invalid;
+        for (size_t j = 1; j <= trailing; ++j) {
+            uint8_t b = static_cast<uint8_t>(p[j]);
+            if ((b & 0xC0) != 0x80) return Invalid;
+            c = (c << 6) | (b & 0x3F);
+        }
+        // Overlong forms, surrogates and values past the last code point
+        if (c < minimum || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) return Invalid;
+
+        if (!writeWide(c, o, outEnd)) return Invalid;
+        p += trailing + 1;
+    }
+
+    return o - out;
+}
+
+template <typename CharT>
+size_t
+UTF::toUTF8(const CharT* in, size_t length, char* out, size_t capacity) {
+    const CharT* i = in;
+    const CharT* end = in + length;
+    char* o = out;
+    char* outEnd = out + capacity;
+
+    while (i < end) {
+#ifdef BRANCHIO_UTF_SSE2
+        while (end - i >= 16 && outEnd - o >= 16 && narrowAscii(i, o)) {
+            i += 16;
+            o += 16;
+        }
+        if (i == end) break;
+#endif  // BRANCHIO_UTF_SSE2
+
+        uint32_t c = unit(*i++);
+        if (sizeof(CharT) == 2 && c >= 0xD800 && c <= 0xDFFF) {
+            // A high surrogate must be followed by a low one.
+            if (c >= 0xDC00 || i == end) return Invalid;
+            uint32_t low = unit(*i);
+            if (low < 0xDC00 || low > 0xDFFF) return Invalid;
+            ++ i;
+            c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+        } else if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+            return Invalid;
+        }
+
+        if (!writeUTF8(c, o, outEnd)) return Invalid;
+    }
+
+    return o - out;
+}
+
+bool
+UTF::fromUTF8(const std::string& in, std::wstring& out) {
+    // No more characters than bytes
+    out.resize(in.size());
+    size_t length = fromUTF8(in.data(), in.size(), &out[0], out.size());
+    if (length == Invalid) {
+        out.clear();
+        return false;
+    }
+
+    out.resize(length);
+    return true;
+}
+
+bool
+UTF::toUTF8(const std::wstring& in, std::string& out) {
+    out.resize(maxUTF8Length<wchar_t>(in.size()));
+    size_t length = toUTF8(in.data(), in.size(), &out[0], out.size());
+    if (length == Invalid) {
+        out.clear();
+        return false;
+    }
+
+    out.resize(length);
+    return true;
+}
+
+template size_t UTF::fromUTF8<wchar_t>(const char*, size_t, wchar_t*, size_t);
+template size_t UTF::fromUTF8<char16_t>(const char*, size_t, char16_t*, size_t);
+template size_t UTF::fromUTF8<char32_t>(const char*, size_t, char32_t*, size_t);
+template size_t UTF::toUTF8<wchar_t>(const wchar_t*, size_t, char*, size_t);
+template size_t UTF::toUTF8<char16_t>(const char16_t*, size_t, char*, size_t);
+template size_t UTF::toUTF8<char32_t>(const char32_t*, size_t, char*, size_t);
+
+}  // namespace BranchIO
@@ -0,0 +1,92 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_UTF_H__
+#define BRANCHIO_UTIL_UTF_H__
+
+#include <cstddef>
+#include <string>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Validating conversion between UTF-8 and wide strings.
+   ```
+   std::wstring wide;
+   if (!UTF::fromUTF8(utf8, wide)) {
+       // not valid UTF-8
+   }
+
+   // or into a buffer, without allocating:
+   size_t length = UTF::fromUTF8(data, size, buffer, capacity);
+   ```
+ *
+ * Wide strings are UTF-16 when the character type has 2 bytes (wchar_t on
+ * Windows, char16_t) and UTF-32 when it has 4 (wchar_t elsewhere,
+ * char32_t). Runs of ASCII, which make up most JSON, keys and log
+ * messages, are converted 16 characters at a time with SSE2 where it is
+ * available. Overlong forms, surrogates and code points above U+10FFFF are
+ * rejected.
+ */
+class UTF {
+ public:
+    /// Returned by the buffer conversions on failure
+    static const size_t Invalid;
+
+    /**
+     * Convert UTF-8 to UTF-16 or UTF-32. The output never has more
+     * characters than the input has bytes.
+     * @tparam CharT wchar_t, char16_t or char32_t
+     * @param in UTF-8 input
+     * @param length number of bytes of input
+     * @param out output buffer
+     * @param capacity number of characters out can hold
+     * @return the number of characters written, or Invalid if the input is
+     *         not valid UTF-8 or out is too small
+     */
+    template <typename CharT>
+    static size_t fromUTF8(const char* in, size_t length, CharT* out, size_t capacity);
+
+    /**
+     * Convert UTF-16 or UTF-32 to UTF-8. The output never has more than
+     * maxUTF8Length(length) bytes.
+     * @tparam CharT wchar_t, char16_t or char32_t
+     * @param in wide input
+     * @param length number of characters of input
+     * @param out output buffer
+     * @param capacity number of bytes out can hold
+     * @return the number of bytes written, or Invalid if the input has
+     *         unpaired surrogates or invalid code points, or out is too small
+     */
+    template <typename CharT>
+    static size_t toUTF8(const CharT* in, size_t length, char* out, size_t capacity);
+
+    /**
+     * @tparam CharT wchar_t, char16_t or char32_t
+     * @param length number of wide characters
+     * @return the largest number of bytes their UTF-8 form can take
+     */
+    template <typename CharT>
+    static size_t maxUTF8Length(size_t length) {
+        return length * (sizeof(CharT) == 2 ? 3 : 4);
+    }
+
+    /**
+     * Convert a UTF-8 string. out's capacity is reused.
+     * @param in UTF-8 input
+     * @param out receives the wide string, or an empty string on failure
+     * @return true on success, false if the input is not valid UTF-8
+     */
+    static bool fromUTF8(const std::string& in, std::wstring& out);
+
+    /**
+     * Convert a wide string. out's capacity is reused.
+     * @param in wide input
+     * @param out receives the UTF-8 string, or an empty string on failure
+     * @return true on success, false if the input is not valid
+     */
+    static bool toUTF8(const std::wstring& in, std::string& out);
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_UTF_H__
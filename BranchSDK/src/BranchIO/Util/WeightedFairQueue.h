@@ -0,0 +1,163 @@
+// Copyright (c) 2019-21 Branch Metrics, Inc.
+
+#ifndef BRANCHIO_UTIL_WEIGHTEDFAIRQUEUE_H__
+#define BRANCHIO_UTIL_WEIGHTEDFAIRQUEUE_H__
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace BranchIO {
+
+/**
+ * (Internal) Queue with several FIFO lanes served in proportion to their
+ * weights (stride scheduling).
+ *
+ * Each lane has a pass value, which advances by the inverse of its weight
+ * each time the lane is served. The next value comes from the non-empty
+ * lane with the lowest pass, so a lane with weight 4 is served four times
+ * as often as a lane with weight 1 while both have values waiting, and no
+ * lane with a non-zero weight is starved. A lane that was empty does not
+ * build up credit: it resumes at the pass of the lane served last.
+ *
+ * A lane with weight 0 has strict priority. It is always served before the
+ * weighted lanes, and before higher-numbered strict lanes.
+ *
+ * Not thread-safe.
+ *
+ * @tparam T type of the values held
+ */
+template <typename T>
+class WeightedFairQueue {
+ public:
+    /**
+     * Constructor.
+     * @param weights weight of each lane, by lane number. 0 for strict
+     *        priority. The default is a single lane, i.e. a plain FIFO.
+     */
+    explicit WeightedFairQueue(const std::vector<unsigned int>& weights = std::vector<unsigned int>(1, 1)) :
+        _lanes(weights.size()),
+        _size(0),
+        _virtualPass(0) {
+        for (size_t j = 0; j < weights.size(); ++j) {
+            _lanes[j].stride = weights[j] ? StrideScale / weights[j] : 0;
+        }
+    }
+
+    /**
+     * Add a value at the back of a lane.
+     * @param lane lane number
+     * @param value the value
+     */
+    void push(size_t lane, T value) {
+        assert(lane < _lanes.size());
+        Lane& l = _lanes[lane];
+        if (l.values.empty()) l.pass = std::max(l.pass, _virtualPass);
+        l.values.push_back(std::move(value));
+        ++ _size;
+    }
+
+    /**
+     * @return the value pop() would remove. The queue must not be empty.
+     */
+    const T& front() const {
+        return _lanes[selectLane()].values.front();
+    }
+
+    /**
+     * Remove and return the next value. The queue must not be empty.
+     * @return the value
+     */
+    T pop() {
+        Lane& l = _lanes[selectLane()];
+        T value(std::move(l.values.front()));
+        l.values.pop_front();
+        -- _size;
+
+        if (l.stride) {
+            _virtualPass = l.pass;
+            l.pass += l.stride;
+        }
+        return value;
+    }
+
+    /**
+     * @return true if no lane holds a value
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /**
+     * @return the number of values in all lanes
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @param lane lane number
+     * @return the number of values in one lane
+     */
+    size_t size(size_t lane) const {
+        return _lanes[lane].values.size();
+    }
+
+    /**
+     * Call a function with every value, lane by lane.
+     * @param f function taking a value
+     */
+    template <typename F>
+    void forEach(F f) const {
+        for (const Lane& l : _lanes) {
+            for (const T& value : l.values) f(value);
+        }
+    }
+
+    /**
+     * Remove all values.
+     */
+    void clear() {
+        for (Lane& l : _lanes) {
+            l.values.clear();
+        }
+        _size = 0;
+    }
+
+ private:
+    // Stride of a lane with weight 1
+    static const uint64_t StrideScale = 1 << 20;
+
+    struct Lane {
+        Lane() : stride(0), pass(0) {}
+
+        std::deque<T> values;
+        uint64_t stride;
+        uint64_t pass;
+    };
+
+    size_t selectLane() const {
+        assert(_size > 0);
+        size_t selected = _lanes.size();
+        for (size_t j = 0; j < _lanes.size(); ++j) {
+            const Lane& l = _lanes[j];
+            if (l.values.empty()) continue;
+            if (l.stride == 0) return j;
+            if (selected == _lanes.size() || l.pass < _lanes[selected].pass) selected = j;
+        }
+        return selected;
+    }
+
+    std::vector<Lane> _lanes;
+    size_t _size;
+    // Pass of the lane served last
+    uint64_t _virtualPass;
+};
+
+}  // namespace BranchIO
+
+#endif  // BRANCHIO_UTIL_WEIGHTEDFAIRQUEUE_H__
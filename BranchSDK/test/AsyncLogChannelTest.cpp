@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <BranchIO/Util/AsyncLogChannel.h>
+
+using namespace std;
+using namespace BranchIO;
+
+namespace {
+
+class CollectingLogChannel : public LogChannel
+{
+public:
+    ~CollectingLogChannel() {}
+
+    void log(const string& message)
+    {
+        scoped_lock _l(mMutex);
+        mMessages.push_back(message);
+    }
+
+    void log(const vector<string>& messages)
+    {
+        scoped_lock _l(mMutex);
+        mMessages.insert(mMessages.end(), messages.begin(), messages.end());
+        ++ mBatchCount;
+    }
+
+    vector<string> mMessages;
+    int mBatchCount = 0;
+    mutex mMutex;
+};
+
+}  // namespace
+
+TEST(AsyncLogChannelTest, TestAllMessagesWritten)
+{
+    CollectingLogChannel target;
+    const int threadCount = 4;
+    const int messageCount = 1000;
+
+    {
+        AsyncLogChannel channel(&target, 64, AsyncLogChannel::BlockWhenFull);
+        ASSERT_TRUE(channel.open());
+
+        vector<thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&channel, t, messageCount] {
+                for (int j = 0; j < messageCount; ++j) {
+                    channel.log(to_string(t) + ":" + to_string(j));
+                }
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+
+        channel.close();
+        ASSERT_EQ(0u, channel.getDroppedCount());
+    }
+
+    ASSERT_EQ(static_cast<size_t>(threadCount * messageCount), target.mMessages.size());
+
+    // Each thread's messages stay in order.
+    vector<int> next(threadCount, 0);
+    for (const string& message : target.mMessages) {
+        size_t colon = message.find(':');
+        int t = stoi(message.substr(0, colon));
+        ASSERT_EQ(next[t], stoi(message.substr(colon + 1)));
+        ++ next[t];
+    }
+}
+
+TEST(AsyncLogChannelTest, TestDropWhenFull)
+{
+    CollectingLogChannel target;
+    AsyncLogChannel channel(&target, 4, AsyncLogChannel::DropWhenFull);
+
+    // Before open(), messages are written synchronously.
+    channel.log("sync");
+    ASSERT_EQ(1u, target.mMessages.size());
+
+    ASSERT_TRUE(channel.open());
+    for (int j = 0; j < 10000; ++j) {
+        channel.log("message");
+    }
+    channel.close();
+
+    // Every message is either written or counted in a drop report.
+    const string prefix("AsyncLogChannel: ");
+    uint64_t written = 0;
+    uint64_t reported = 0;
+    for (size_t j = 1; j < target.mMessages.size(); ++j) {
+        const string& message = target.mMessages[j];
+        if (message.compare(0, prefix.size(), prefix) == 0) {
+            reported += stoull(message.substr(prefix.size()));
+        } else {
+            ++ written;
+        }
+    }
+    ASSERT_EQ(channel.getDroppedCount(), reported);
+    ASSERT_EQ(10000u, written + reported);
+}
+
+TEST(AsyncLogChannelTest, TestLogDuringClose)
+{
+    for (int run = 0; run < 20; ++run) {
+        CollectingLogChannel target;
+        const int threadCount = 4;
+        const int messageCount = 2000;
+
+        {
+            AsyncLogChannel channel(&target, 64, AsyncLogChannel::BlockWhenFull);
+            ASSERT_TRUE(channel.open());
+
+            vector<thread> threads;
+            for (int t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&channel, messageCount] {
+                    for (int j = 0; j < messageCount; ++j) {
+                        channel.log("message");
+                    }
+                });
+            }
+
+            // Messages logged while closing are either queued and written
+            // out by close() or written synchronously.
+            this_thread::yield();
+            channel.close();
+            for (thread& t : threads) {
+                t.join();
+            }
+        }
+
+        ASSERT_EQ(static_cast<size_t>(threadCount * messageCount), target.mMessages.size());
+    }
+}
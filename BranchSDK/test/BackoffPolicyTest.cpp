@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <set>
+
+#include <BranchIO/Util/BackoffPolicy.h>
+
+using namespace std;
+using namespace BranchIO;
+
+TEST(BackoffPolicyTest, TestExponential)
+{
+    ExponentialBackoff policy(8000, 120000);
+
+    ASSERT_EQ(8000, policy.getBackoffMillis(1, 0));
+    ASSERT_EQ(16000, policy.getBackoffMillis(2, 8000));
+    ASSERT_EQ(32000, policy.getBackoffMillis(3, 16000));
+    ASSERT_EQ(64000, policy.getBackoffMillis(4, 32000));
+    ASSERT_EQ(120000, policy.getBackoffMillis(5, 64000));
+    ASSERT_EQ(120000, policy.getBackoffMillis(50, 120000));
+}
+
+TEST(BackoffPolicyTest, TestFullJitter)
+{
+    FullJitterBackoff policy(8000, 120000);
+
+    set<int32_t> values;
+    for (int j = 0; j < 100; ++j) {
+        int32_t backoff = policy.getBackoffMillis(3, 0);
+        ASSERT_GE(backoff, 0);
+        ASSERT_LE(backoff, 32000);
+        values.insert(backoff);
+    }
+
+    // Not all the same
+    ASSERT_GT(values.size(), 1);
+}
+
+TEST(BackoffPolicyTest, TestDecorrelatedJitter)
+{
+    DecorrelatedJitterBackoff policy(8000, 120000);
+
+    set<int32_t> values;
+    int32_t previous = 0;
+    for (int attempt = 1; attempt < 100; ++attempt) {
+        int32_t backoff = policy.getBackoffMillis(attempt, previous);
+        ASSERT_GE(backoff, 8000);
+        ASSERT_LE(backoff, 120000);
+        ASSERT_LE(backoff, max(8000, previous) * 3);
+        values.insert(backoff);
+        previous = backoff;
+    }
+
+    ASSERT_GT(values.size(), 1);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+
+#include <BranchIO/Util/CachingStorage.h>
+
+using namespace std;
+using namespace BranchIO;
+
+namespace {
+
+/**
+ * In-memory storage that counts reads.
+ */
+class CountingStorage : public virtual IStorage
+{
+public:
+    Scope getDefaultScope() const { return mScope; }
+    IStorage& setDefaultScope(Scope scope) { mScope = scope; return *this; }
+    string getPrefix() const { return mPrefix; }
+    IStorage& setPrefix(const string& prefix) { mPrefix = prefix; return *this; }
+
+    bool has(const string& key, Scope scope = Default) const {
+        ++ mReads;
+        string k(path(key));
+        for (const auto& entry : mStrings) {
+            if (entry.first == k || entry.first.compare(0, k.size() + 1, k + ".") == 0) return true;
+        }
+        return mBooleans.count(k) > 0;
+    }
+
+    string getString(const string& key, const string& defaultValue = "", Scope scope = Default) const {
+        ++ mReads;
+        auto it = mStrings.find(path(key));
+        return it == mStrings.end() ? defaultValue : it->second;
+    }
+
+    IStorage& setString(const string& key, const string& value, Scope scope = Default) {
+        mStrings[path(key)] = value;
+        return *this;
+    }
+
+    bool getBoolean(const string& key, bool defaultValue = false, Scope scope = Default) const {
+        ++ mReads;
+        auto it = mBooleans.find(path(key));
+        return it == mBooleans.end() ? defaultValue : it->second;
+    }
+
+    IStorage& setBoolean(const string& key, bool value, Scope scope = Default) {
+        mBooleans[path(key)] = value;
+        return *this;
+    }
+
+    bool remove(const string& key, Scope scope = Default) {
+        return (mStrings.erase(path(key)) + mBooleans.erase(path(key))) > 0;
+    }
+
+    IStorage& clear(Scope scope = Default) {
+        mStrings.clear();
+        mBooleans.clear();
+        return *this;
+    }
+
+    string path(const string& key) const { return mPrefix + "/" + key; }
+
+    Scope mScope = User;
+    string mPrefix;
+    map<string, string> mStrings;
+    map<string, bool> mBooleans;
+    mutable int mReads = 0;
+};
+
+}  // namespace
+
+TEST(CachingStorageTest, TestReadsAreCached)
+{
+    CountingStorage backing;
+    backing.setString("session.identity", "id");
+    CachingStorage storage(backing);
+
+    ASSERT_EQ("id", storage.getString("session.identity"));
+    int reads = backing.mReads;
+    ASSERT_EQ("id", storage.getString("session.identity"));
+    ASSERT_EQ("id", storage.getString("session.identity"));
+    ASSERT_EQ(reads, backing.mReads);
+
+    // Missing keys are cached too, and still return the caller's default.
+    ASSERT_EQ("none", storage.getString("session.missing", "none"));
+    reads = backing.mReads;
+    ASSERT_EQ("other", storage.getString("session.missing", "other"));
+    ASSERT_FALSE(storage.getBoolean("advertiser.trackingDisabled"));
+    ASSERT_TRUE(storage.getBoolean("advertiser.trackingDisabled", true));
+    ASSERT_EQ(reads + 2, backing.mReads);
+}
+
+TEST(CachingStorageTest, TestWriteThrough)
+{
+    CountingStorage backing;
+    CachingStorage storage(backing);
+
+    ASSERT_FALSE(storage.has("session.identity"));
+    storage.setString("session.identity", "id");
+    ASSERT_EQ("id", backing.getString("session.identity"));
+    ASSERT_TRUE(storage.has("session.identity"));
+    ASSERT_TRUE(storage.has("session"));
+
+    storage.setBoolean("advertiser.trackingDisabled", true);
+    ASSERT_TRUE(backing.getBoolean("advertiser.trackingDisabled"));
+
+    int reads = backing.mReads;
+    ASSERT_EQ("id", storage.getString("session.identity"));
+    ASSERT_TRUE(storage.getBoolean("advertiser.trackingDisabled"));
+    ASSERT_EQ(reads, backing.mReads);
+
+    ASSERT_TRUE(storage.remove("session.identity"));
+    ASSERT_FALSE(storage.has("session.identity"));
+    ASSERT_EQ("", storage.getString("session.identity"));
+}
+
+TEST(CachingStorageTest, TestInvalidate)
+{
+    CountingStorage backing;
+    CachingStorage storage(backing);
+
+    storage.setString("session.identity", "id");
+    backing.setString("session.identity", "changed");
+    ASSERT_EQ("id", storage.getString("session.identity"));
+
+    storage.invalidate("session");
+    ASSERT_EQ("changed", storage.getString("session.identity"));
+
+    // The prefix is part of the cache key.
+    storage.setPrefix("other");
+    ASSERT_EQ("", storage.getString("session.identity"));
+    storage.setPrefix("");
+    ASSERT_EQ("changed", storage.getString("session.identity"));
+
+    storage.clear();
+    ASSERT_EQ("", storage.getString("session.identity"));
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include <BranchIO/Util/CircuitBreaker.h>
+
+using namespace std;
+using namespace BranchIO;
+
+TEST(CircuitBreakerTest, TestOpensAfterConsecutiveFailures)
+{
+    CircuitBreaker breaker(3, 60000);
+
+    for (int j = 0; j < 2; ++j) {
+        ASSERT_EQ(0, breaker.acquire());
+        breaker.recordFailure();
+    }
+
+    // A success resets the count.
+    ASSERT_EQ(0, breaker.acquire());
+    breaker.recordSuccess();
+
+    for (int j = 0; j < 3; ++j) {
+        ASSERT_EQ(CircuitBreaker::Closed, breaker.getState());
+        ASSERT_EQ(0, breaker.acquire());
+        breaker.recordFailure();
+    }
+
+    ASSERT_EQ(CircuitBreaker::Open, breaker.getState());
+    int32_t wait = breaker.acquire();
+    ASSERT_GT(wait, 0);
+    ASSERT_LE(wait, 60000);
+}
+
+TEST(CircuitBreakerTest, TestHalfOpenProbe)
+{
+    CircuitBreaker breaker(1, 20);
+
+    ASSERT_EQ(0, breaker.acquire());
+    breaker.recordFailure();
+    ASSERT_GT(breaker.acquire(), 0);
+
+    this_thread::sleep_for(chrono::milliseconds(40));
+
+    // One probe at a time
+    ASSERT_EQ(0, breaker.acquire());
+    ASSERT_EQ(CircuitBreaker::HalfOpen, breaker.getState());
+    ASSERT_GT(breaker.acquire(), 0);
+
+    // A failed probe opens the breaker again.
+    breaker.recordFailure();
+    ASSERT_EQ(CircuitBreaker::Open, breaker.getState());
+
+    this_thread::sleep_for(chrono::milliseconds(40));
+
+    ASSERT_EQ(0, breaker.acquire());
+    breaker.recordSuccess();
+    ASSERT_EQ(CircuitBreaker::Closed, breaker.getState());
+    ASSERT_EQ(0, breaker.acquire());
+    ASSERT_EQ(0, breaker.acquire());
+}
+
+TEST(CircuitBreakerTest, TestReleaseProbe)
+{
+    CircuitBreaker breaker(1, 0);
+
+    ASSERT_EQ(0, breaker.acquire());
+    breaker.recordFailure();
+
+    ASSERT_EQ(0, breaker.acquire());
+    ASSERT_GT(breaker.acquire(), 0);
+
+    // An abandoned probe lets another request probe.
+    breaker.release();
+    ASSERT_EQ(CircuitBreaker::HalfOpen, breaker.getState());
+    ASSERT_EQ(0, breaker.acquire());
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <BranchIO/Defines.h>
+#include <BranchIO/JSONObject.h>
+#include <BranchIO/Util/CurlClientSession.h>
+#include <BranchIO/Util/IClientSession.h>
+
+#include "ResponseCounter.h"
+
+using namespace std;
+using namespace BranchIO;
+
+TEST(ClientSessionTest, TestResolveUrl)
+{
+    string apiUrl(string(BRANCH_IO_URL_BASE) + "v1/open");
+
+    // Full URLs built by Defines::stringify are moved to the session's base URL.
+    ASSERT_EQ(apiUrl, IClientSession::resolveUrl(BRANCH_IO_URL_BASE, apiUrl));
+    ASSERT_EQ("http://localhost:8080/v1/open", IClientSession::resolveUrl("http://localhost:8080", apiUrl));
+    ASSERT_EQ("http://localhost:8080/v1/open", IClientSession::resolveUrl("http://localhost:8080/", apiUrl));
+
+    // Relative paths
+    ASSERT_EQ("http://localhost:8080/v1/url", IClientSession::resolveUrl("http://localhost:8080/", "/v1/url"));
+    ASSERT_EQ("http://localhost:8080/v1/url", IClientSession::resolveUrl("http://localhost:8080", "v1/url"));
+
+    // Other servers are left alone.
+    ASSERT_EQ("https://example.com/a", IClientSession::resolveUrl("http://localhost:8080/", "https://example.com/a"));
+}
+
+#ifdef BRANCHIO_USE_CURL
+
+TEST(ClientSessionTest, TestCurlConnectionRefused)
+{
+    // Nothing listens on port 1.
+    CurlClientSession session("http://127.0.0.1:1/");
+    ResponseCounter callback;
+    JSONObject result;
+    RetryInfo retryInfo;
+
+    ASSERT_FALSE(session.post("v1/open", JSONObject(), callback, result, retryInfo));
+    ASSERT_EQ(0, callback.getResponseCount());
+    ASSERT_EQ(-1, retryInfo.retryAfterMillis);
+}
+
+TEST(ClientSessionTest, TestCurlStop)
+{
+    // Connecting to a non-routable address hangs until stopped.
+    CurlClientSession session("http://10.255.255.1/");
+    ResponseCounter callback;
+
+    thread stopper([&session]() {
+        this_thread::sleep_for(chrono::milliseconds(100));
+        session.stop();
+    });
+
+    JSONObject result;
+    auto start = chrono::steady_clock::now();
+    ASSERT_FALSE(session.post("v1/open", JSONObject(), callback, result));
+    ASSERT_LT(chrono::steady_clock::now() - start, chrono::seconds(5));
+    stopper.join();
+
+    ASSERT_TRUE(session.isShuttingDown());
+    ASSERT_FALSE(session.post("v1/open", JSONObject(), callback, result));
+}
+
+#endif  // BRANCHIO_USE_CURL
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <BranchIO/Util/CRC32.h>
+#include <BranchIO/Util/DurableQueue.h>
+
+using namespace std;
+using namespace BranchIO;
+
+class DurableQueueTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mPath = (filesystem::temp_directory_path() / L"branchio_durable_queue_test.dat").wstring();
+        filesystem::remove(mPath);
+    }
+
+    void TearDown() override
+    {
+        filesystem::remove(mPath);
+    }
+
+    wstring mPath;
+};
+
+TEST(CRC32Test, TestCheckValue)
+{
+    const char* data = "123456789";
+    ASSERT_EQ(0xCBF43926u, CRC32::compute(data, 9));
+
+    uint32_t crc = CRC32::update(CRC32::Initial, data, 4);
+    crc = CRC32::update(crc, data + 4, 5);
+    ASSERT_EQ(0xCBF43926u, crc);
+}
+
+TEST_F(DurableQueueTest, TestReplayPending)
+{
+    vector<DurableQueue::Record> pending;
+    {
+        DurableQueue queue(mPath);
+        ASSERT_TRUE(queue.open(pending));
+        ASSERT_TRUE(pending.empty());
+
+        uint64_t first = queue.append("first");
+        uint64_t second = queue.append("second");
+        uint64_t third = queue.append("third");
+        ASSERT_NE(0u, first);
+        ASSERT_NE(first, second);
+
+        queue.acknowledge(second);
+        ASSERT_NE(0u, third);
+    }
+
+    DurableQueue queue(mPath);
+    ASSERT_TRUE(queue.open(pending));
+    ASSERT_EQ(2u, pending.size());
+    ASSERT_EQ("first", pending[0].payload);
+    ASSERT_EQ("third", pending[1].payload);
+
+    // New ids never reuse old ones.
+    ASSERT_GT(queue.append("fourth"), pending[1].id);
+}
+
+TEST_F(DurableQueueTest, TestTornRecord)
+{
+    {
+        vector<DurableQueue::Record> pending;
+        DurableQueue queue(mPath);
+        ASSERT_TRUE(queue.open(pending));
+        queue.append("complete");
+    }
+
+    // Simulate a crash in the middle of writing a record.
+    {
+        ofstream file(filesystem::path(mPath), ios::binary | ios::app);
+        file.write("BRQ1\x01garbage", 12);
+    }
+
+    vector<DurableQueue::Record> pending;
+    {
+        DurableQueue queue(mPath);
+        ASSERT_TRUE(queue.open(pending));
+        ASSERT_EQ(1u, pending.size());
+        ASSERT_EQ("complete", pending[0].payload);
+
+        queue.append("after");
+    }
+
+    DurableQueue queue(mPath);
+    ASSERT_TRUE(queue.open(pending));
+    ASSERT_EQ(2u, pending.size());
+    ASSERT_EQ("after", pending[1].payload);
+}
+
+TEST_F(DurableQueueTest, TestCompaction)
+{
+    vector<DurableQueue::Record> pending;
+    DurableQueue queue(mPath);
+    ASSERT_TRUE(queue.open(pending));
+
+    uint64_t live = queue.append("live");
+    for (size_t i = 0; i < DurableQueue::CompactionThreshold + 1; ++i) {
+        queue.acknowledge(queue.append(string(100, 'x')));
+    }
+
+    // Only the live record is left after compaction.
+    uintmax_t size = filesystem::file_size(mPath);
+    ASSERT_LT(size, 100u * DurableQueue::CompactionThreshold);
+
+    ASSERT_TRUE(queue.compact());
+    ASSERT_TRUE(queue.open(pending));
+    ASSERT_EQ(1u, pending.size());
+    ASSERT_EQ(live, pending[0].id);
+}
+
+TEST_F(DurableQueueTest, TestSyncAfterInterval)
+{
+    // Flushed by count only after 100 records, or 50 ms after the first
+    DurableQueue queue(mPath, 100, 50);
+    vector<DurableQueue::Record> pending;
+    ASSERT_TRUE(queue.open(pending));
+
+    queue.append("one");
+    queue.append("two");
+    ASSERT_EQ(2u, queue.getUnsyncedCount());
+
+    // No further writes. The background thread flushes the tail.
+    for (int j = 0; j < 100 && queue.getUnsyncedCount() > 0; ++j) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    ASSERT_EQ(0u, queue.getUnsyncedCount());
+}
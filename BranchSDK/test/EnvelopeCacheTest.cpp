@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include <BranchIO/AppInfo.h>
+#include <BranchIO/JSONObject.h>
+#include <BranchIO/PackagingInfo.h>
+#include <BranchIO/Util/EnvelopeCache.h>
+
+#include "Util.h"
+
+using namespace std;
+using namespace BranchIO;
+
+class EnvelopeCacheTest : public ::testing::Test
+{
+};
+
+TEST_F(EnvelopeCacheTest, TestReuseUntilChanged)
+{
+    PackagingInfo packagingInfo(BranchIO::Test::getTestKey());
+    packagingInfo.getAppInfo().setAppVersion("1.0");
+
+    EnvelopeCache cache;
+    shared_ptr<const string> first = cache.getUserData(packagingInfo);
+    ASSERT_EQ(first, cache.getUserData(packagingInfo));
+    ASSERT_EQ("1.0", JSONObject::parse(*first).getNamedString("app_version"));
+
+    packagingInfo.getAppInfo().setAppVersion("2.0");
+    shared_ptr<const string> second = cache.getUserData(packagingInfo);
+    ASSERT_NE(first, second);
+    ASSERT_EQ("2.0", JSONObject::parse(*second).getNamedString("app_version"));
+}
+
+TEST_F(EnvelopeCacheTest, TestAdTrackingLimited)
+{
+    PackagingInfo packagingInfo(BranchIO::Test::getTestKey());
+    packagingInfo.getAdvertiserInfo().addId(AdvertiserInfo::AdIdType::WINDOWS_ADVERTISING_ID, "id_windows");
+
+    EnvelopeCache cache;
+    ASSERT_TRUE(JSONObject::parse(*cache.getUserData(packagingInfo)).has("advertising_ids"));
+
+    // Not a property change, but part of the cache key.
+    packagingInfo.getAdvertiserInfo().limitAdTracking(true);
+    ASSERT_FALSE(JSONObject::parse(*cache.getUserData(packagingInfo)).has("advertising_ids"));
+}
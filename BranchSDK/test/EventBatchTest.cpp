@@ -0,0 +1,97 @@
+#include <BranchIO/Event/CustomEvent.h>
+#include <BranchIO/Event/StandardEvent.h>
+#include <BranchIO/PackagingInfo.h>
+#include <BranchIO/Util/EventBatch.h>
+
+#include <gtest/gtest.h>
+
+#include "ResponseCounter.h"
+#include "Util.h"
+
+using namespace std;
+using namespace BranchIO;
+
+class EventBatchTest : public ::testing::Test
+{
+};
+
+TEST_F(EventBatchTest, TestBatchableEndpoints)
+{
+    ASSERT_TRUE(EventBatch::isBatchable(Defines::TRACK_STANDARD_EVENT));
+    ASSERT_TRUE(EventBatch::isBatchable(Defines::TRACK_CUSTOM_EVENT));
+    ASSERT_FALSE(EventBatch::isBatchable(Defines::REGISTER_OPEN));
+    ASSERT_FALSE(EventBatch::isBatchable(Defines::IDENTIFY_USER));
+    ASSERT_FALSE(EventBatch::isBatchable(Defines::URL));
+}
+
+TEST_F(EventBatchTest, TestPackageBatch)
+{
+    PackagingInfo packagingInfo(BranchIO::Test::getTestKey());
+    EventBatch batch(EventBatch::Clock::now());
+    ResponseCounter counter;
+
+    batch.add(StandardEvent(StandardEvent::Type::PURCHASE), &counter);
+    batch.add(CustomEvent("My Custom Event"), &counter);
+
+    ASSERT_EQ(2u, batch.size());
+    ASSERT_GT(batch.getByteCount(), 0u);
+
+    JSONObject jsonObject;
+    batch.package(packagingInfo, jsonObject);
+
+    ASSERT_TRUE(jsonObject.has("branch_key"));
+    ASSERT_TRUE(jsonObject.has("user_data"));
+    ASSERT_TRUE(jsonObject.has("events"));
+    ASSERT_FALSE(jsonObject.has("event_data"));
+}
+
+TEST_F(EventBatchTest, TestCallbackFanOut)
+{
+    EventBatch batch(EventBatch::Clock::now());
+    ResponseCounter first;
+    ResponseCounter second;
+
+    batch.add(CustomEvent("one"), &first);
+    batch.add(CustomEvent("two"), &second);
+    batch.add(CustomEvent("three"), &second);
+
+    batch.onSuccess(0, JSONObject());
+
+    ASSERT_EQ(1u, first.getResponseCount());
+    ASSERT_EQ(2u, second.getResponseCount());
+
+    batch.onError(0, 500, "Internal Server Error");
+
+    ASSERT_EQ(2u, first.getResponseCount());
+    ASSERT_EQ(4u, second.getResponseCount());
+}
+
+TEST_F(EventBatchTest, TestRemoveExpired)
+{
+    EventBatch batch(EventBatch::Clock::now());
+    ResponseCounter expired;
+    ResponseCounter live;
+    BaseEvent::Clock::time_point now = BaseEvent::Clock::now();
+
+    CustomEvent first("one");
+    first.setDeadline(now - chrono::seconds(1));
+    batch.add(std::move(first), &expired, 1);
+
+    CustomEvent second("two");
+    second.setDeadline(now + chrono::seconds(60));
+    batch.add(std::move(second), &live, 2);
+
+    CustomEvent third("three");
+    third.setDeadline(now + chrono::seconds(120));
+    batch.add(std::move(third), &live, 0);
+
+    vector<uint64_t> recordIds;
+    ASSERT_EQ(1u, batch.removeExpired(now, recordIds));
+    ASSERT_EQ(vector<uint64_t>({ 1 }), recordIds);
+    ASSERT_EQ(1u, expired.getResponseCount());
+    ASSERT_EQ(0u, live.getResponseCount());
+
+    ASSERT_EQ(2u, batch.size());
+    ASSERT_EQ(vector<uint64_t>({ 2 }), batch.getRecordIds());
+    ASSERT_TRUE(batch.getExpiry() == now + chrono::seconds(120));
+}
@@ -1,3 +1,4 @@
+#include <BranchIO/Event/PersistedEvent.h>
 #include <BranchIO/Event/StandardEvent.h>
 #include <BranchIO/Request.h>
 
@@ -39,3 +40,54 @@ TEST_F(EventTest, TestCreateEvent)
 
     // cout << "TestCreateEvent: " << jsonObject.stringify() << endl;
 }
+
+TEST_F(EventTest, TestMoveEvent)
+{
+    StandardEvent event(StandardEvent::Type::PURCHASE);
+    event.setDescription("My Description");
+    event.addCustomDataProperty("Custom", "My Custom Data Property");
+
+    bool handled = false;
+    event.setResultHandler([&handled](const JSONObject&) { handled = true; });
+    uint64_t version = event.getVersion();
+
+    BaseEvent moved(std::move(event));
+    ASSERT_EQ("PURCHASE", moved.name());
+    ASSERT_EQ(Defines::TRACK_STANDARD_EVENT, moved.getAPIEndpoint());
+    ASSERT_EQ("My Description", moved.getStringProperty(Defines::JSONKEY_DESCRIPTION));
+    ASSERT_TRUE(moved.getCustomData().has("Custom"));
+    ASSERT_EQ(version, moved.getVersion());
+
+    moved.handleResult(JSONObject());
+    ASSERT_TRUE(handled);
+
+    // The original is empty, but still usable.
+    ASSERT_TRUE(event.isEmpty());
+    ASSERT_FALSE(event.getCustomData().has("Custom"));
+    ASSERT_NE(version, event.getVersion());
+    event.setDescription("Another Description");
+    event.handleResult(JSONObject());
+    ASSERT_EQ("Another Description", event.getStringProperty(Defines::JSONKEY_DESCRIPTION));
+}
+
+TEST_F(EventTest, TestDeadline)
+{
+    StandardEvent event(StandardEvent::Type::PURCHASE);
+    ASSERT_FALSE(event.hasDeadline());
+    ASSERT_FALSE(event.isExpired());
+
+    event.setTimeToLive(chrono::minutes(1));
+    ASSERT_TRUE(event.hasDeadline());
+    ASSERT_FALSE(event.isExpired());
+    ASSERT_TRUE(event.isExpired(BaseEvent::Clock::now() + chrono::minutes(2)));
+
+    // Copies and persisted events keep the deadline.
+    BaseEvent copy(event);
+    ASSERT_EQ(event.getDeadline(), copy.getDeadline());
+
+    unique_ptr<PersistedEvent> restored(PersistedEvent::deserialize(PersistedEvent::serialize(event)));
+    ASSERT_TRUE(restored.get());
+    ASSERT_EQ(
+        chrono::duration_cast<chrono::milliseconds>(event.getDeadline().time_since_epoch()),
+        chrono::duration_cast<chrono::milliseconds>(restored->getDeadline().time_since_epoch()));
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include <BranchIO/Util/CRC32.h>
+#include <BranchIO/Util/Gzip.h>
+
+using namespace std;
+using namespace BranchIO;
+
+namespace {
+
+/**
+ * Minimal inflater for a gzip stream with one fixed Huffman block, as
+ * written by Gzip::compress.
+ */
+class FixedInflater {
+ public:
+    explicit FixedInflater(const string& gzip) : _in(gzip), _position(10 * 8) {}
+
+    string inflate() {
+        string out;
+        if (bits(1) != 1 || bits(2) != 1) return "bad block header";
+
+        while (true) {
+            unsigned int symbol = readSymbol();
+            if (symbol < 256) {
+                out.push_back(static_cast<char>(symbol));
+            } else if (symbol == 256) {
+                return out;
+            } else {
+                static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+                static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+                static const uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+                static const uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+                unsigned int l = symbol - 257;
+                size_t length = lengthBase[l] + bits(lengthExtra[l]);
+                unsigned int d = code(5);
+                size_t distance = distanceBase[d] + bits(distanceExtra[d]);
+                if (distance > out.size()) return "bad distance";
+                for (size_t j = 0; j < length; ++j) {
+                    out.push_back(out[out.size() - distance]);
+                }
+            }
+        }
+    }
+
+ private:
+    unsigned int bits(int count) {
+        unsigned int value = 0;
+        for (int j = 0; j < count; ++j, ++_position) {
+            value |= ((static_cast<uint8_t>(_in[_position / 8]) >> (_position % 8)) & 1) << j;
+        }
+        return value;
+    }
+
+    unsigned int code(int length) {
+        unsigned int value = 0;
+        for (int j = 0; j < length; ++j) {
+            value = (value << 1) | bits(1);
+        }
+        return value;
+    }
+
+    unsigned int readSymbol() {
+        unsigned int c = code(7);
+        if (c < 0x18) return c + 256;
+        c = (c << 1) | bits(1);
+        if (c >= 0x30 && c < 0xC0) return c - 0x30;
+        if (c >= 0xC0 && c < 0xC8) return c - 0xC0 + 280;
+        c = (c << 1) | bits(1);
+        return c - 0x190 + 144;
+    }
+
+    const string& _in;
+    size_t _position;
+};
+
+uint32_t
+readLE32(const string& s, size_t offset) {
+    uint32_t value = 0;
+    for (int j = 3; j >= 0; --j) {
+        value = (value << 8) | static_cast<uint8_t>(s[offset + j]);
+    }
+    return value;
+}
+
+}  // namespace
+
+TEST(GzipTest, TestEmpty)
+{
+    string gzip(Gzip::compress(string()));
+    ASSERT_EQ(string("\x1F\x8B\x08\x00\x00\x00\x00\x00\x00\xFF\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00", 20), gzip);
+}
+
+TEST(GzipTest, TestRoundTrip)
+{
+    string data;
+    for (int j = 0; j < 200; ++j) {
+        data += "{\"name\":\"PURCHASE\",\"customer_event_alias\":\"alias" + to_string(j) + "\",\"revenue\":" + to_string(j * 3) + "},";
+    }
+    data += string("\x00\xFF\x80 binary", 10);
+
+    string gzip(Gzip::compress(data));
+    ASSERT_EQ(0x1F, static_cast<uint8_t>(gzip[0]));
+    ASSERT_EQ(0x8B, static_cast<uint8_t>(gzip[1]));
+    ASSERT_EQ(CRC32::compute(data.data(), data.size()), readLE32(gzip, gzip.size() - 8));
+    ASSERT_EQ(data.size(), readLE32(gzip, gzip.size() - 4));
+
+    // Repeated keys compress well.
+    ASSERT_LT(gzip.size() * 4, data.size());
+    ASSERT_EQ(data, FixedInflater(gzip).inflate());
+}
+
+TEST(GzipTest, TestLongRuns)
+{
+    // Longest matches and distances near the window size
+    string data(70000, 'a');
+    for (size_t j = 0; j < data.size(); j += 997) {
+        data[j] = static_cast<char>('b' + j % 20);
+    }
+
+    string gzip(Gzip::compress(data));
+    ASSERT_EQ(data, FixedInflater(gzip).inflate());
+}
@@ -2,6 +2,9 @@
 
 #include <BranchIO/JSONObject.h>
 
+#include <stdexcept>
+#include <vector>
+
 using namespace std;
 using namespace BranchIO;
 
@@ -32,3 +35,118 @@ TEST(JSONObjectTest, TestParseObject) {
     JSONObject object(JSONObject::parse("{\"foo\": \"bar\"}"));
     ASSERT_EQ(object.getNamedString("foo"), "bar");
 }
+
+TEST(JSONObjectTest, TestParseEmptyString) {
+    JSONObject object(JSONObject::parse(""));
+    ASSERT_TRUE(object.isEmpty());
+}
+
+TEST(JSONObjectTest, TestParseInvalid) {
+    ASSERT_THROW(JSONObject::parse("{\"foo\": }"), std::invalid_argument);
+    ASSERT_THROW(JSONObject::parse("[1, 2]"), std::invalid_argument);
+    ASSERT_THROW(JSONObject::parse("{\"foo\": \"bar\"} x"), std::invalid_argument);
+    ASSERT_THROW(JSONObject::parse("{\"foo\": 01}"), std::invalid_argument);
+}
+
+TEST(JSONObjectTest, TestStringifyRoundTrip) {
+    string json("{\"s\":\"bar\",\"n\":-1.5,\"i\":42,\"t\":true,\"f\":false,\"z\":null,"
+        "\"a\":[1,\"two\",{\"three\":3}],\"o\":{\"nested\":{}}}");
+    JSONObject object(JSONObject::parse(json));
+    ASSERT_EQ(json, object.stringify());
+    ASSERT_EQ(8u, object.size());
+}
+
+TEST(JSONObjectTest, TestStringEscapes) {
+    JSONObject object(JSONObject::parse("{\"k\": \"a\\\"b\\\\c\\n\\u00e9\\ud83d\\ude00\"}"));
+    ASSERT_EQ("a\"b\\c\n\xC3\xA9\xF0\x9F\x98\x80", object.getNamedString("k"));
+    ASSERT_EQ("{\"k\":\"a\\\"b\\\\c\\n\xC3\xA9\xF0\x9F\x98\x80\"}", object.stringify());
+
+    JSONObject control;
+    control.set("c", string("\x01"));
+    ASSERT_EQ("{\"c\":\"\\u0001\"}", control.stringify());
+}
+
+TEST(JSONObjectTest, TestSetReplacesInPlace) {
+    JSONObject object;
+    object.set("a", 1);
+    object.set("b", 2);
+    object.set("a", string("one"));
+    ASSERT_EQ("{\"a\":\"one\",\"b\":2}", object.stringify());
+
+    object.remove("a");
+    ASSERT_FALSE(object.has("a"));
+    ASSERT_EQ("{\"b\":2}", object.stringify());
+}
+
+TEST(JSONObjectTest, TestMerge) {
+    JSONObject object(JSONObject::parse("{\"a\":1,\"b\":2}"));
+    object += JSONObject::parse("{\"b\":3,\"c\":4}");
+    ASSERT_EQ("{\"a\":1,\"b\":3,\"c\":4}", object.stringify());
+}
+
+TEST(JSONObjectTest, TestCopiesShareObject) {
+    JSONObject object;
+    JSONObject copy(object);
+    copy.set("foo", "bar");
+    ASSERT_EQ("bar", object.getNamedString("foo"));
+}
+
+TEST(JSONObjectTest, TestSetCopiesObject) {
+    JSONObject child;
+    child.set("a", 1);
+
+    JSONObject parent;
+    parent.set("child", child);
+    parent.set("children", vector<JSONObject>{ child });
+
+    // Later changes to the child don't show up in the parent.
+    child.set("b", 2);
+    ASSERT_EQ("{\"child\":{\"a\":1},\"children\":[{\"a\":1}]}", parent.stringify());
+
+    // Inserting an object into itself, or into a descendant, doesn't make a cycle.
+    parent.set("self", parent);
+    ASSERT_EQ("{\"child\":{\"a\":1},\"children\":[{\"a\":1}],\"self\":{\"child\":{\"a\":1},\"children\":[{\"a\":1}]}}",
+        parent.stringify());
+    child.set("parent", parent);
+    ASSERT_EQ(3u, JSONObject::parse(child.stringify()).size());
+}
+
+TEST(JSONObjectTest, TestArrays) {
+    JSONObject item;
+    item.set("name", "item");
+
+    JSONObject object;
+    object.set("strings", vector<string>{ "a", "b" });
+    object.set("objects", vector<JSONObject>{ item, item });
+    ASSERT_EQ("{\"strings\":[\"a\",\"b\"],\"objects\":[{\"name\":\"item\"},{\"name\":\"item\"}]}", object.stringify());
+}
+
+TEST(JSONObjectTest, TestGetNamedStringWrongType) {
+    JSONObject object(JSONObject::parse("{\"n\": 1}"));
+    ASSERT_THROW(object.getNamedString("n"), std::invalid_argument);
+    ASSERT_THROW(object.getNamedString("missing"), std::invalid_argument);
+}
+
+TEST(JSONObjectTest, TestSetRaw) {
+    JSONObject object;
+    object.set("a", 1);
+    object.setRaw("raw", make_shared<const string>("{\"b\":[true,null]}"));
+    ASSERT_EQ("{\"a\":1,\"raw\":{\"b\":[true,null]}}", object.stringify());
+
+    // The output parses back to the same structure.
+    ASSERT_EQ(object.stringify(), JSONObject::parse(object.stringify()).stringify());
+}
+
+TEST(JSONObjectTest, TestStringifyIntoBuffer) {
+    JSONObject object(JSONObject::parse("{\"a\":\"long enough to need a heap allocation\"}"));
+    string buffer("previous contents");
+    object.stringify(buffer);
+    ASSERT_EQ(object.stringify(), buffer);
+
+    // The buffer is reused.
+    const char* data = buffer.data();
+    JSONObject smaller(JSONObject::parse("{\"b\":1}"));
+    smaller.stringify(buffer);
+    ASSERT_EQ("{\"b\":1}", buffer);
+    ASSERT_EQ(data, buffer.data());
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <BranchIO/JSONObject.h>
+#include <BranchIO/Util/LinkCache.h>
+
+using namespace std;
+using namespace BranchIO;
+
+TEST(LinkCacheTest, TestMakeKeyIgnoresOrder)
+{
+    JSONObject a;
+    a.set("branch_key", "key_live_xxx");
+    a.set("channel", "email");
+    a.set("tags", vector<string>{ "one", "two" });
+    JSONObject dataA;
+    dataA.set("$canonical_identifier", "item/1");
+    dataA.set("$og_title", "Item");
+    a.set("data", dataA);
+
+    JSONObject b;
+    JSONObject dataB;
+    dataB.set("$og_title", "Item");
+    dataB.set("$canonical_identifier", "item/1");
+    b.set("data", dataB);
+    b.set("tags", vector<string>{ "one", "two" });
+    b.set("channel", "email");
+    b.set("branch_key", "key_live_xxx");
+
+    ASSERT_EQ(LinkCache::makeKey(a), LinkCache::makeKey(b));
+
+    // Array order matters
+    b.set("tags", vector<string>{ "two", "one" });
+    ASSERT_NE(LinkCache::makeKey(a), LinkCache::makeKey(b));
+}
+
+TEST(LinkCacheTest, TestHit)
+{
+    LinkCache cache(4, chrono::hours(1));
+    string url;
+
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    string shortUrl("https://test.app.link/a");
+    cache.complete("a", &shortUrl);
+    ASSERT_EQ(1, cache.size());
+
+    ASSERT_EQ(LinkCache::Hit, cache.acquire("a", url, nullptr));
+    ASSERT_EQ(shortUrl, url);
+}
+
+TEST(LinkCacheTest, TestFailureNotCached)
+{
+    LinkCache cache(4, chrono::hours(1));
+    string url;
+
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    cache.complete("a", nullptr);
+    ASSERT_EQ(0, cache.size());
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+}
+
+TEST(LinkCacheTest, TestExpiry)
+{
+    LinkCache cache(4, chrono::milliseconds(20));
+    string url;
+    string shortUrl("https://test.app.link/a");
+
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    cache.complete("a", &shortUrl);
+
+    this_thread::sleep_for(chrono::milliseconds(40));
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    ASSERT_EQ(0, cache.size());
+}
+
+TEST(LinkCacheTest, TestLeastRecentlyUsedEvicted)
+{
+    LinkCache cache(2, chrono::hours(1));
+    string url;
+    string urlA("https://test.app.link/a");
+    string urlB("https://test.app.link/b");
+    string urlC("https://test.app.link/c");
+
+    cache.acquire("a", url, nullptr);
+    cache.complete("a", &urlA);
+    cache.acquire("b", url, nullptr);
+    cache.complete("b", &urlB);
+
+    // a is now more recently used than b
+    ASSERT_EQ(LinkCache::Hit, cache.acquire("a", url, nullptr));
+
+    cache.acquire("c", url, nullptr);
+    cache.complete("c", &urlC);
+    ASSERT_EQ(2, cache.size());
+
+    ASSERT_EQ(LinkCache::Hit, cache.acquire("a", url, nullptr));
+    ASSERT_EQ(LinkCache::Hit, cache.acquire("c", url, nullptr));
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("b", url, nullptr));
+}
+
+TEST(LinkCacheTest, TestSingleFlight)
+{
+    // Identical requests are joined even with caching disabled.
+    LinkCache cache(0, chrono::hours(1));
+    string url;
+    int calls = 0;
+    string result;
+
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    for (int j = 0; j < 3; ++j) {
+        ASSERT_EQ(LinkCache::Joined, cache.acquire("a", url, [&](LinkCache::Status status, const string* url) {
+            ASSERT_EQ(LinkCache::Hit, status);
+            ++ calls;
+            result = url ? *url : "";
+        }));
+    }
+
+    string shortUrl("https://test.app.link/a");
+    cache.complete("a", &shortUrl);
+    ASSERT_EQ(3, calls);
+    ASSERT_EQ(shortUrl, result);
+    ASSERT_EQ(0, cache.size());
+
+    // The next request is sent again.
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    cache.complete("a", nullptr);
+}
+
+TEST(LinkCacheTest, TestAbandonPromotesWaiter)
+{
+    LinkCache cache(4, chrono::hours(1));
+    string url;
+    vector<LinkCache::Status> statuses;
+    vector<string> results;
+    auto waiter = [&](LinkCache::Status status, const string* url) {
+        statuses.push_back(status);
+        results.push_back(url ? *url : "");
+    };
+
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    ASSERT_EQ(LinkCache::Joined, cache.acquire("a", url, waiter));
+    ASSERT_EQ(LinkCache::Joined, cache.acquire("a", url, waiter));
+
+    // Only the first waiter takes over. The other one keeps waiting.
+    cache.abandon("a");
+    ASSERT_EQ(vector<LinkCache::Status>({ LinkCache::Leader }), statuses);
+    ASSERT_EQ(LinkCache::Joined, cache.acquire("a", url, waiter));
+
+    string shortUrl("https://test.app.link/a");
+    cache.complete("a", &shortUrl);
+    ASSERT_EQ(vector<LinkCache::Status>({ LinkCache::Leader, LinkCache::Hit, LinkCache::Hit }), statuses);
+    ASSERT_EQ(shortUrl, results[1]);
+    ASSERT_EQ(shortUrl, results[2]);
+
+    // With no waiters, the next caller leads.
+    ASSERT_EQ(LinkCache::Hit, cache.acquire("a", url, nullptr));
+    cache.clear();
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    cache.abandon("a");
+    ASSERT_EQ(LinkCache::Leader, cache.acquire("a", url, nullptr));
+    cache.complete("a", nullptr);
+}
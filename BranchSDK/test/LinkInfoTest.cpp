@@ -150,4 +150,72 @@ TEST_F(LinkInfoTest, FallbackToLongUrl) {
     EXPECT_CALL(callback, onSuccess(_, _)).Times(1);
 
     info.createUrl(mBranch, &callback);
-}
\ No newline at end of file
+}
+
+TEST_F(LinkInfoTest, CreateUrlFuture) {
+    struct SuccessfulClientSession : public virtual IClientSession {
+        void stop() {}
+        bool post(const string& path, const JSONObject& payload, IRequestCallback& callback, JSONObject& result) {
+            result.set("url", "https://example.app.link/abc");
+            callback.onSuccess(0, result);
+            return true;
+        }
+    } clientSession;
+
+    LinkInfo info;
+    info.setClientSession(&clientSession);
+
+    future<string> url = info.createUrl(mBranch);
+    ASSERT_EQ("https://example.app.link/abc", url.get());
+}
+
+TEST_F(LinkInfoTest, CreateUrlFutureFallback) {
+    struct FailingClientSession : public virtual IClientSession {
+        void stop() {}
+        bool post(const string& path, const JSONObject& payload, IRequestCallback& callback, JSONObject& result) {
+            callback.onError(0, 0, "something happened");
+            return true;
+        }
+    } failingClientSession;
+
+    LinkInfo info;
+    info.setClientSession(&failingClientSession);
+
+    future<string> url = info.createUrl(mBranch);
+    ASSERT_EQ(0u, url.get().find("https://bnc.lt/a/"));
+}
+
+TEST_F(LinkInfoTest, CreateUrls) {
+    struct AliasClientSession : public virtual IClientSession {
+        void stop() {}
+        bool post(const string& path, const JSONObject& payload, IRequestCallback& callback, JSONObject& result) {
+            string alias = payload.getNamedString("alias");
+            if (alias == "bad") {
+                callback.onError(0, 0, "something happened");
+                return false;
+            }
+
+            result.set("url", "https://example.app.link/" + alias);
+            callback.onSuccess(0, result);
+            return true;
+        }
+    } clientSession;
+
+    vector<unique_ptr<LinkInfo>> infos;
+    vector<LinkInfo*> links;
+    for (const char* alias : { "a", "b", "bad", "c", "d", "e" }) {
+        infos.emplace_back(new LinkInfo);
+        infos.back()->setClientSession(&clientSession);
+        infos.back()->setAlias(alias);
+        links.push_back(infos.back().get());
+    }
+
+    vector<string> urls = LinkInfo::createUrls(mBranch, links).get();
+    ASSERT_EQ(6, urls.size());
+    ASSERT_EQ("https://example.app.link/a", urls[0]);
+    ASSERT_EQ("https://example.app.link/b", urls[1]);
+    ASSERT_EQ(0u, urls[2].find("https://bnc.lt/a/"));
+    ASSERT_EQ("https://example.app.link/e", urls[5]);
+
+    ASSERT_TRUE(LinkInfo::createUrls(mBranch, vector<LinkInfo*>()).get().empty());
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include <BranchIO/Util/EventCount.h>
+#include <BranchIO/Util/MPSCQueue.h>
+
+using namespace std;
+using namespace BranchIO;
+
+struct TestNode : public MPSCQueueNode {
+    TestNode(int producer, int sequence) : producer(producer), sequence(sequence) {}
+
+    int producer;
+    int sequence;
+};
+
+TEST(MPSCQueueTest, TestFifo)
+{
+    MPSCQueue<TestNode> queue;
+    ASSERT_EQ(nullptr, queue.pop());
+
+    TestNode a(0, 0), b(0, 1), c(0, 2);
+    queue.push(&a);
+    queue.push(&b);
+    ASSERT_EQ(&a, queue.pop());
+
+    queue.push(&c);
+    ASSERT_EQ(&b, queue.pop());
+    ASSERT_EQ(&c, queue.pop());
+    ASSERT_EQ(nullptr, queue.pop());
+
+    // Nodes can be pushed again once popped.
+    queue.push(&a);
+    ASSERT_EQ(&a, queue.pop());
+    ASSERT_EQ(nullptr, queue.pop());
+}
+
+TEST(MPSCQueueTest, TestProducerOrder)
+{
+    const int Producers = 4;
+    const int PerProducer = 10000;
+
+    vector<deque<TestNode>> nodes(Producers);
+    for (int p = 0; p < Producers; ++p) {
+        for (int j = 0; j < PerProducer; ++j) {
+            nodes[p].emplace_back(p, j);
+        }
+    }
+
+    MPSCQueue<TestNode> queue;
+    EventCount pushed;
+    vector<thread> producers;
+    for (int p = 0; p < Producers; ++p) {
+        producers.emplace_back([&, p]() {
+            for (TestNode& node : nodes[p]) {
+                queue.push(&node);
+                pushed.notifyOne();
+            }
+        });
+    }
+
+    // Each producer's nodes come out in the order they were pushed.
+    vector<int> next(Producers, 0);
+    int popped = 0;
+    while (popped < Producers * PerProducer) {
+        EventCount::Key key = pushed.prepareWait();
+        TestNode* node = queue.pop();
+        if (!node) {
+            pushed.wait(key, 100);
+            continue;
+        }
+        pushed.cancelWait();
+
+        ASSERT_EQ(next[node->producer], node->sequence);
+        ++ next[node->producer];
+        ++ popped;
+    }
+
+    for (thread& producer : producers) {
+        producer.join();
+    }
+    ASSERT_EQ(nullptr, queue.pop());
+}
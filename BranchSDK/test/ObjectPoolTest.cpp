@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <BranchIO/Util/ObjectPool.h>
+
+using namespace std;
+using namespace BranchIO;
+
+struct CountedObject {
+    static atomic<int> constructed;
+    static atomic<int> destroyed;
+
+    explicit CountedObject(int value) : value(value) {
+        if (value < 0) throw invalid_argument("negative");
+        ++ constructed;
+    }
+
+    ~CountedObject() {
+        ++ destroyed;
+    }
+
+    int value;
+};
+
+atomic<int> CountedObject::constructed(0);
+atomic<int> CountedObject::destroyed(0);
+
+class ObjectPoolTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        CountedObject::constructed = 0;
+        CountedObject::destroyed = 0;
+    }
+};
+
+TEST_F(ObjectPoolTest, TestReleaseOnScopeExit)
+{
+    ObjectPool<CountedObject> pool(4);
+    {
+        ObjectPool<CountedObject>::Ptr object(pool.acquire(7));
+        ASSERT_EQ(7, object->value);
+        ASSERT_EQ(1, pool.getLiveCount());
+        ASSERT_EQ(4, pool.getCapacity());
+    }
+
+    ASSERT_EQ(0, pool.getLiveCount());
+    ASSERT_EQ(1, CountedObject::constructed.load());
+    ASSERT_EQ(1, CountedObject::destroyed.load());
+}
+
+TEST_F(ObjectPoolTest, TestReleaseAndAdopt)
+{
+    ObjectPool<CountedObject> pool(4);
+    CountedObject* raw = pool.acquire(1).release();
+    ASSERT_EQ(1, pool.getLiveCount());
+    ASSERT_EQ(0, CountedObject::destroyed.load());
+
+    pool.adopt(raw);
+    ASSERT_EQ(0, pool.getLiveCount());
+    ASSERT_EQ(1, CountedObject::destroyed.load());
+}
+
+TEST_F(ObjectPoolTest, TestConstructorThrows)
+{
+    ObjectPool<CountedObject> pool(4);
+    ASSERT_THROW(pool.acquire(-1), invalid_argument);
+    ASSERT_EQ(0, pool.getLiveCount());
+    ASSERT_EQ(0, CountedObject::destroyed.load());
+}
+
+TEST_F(ObjectPoolTest, TestMemoryReused)
+{
+    ObjectPool<CountedObject> pool(16);
+
+    // Never more than 10 alive at once
+    vector<ObjectPool<CountedObject>::Ptr> objects;
+    for (int j = 0; j < 100000; ++j) {
+        objects.push_back(pool.acquire(j));
+        if (objects.size() == 10) objects.clear();
+    }
+    objects.clear();
+
+    ASSERT_EQ(16, pool.getCapacity());
+    ASSERT_EQ(0, pool.getLiveCount());
+    ASSERT_EQ(CountedObject::constructed.load(), CountedObject::destroyed.load());
+}
+
+TEST_F(ObjectPoolTest, TestThreads)
+{
+    ObjectPool<CountedObject> pool(8);
+
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, t]() {
+            for (int j = 0; j < 10000; ++j) {
+                ObjectPool<CountedObject>::Ptr object(pool.acquire(t));
+                ASSERT_EQ(t, object->value);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(0, pool.getLiveCount());
+    ASSERT_EQ(8, pool.getCapacity());
+    ASSERT_EQ(40000, CountedObject::destroyed.load());
+}
+
+TEST_F(ObjectPoolTest, TestReleaseOnOtherThreads)
+{
+    // Objects acquired by producers and released by consumers, as requests
+    // are by RequestManager, with a small slab so the free list is contended.
+    ObjectPool<CountedObject> pool(2);
+    mutex handOffMutex;
+    vector<CountedObject*> handOff;
+    atomic<int> released(0);
+
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int j = 0; j < 5000; ++j) {
+                CountedObject* object = pool.acquire(t).release();
+                CountedObject* other = nullptr;
+                {
+                    scoped_lock _l(handOffMutex);
+                    handOff.push_back(object);
+                    if (handOff.size() > 4) {
+                        other = handOff.front();
+                        handOff.erase(handOff.begin());
+                    }
+                }
+                if (other) {
+                    pool.adopt(other);
+                    ++ released;
+                }
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    for (CountedObject* object : handOff) {
+        pool.adopt(object);
+    }
+
+    ASSERT_EQ(0, pool.getLiveCount());
+    ASSERT_EQ(20000, CountedObject::destroyed.load());
+    ASSERT_LE(pool.getCapacity(), 10u);
+}
@@ -63,3 +63,34 @@ TEST_F(PropertyManagerTest, TestWriteSubProperty)
 
     cout << "TestWriteSubProperty:\t" << mgr.toString() << endl;
 }
+
+TEST_F(PropertyManagerTest, TestVersion)
+{
+    PropertyManager mgr;
+    uint64_t version = mgr.getVersion();
+
+    mgr.addProperty("Foo", "Bar");
+    ASSERT_NE(version, mgr.getVersion());
+    version = mgr.getVersion();
+
+    ASSERT_EQ("Bar", mgr.getStringProperty("Foo"));
+    ASSERT_EQ(version, mgr.getVersion());
+
+    // Copies share properties and version until one of them is modified.
+    PropertyManager copy(mgr);
+    ASSERT_EQ(version, copy.getVersion());
+    copy.addProperty("Foo", "Baz");
+    ASSERT_NE(version, copy.getVersion());
+    ASSERT_EQ("Baz", copy.getStringProperty("Foo"));
+    ASSERT_EQ("Bar", mgr.getStringProperty("Foo"));
+    ASSERT_EQ(version, mgr.getVersion());
+
+    PropertyManager other(mgr);
+    mgr.addProperty("Foo", "Qux");
+    ASSERT_EQ("Bar", other.getStringProperty("Foo"));
+    ASSERT_EQ(version, other.getVersion());
+
+    other = copy;
+    ASSERT_EQ(copy.getVersion(), other.getVersion());
+    ASSERT_EQ("Baz", other.getStringProperty("Foo"));
+}
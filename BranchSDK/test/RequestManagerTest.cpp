@@ -106,3 +106,111 @@
 //     mCallback.waitForResponses(2, 1000);
 //     ASSERT_EQ(2, mCallback.getResponseCount());
 // }
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <BranchIO/Event/CustomEvent.h>
+#include <BranchIO/Event/SessionEvent.h>
+#include <BranchIO/PackagingInfo.h>
+#include <BranchIO/Util/RequestManager.h>
+
+using namespace std;
+using namespace BranchIO;
+
+namespace {
+
+/**
+ * Records the paths of the requests posted, once it is opened.
+ */
+struct RecordingClientSession : public IClientSession {
+    RecordingClientSession() : open(false) {}
+
+    void stop() {}
+
+    bool post(const string& path, const JSONObject&, IRequestCallback& callback, JSONObject& result) {
+        while (!open) this_thread::sleep_for(chrono::milliseconds(1));
+        {
+            scoped_lock _l(mutex);
+            paths.push_back(path);
+        }
+        callback.onSuccess(0, result);
+        return true;
+    }
+
+    vector<string> getPaths() {
+        scoped_lock _l(mutex);
+        return paths;
+    }
+
+    atomic<bool> open;
+    mutex mutex;
+    vector<string> paths;
+};
+
+struct CountingCallback : public IRequestCallback {
+    CountingCallback() : count(0) {}
+
+    void onSuccess(int, JSONObject) { ++ count; }
+    void onError(int, int, string) { ++ count; }
+    void onStatus(int, int, string) {}
+
+    void waitFor(int expected) {
+        for (int j = 0; j < 500 && count < expected; ++j) this_thread::sleep_for(chrono::milliseconds(10));
+    }
+
+    atomic<int> count;
+};
+
+bool
+isOpen(const string& path) {
+    return path.find("v1/open") != string::npos;
+}
+
+}  // namespace
+
+TEST(RequestManagerOrderTest, SessionRequestPassesQueuedEvents) {
+    PackagingInfo packagingInfo;
+    RecordingClientSession session;
+    CountingCallback callback;
+    RequestManager manager(packagingInfo, &session, Configuration().setRequestConcurrency(1));
+    manager.start();
+
+    // The first event is in flight. The open is sent as soon as it is done.
+    for (int j = 0; j < 10; ++j) manager.enqueue(CustomEvent("before"), &callback);
+    manager.enqueue(SessionOpenEvent(), &callback);
+    manager.enqueue(CustomEvent("after"), &callback);
+    session.open = true;
+
+    callback.waitFor(12);
+    vector<string> paths(session.getPaths());
+    ASSERT_EQ(12, paths.size());
+    for (size_t j = 0; j < paths.size(); ++j) {
+        ASSERT_EQ(j == 1, isOpen(paths[j])) << j;
+    }
+}
+
+TEST(RequestManagerOrderTest, LaterEventsDoNotPassSessionRequest) {
+    PackagingInfo packagingInfo;
+    RecordingClientSession session;
+    CountingCallback callback;
+    RequestManager manager(packagingInfo, &session, Configuration().setRequestConcurrency(4));
+    manager.start();
+
+    manager.enqueue(CustomEvent("before"), &callback);
+    manager.enqueue(SessionOpenEvent(), &callback);
+    for (int j = 0; j < 10; ++j) manager.enqueue(CustomEvent("after"), &callback);
+    session.open = true;
+
+    callback.waitFor(12);
+    vector<string> paths(session.getPaths());
+    ASSERT_EQ(12, paths.size());
+    ASSERT_FALSE(isOpen(paths[0]));
+    ASSERT_TRUE(isOpen(paths[1]));
+}
@@ -3,6 +3,10 @@
 #include <BranchIO/Event/StandardEvent.h>
 #include <BranchIO/Request.h>
 
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
 using namespace std;
 using namespace BranchIO;
 using namespace testing;
@@ -24,3 +28,94 @@ TEST_F(RequestTest, Send)
 
     request.send(Defines::REGISTER_OPEN, JSONObject(), mCallback, &mClientSession);
 }
+
+TEST_F(RequestTest, RetryAfter)
+{
+    struct ThrottledClientSession : public virtual IClientSession {
+        void stop() {}
+        bool post(const string& path, const JSONObject& payload, IRequestCallback& callback, JSONObject& result) {
+            return false;
+        }
+        bool post(const string& path, const JSONObject& payload, IRequestCallback& callback, JSONObject& result, RetryInfo& retryInfo) {
+            retryInfo.retryAfterMillis = 60000;
+            return false;
+        }
+    } clientSession;
+
+    CircuitBreaker circuitBreaker;
+    RetryBudget retryBudget;
+    ExponentialBackoff backoffPolicy(1000, 2000);
+
+    Request request(circuitBreaker, retryBudget);
+    request.setBackoffPolicy(backoffPolicy);
+
+    JSONObject result;
+    ASSERT_EQ(60000, request.attempt(Defines::REGISTER_OPEN, JSONObject(), mCallback, &clientSession, result));
+    ASSERT_EQ(1, request.getAttemptCount());
+}
+
+TEST_F(RequestTest, Expired)
+{
+    CircuitBreaker circuitBreaker;
+    RetryBudget retryBudget;
+
+    Request request(circuitBreaker, retryBudget);
+    request.setDeadline(chrono::system_clock::now() - chrono::seconds(1));
+    ASSERT_TRUE(request.isExpired());
+
+    EXPECT_CALL(mClientSession, post(_, _, _, _)).Times(0);
+
+    JSONObject result;
+    ASSERT_EQ(0, request.attempt(Defines::REGISTER_OPEN, JSONObject(), mCallback, &mClientSession, result));
+    ASSERT_EQ(0, request.getAttemptCount());
+    ASSERT_EQ(1, mCallback.getResponseCount());
+}
+
+TEST_F(RequestTest, ExpiresBeforeRetry)
+{
+    CircuitBreaker circuitBreaker;
+    RetryBudget retryBudget;
+    ExponentialBackoff backoffPolicy(60000, 60000);
+
+    Request request(circuitBreaker, retryBudget);
+    request.setBackoffPolicy(backoffPolicy);
+    request.setDeadline(chrono::system_clock::now() + chrono::seconds(30));
+
+    EXPECT_CALL(mClientSession, post(_, _, _, _)).Times(1).WillOnce(Return(false));
+
+    // The retry would be after the deadline, so it fails now.
+    JSONObject result;
+    ASSERT_EQ(0, request.attempt(Defines::REGISTER_OPEN, JSONObject(), mCallback, &mClientSession, result));
+    ASSERT_EQ(1, request.getAttemptCount());
+    ASSERT_EQ(1, mCallback.getResponseCount());
+}
+
+TEST_F(RequestTest, ThrowingPostEndsProbe)
+{
+    struct ThrowingClientSession : public virtual IClientSession {
+        void stop() {}
+        bool post(const string& path, const JSONObject& payload, IRequestCallback& callback, JSONObject& result) {
+            throw runtime_error("post failed");
+        }
+        bool post(const string& path, const JSONObject& payload, IRequestCallback& callback, JSONObject& result, RetryInfo& retryInfo) {
+            throw runtime_error("post failed");
+        }
+    } clientSession;
+
+    CircuitBreaker circuitBreaker(1, 20);
+    RetryBudget retryBudget;
+
+    // Open the breaker, then let it go half-open.
+    ASSERT_EQ(0, circuitBreaker.acquire());
+    circuitBreaker.recordFailure();
+    this_thread::sleep_for(chrono::milliseconds(40));
+
+    Request request(circuitBreaker, retryBudget);
+    JSONObject result;
+    ASSERT_THROW(request.attempt(Defines::REGISTER_OPEN, JSONObject(), mCallback, &clientSession, result), runtime_error);
+
+    // The probe failed, so another one is allowed later.
+    ASSERT_EQ(CircuitBreaker::Open, circuitBreaker.getState());
+    this_thread::sleep_for(chrono::milliseconds(40));
+    ASSERT_EQ(0, circuitBreaker.acquire());
+}
@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include <BranchIO/Util/RetryBudget.h>
+
+using namespace std;
+using namespace BranchIO;
+
+TEST(RetryBudgetTest, TestAcquire)
+{
+    RetryBudget budget(3, 60000);
+
+    ASSERT_EQ(3, budget.getTokenCount());
+    for (int j = 0; j < 3; ++j) {
+        ASSERT_EQ(0, budget.acquire());
+    }
+
+    int32_t wait = budget.acquire();
+    ASSERT_GT(wait, 0);
+    ASSERT_LE(wait, 60000);
+    ASSERT_EQ(0, budget.getTokenCount());
+}
+
+TEST(RetryBudgetTest, TestRefill)
+{
+    RetryBudget budget(2, 20);
+
+    ASSERT_EQ(0, budget.acquire());
+    ASSERT_EQ(0, budget.acquire());
+    ASSERT_GT(budget.acquire(), 0);
+
+    this_thread::sleep_for(chrono::milliseconds(30));
+    ASSERT_EQ(0, budget.acquire());
+
+    // Never more than the capacity
+    this_thread::sleep_for(chrono::milliseconds(100));
+    ASSERT_EQ(2, budget.getTokenCount());
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include <BranchIO/Util/TimerWheel.h>
+
+using namespace std;
+using namespace BranchIO;
+
+typedef TimerWheel<int>::Clock Clock;
+
+TEST(TimerWheelTest, TestFiresInOrder)
+{
+    Clock::time_point start = Clock::now();
+    TimerWheel<int> wheel(chrono::milliseconds(10), start);
+
+    wheel.schedule(start + chrono::milliseconds(50), 2);
+    wheel.schedule(start + chrono::milliseconds(20), 1);
+    wheel.schedule(start + chrono::seconds(5), 3);
+    ASSERT_EQ(3, wheel.size());
+
+    vector<int> fired;
+    auto fire = [&](int value) { fired.push_back(value); };
+
+    ASSERT_EQ(0, wheel.advance(start + chrono::milliseconds(19), fire));
+    ASSERT_EQ(1, wheel.advance(start + chrono::milliseconds(20), fire));
+    ASSERT_EQ(1, wheel.advance(start + chrono::seconds(1), fire));
+    ASSERT_EQ(0, wheel.advance(start + chrono::milliseconds(4990), fire));
+    ASSERT_EQ(1, wheel.advance(start + chrono::milliseconds(5000), fire));
+
+    ASSERT_EQ(vector<int>({ 1, 2, 3 }), fired);
+    ASSERT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, TestLongDelays)
+{
+    Clock::time_point start = Clock::now();
+    TimerWheel<int> wheel(chrono::milliseconds(10), start);
+
+    // Each in a different level
+    vector<chrono::milliseconds> delays = {
+        chrono::milliseconds(300),
+        chrono::milliseconds(30000),
+        chrono::milliseconds(3000000),
+    };
+    for (size_t j = 0; j < delays.size(); ++j) {
+        wheel.schedule(start + delays[j], static_cast<int>(j));
+    }
+
+    for (size_t j = 0; j < delays.size(); ++j) {
+        vector<int> fired;
+        auto fire = [&](int value) { fired.push_back(value); };
+
+        Clock::time_point deadline;
+        ASSERT_TRUE(wheel.getNextDeadline(deadline));
+        ASSERT_LE(deadline, start + delays[j]);
+
+        wheel.advance(start + delays[j] - chrono::milliseconds(10), fire);
+        ASSERT_TRUE(fired.empty());
+        wheel.advance(start + delays[j], fire);
+        ASSERT_EQ(vector<int>({ static_cast<int>(j) }), fired);
+    }
+
+    Clock::time_point deadline;
+    ASSERT_FALSE(wheel.getNextDeadline(deadline));
+}
+
+TEST(TimerWheelTest, TestNextDeadline)
+{
+    Clock::time_point start = Clock::now();
+    TimerWheel<int> wheel(chrono::milliseconds(10), start);
+
+    wheel.schedule(start + chrono::milliseconds(95), 1);
+
+    // Rounded up to the next tick
+    Clock::time_point deadline;
+    ASSERT_TRUE(wheel.getNextDeadline(deadline));
+    ASSERT_EQ(start + chrono::milliseconds(100), deadline);
+}
+
+TEST(TimerWheelTest, TestClear)
+{
+    Clock::time_point start = Clock::now();
+    TimerWheel<int> wheel(chrono::milliseconds(10), start);
+
+    wheel.schedule(start + chrono::milliseconds(50), 1);
+    wheel.schedule(start + chrono::seconds(50), 2);
+    wheel.clear();
+    ASSERT_TRUE(wheel.empty());
+
+    int fired = 0;
+    wheel.advance(start + chrono::seconds(60), [&](int) { ++ fired; });
+    ASSERT_EQ(0, fired);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <BranchIO/Util/UTF.h>
+
+using namespace std;
+using namespace BranchIO;
+
+namespace {
+
+template <typename CharT>
+basic_string<CharT>
+fromUTF8(const string& in) {
+    basic_string<CharT> out(in.size(), CharT());
+    size_t length = UTF::fromUTF8(in.data(), in.size(), &out[0], out.size());
+    if (length == UTF::Invalid) return basic_string<CharT>(1, CharT('!'));
+    out.resize(length);
+    return out;
+}
+
+template <typename CharT>
+string
+toUTF8(const basic_string<CharT>& in) {
+    string out(UTF::maxUTF8Length<CharT>(in.size()), '\0');
+    size_t length = UTF::toUTF8(in.data(), in.size(), &out[0], out.size());
+    if (length == UTF::Invalid) return "!";
+    out.resize(length);
+    return out;
+}
+
+}  // namespace
+
+TEST(UTFTest, Empty) {
+    ASSERT_EQ(fromUTF8<char16_t>(""), u"");
+    ASSERT_EQ(toUTF8(u32string()), "");
+}
+
+TEST(UTFTest, LongAscii) {
+    // Long enough for several vector blocks and a scalar tail
+    string ascii;
+    for (int j = 0; j < 100; ++j) ascii += static_cast<char>('!' + j % 90);
+    u16string utf16(ascii.begin(), ascii.end());
+    u32string utf32(ascii.begin(), ascii.end());
+
+    ASSERT_EQ(fromUTF8<char16_t>(ascii), utf16);
+    ASSERT_EQ(fromUTF8<char32_t>(ascii), utf32);
+    ASSERT_EQ(toUTF8(utf16), ascii);
+    ASSERT_EQ(toUTF8(utf32), ascii);
+}
+
+TEST(UTFTest, MixedText) {
+    // ASCII run, then 2-, 3- and 4-byte sequences, then ASCII again
+    string utf8 = "{\"$canonical_identifier\": \"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80\", \"x\": 1}";
+    u16string utf16 = u"{\"$canonical_identifier\": \"café € \U0001F600\", \"x\": 1}";
+    u32string utf32 = U"{\"$canonical_identifier\": \"café € \U0001F600\", \"x\": 1}";
+
+    ASSERT_EQ(fromUTF8<char16_t>(utf8), utf16);
+    ASSERT_EQ(fromUTF8<char32_t>(utf8), utf32);
+    ASSERT_EQ(toUTF8(utf16), utf8);
+    ASSERT_EQ(toUTF8(utf32), utf8);
+}
+
+TEST(UTFTest, InvalidUTF8) {
+    const char* invalid[] = {
+        "\x80",                  // stray continuation byte
+        "abc\xC3",               // truncated sequence
+        "\xE2\x82",              // truncated sequence
+        "\xC3(",                 // bad continuation byte
+        "\xC0\xAF",              // overlong '/'
+        "\xE0\x80\xAF",          // overlong '/'
+        "\xED\xA0\x80",          // surrogate U+D800
+        "\xF4\x90\x80\x80",      // U+110000
+        "\xFF",
+    };
+    for (auto s : invalid) {
+        ASSERT_EQ(fromUTF8<char16_t>(s), u"!") << s;
+        ASSERT_EQ(fromUTF8<char32_t>(s), U"!") << s;
+    }
+}
+
+TEST(UTFTest, InvalidWide) {
+    ASSERT_EQ(toUTF8(u16string(1, char16_t(0xD800))), "!");
+    ASSERT_EQ(toUTF8(u16string(1, char16_t(0xDC00))), "!");
+    ASSERT_EQ(toUTF8(u16string({ char16_t(0xD800), u'a' })), "!");
+    ASSERT_EQ(toUTF8(u32string(1, char32_t(0xD800))), "!");
+    ASSERT_EQ(toUTF8(u32string(1, char32_t(0x110000))), "!");
+}
+
+TEST(UTFTest, OutputTooSmall) {
+    string ascii(40, 'a');
+    char16_t wide[32];
+    ASSERT_EQ(UTF::fromUTF8(ascii.data(), ascii.size(), wide, 32), UTF::Invalid);
+
+    // The surrogate pair needs two units
+    ASSERT_EQ(UTF::fromUTF8("\xF0\x9F\x98\x80", 4, wide, 1), UTF::Invalid);
+
+    u16string euro(20, u'€');
+    char narrow[40];
+    ASSERT_EQ(UTF::toUTF8(euro.data(), euro.size(), narrow, sizeof(narrow)), UTF::Invalid);
+}
+
+TEST(UTFTest, WideStrings) {
+    string utf8 = "Branch \xE2\x82\xAC";
+    wstring wide;
+    ASSERT_TRUE(UTF::fromUTF8(utf8, wide));
+    ASSERT_EQ(wide, L"Branch €");
+
+    string back;
+    ASSERT_TRUE(UTF::toUTF8(wide, back));
+    ASSERT_EQ(back, utf8);
+
+    ASSERT_FALSE(UTF::fromUTF8(string("\xC3"), wide));
+    ASSERT_TRUE(wide.empty());
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <BranchIO/Util/WeightedFairQueue.h>
+
+using namespace std;
+using namespace BranchIO;
+
+TEST(WeightedFairQueueTest, TestFifoWithinLane)
+{
+    WeightedFairQueue<int> queue({ 1 });
+    for (int j = 0; j < 5; ++j) {
+        queue.push(0, j);
+    }
+
+    for (int j = 0; j < 5; ++j) {
+        ASSERT_EQ(j, queue.front());
+        ASSERT_EQ(j, queue.pop());
+    }
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST(WeightedFairQueueTest, TestWeightedShares)
+{
+    WeightedFairQueue<int> queue({ 4, 1 });
+    for (int j = 0; j < 100; ++j) {
+        queue.push(0, 0);
+        queue.push(1, 1);
+    }
+
+    // While both lanes have values, lane 0 gets four of every five.
+    vector<int> served(2, 0);
+    for (int j = 0; j < 50; ++j) {
+        ++ served[queue.pop()];
+    }
+    ASSERT_EQ(40, served[0]);
+    ASSERT_EQ(10, served[1]);
+
+    // Lane 1 is not starved.
+    while (!queue.empty()) {
+        ++ served[queue.pop()];
+    }
+    ASSERT_EQ(100, served[0]);
+    ASSERT_EQ(100, served[1]);
+}
+
+TEST(WeightedFairQueueTest, TestStrictPriority)
+{
+    WeightedFairQueue<int> queue({ 0, 16, 1 });
+    queue.push(2, 2);
+    queue.push(1, 1);
+    queue.push(0, 0);
+    queue.push(0, 3);
+
+    ASSERT_EQ(0, queue.pop());
+    ASSERT_EQ(3, queue.pop());
+    ASSERT_EQ(1, queue.pop());
+    ASSERT_EQ(2, queue.pop());
+}
+
+TEST(WeightedFairQueueTest, TestIdleLaneBuildsNoCredit)
+{
+    WeightedFairQueue<int> queue({ 1, 1 });
+
+    // Only lane 0 is busy for a while.
+    for (int j = 0; j < 10; ++j) {
+        queue.push(0, 0);
+        ASSERT_EQ(0, queue.pop());
+    }
+
+    // Then lane 1 is served next, and the lanes alternate instead of lane 1
+    // catching up.
+    for (int j = 0; j < 4; ++j) {
+        queue.push(0, 0);
+        queue.push(1, 1);
+    }
+    vector<int> order;
+    while (!queue.empty()) {
+        order.push_back(queue.pop());
+    }
+    ASSERT_EQ(vector<int>({ 1, 0, 1, 0, 1, 0, 1, 0 }), order);
+    ASSERT_EQ(0, queue.size(0));
+}
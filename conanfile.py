@@ -32,14 +32,18 @@ class BranchioConan(ConanFile):
 
     # ----- Package settings and options -----
     settings = "os", "compiler", "build_type", "arch"
-    options = {"shared": [True, False]}
-    default_options = {"shared": False}
+    options = {"shared": [True, False], "curl": [True, False]}
+    default_options = {"shared": False, "curl": False}
     generators = "cmake"
     exports_sources = "BranchIO"
 
     # ----- Package dependencies -----
     build_requires = "gtest/1.11.0"
 
+    def requirements(self):
+        if self.options.curl:
+            self.requires("libcurl/7.88.1")
+
     def validate(self):
         if self.settings.os != "Windows":
             raise ConanInvalidConfiguration("Windows required")
@@ -57,7 +61,7 @@ class BranchioConan(ConanFile):
         if self.should_configure:
             # conan build --configure
             build_shared_libs = self.options.shared
-            cmake.configure(build_dir=".", defs={'BUILD_SHARED_LIBS': build_shared_libs, 'CMAKE_BUILD_TYPE': self.settings.build_type})
+            cmake.configure(build_dir=".", defs={'BUILD_SHARED_LIBS': build_shared_libs, 'BRANCHIO_USE_CURL': bool(self.options.curl), 'CMAKE_BUILD_TYPE': self.settings.build_type})
         if self.should_build:
             # conan build --build
             # build everything for now
@@ -87,3 +91,5 @@ class BranchioConan(ConanFile):
             self.cpp_info.libs.extend(["kernel32", "advapi32"])
             if self.options.shared:
                 self.cpp_info.defines.append("BRANCHIO_DLL")
+        if self.options.curl:
+            self.cpp_info.defines.append("BRANCHIO_USE_CURL")